@@ -0,0 +1,509 @@
+#include "Analyzer.hpp"
+#include "CodeParser.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+// Micro and macro benchmarks of the native core
+//
+// Every benchmark runs over a generated corpus: typical Python, C, C++ and
+// JavaScript code plus pathological shapes (one very long line, deep
+// nesting), each at sizes from 1 KB to 100 MB. Reported per run: ns/byte,
+// throughput, heap allocations per call and, per benchmark and input, the
+// scaling exponent of time against size (1.0 is linear).
+//
+// usage: bench_code_educator [--max-size N[K|M]] [--min-time SECONDS]
+//                            [--filter TEXT] [--json FILE] [--quick]
+
+// every operator new in the process is counted
+namespace {
+std::atomic<uint64_t> allocationCount{0};
+}  // namespace
+
+void* operator new(size_t size) {
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size == 0 ? 1 : size)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+	std::free(p);
+}
+
+namespace {
+
+using namespace code_educator;
+using Clock = std::chrono::steady_clock;
+
+const size_t SIZES[] = {
+	1024, 10 * 1024, 100 * 1024, 1024 * 1024, 10 * 1024 * 1024, 100 * 1024 * 1024
+};
+
+struct Options {
+	size_t maxSize = 100 * 1024 * 1024;
+	double minTime = 0.2;  // seconds spent per run, at least one call
+	std::string filter;    // run only benchmarks or inputs containing this
+	std::string jsonPath;
+};
+
+// one input shape: code generated unit by unit up to a size
+struct InputKind {
+	const char* name;       // language/shape
+	const char* fileName;   // extension hint for the detector
+	std::string header;     // written once
+	std::function<std::string(size_t)> unit;  // the i-th repeated piece
+	std::string footer;     // written once, after the last unit
+};
+
+std::string str(size_t i) {
+	return std::to_string(i);
+}
+
+std::vector<InputKind> inputKinds() {
+	std::vector<InputKind> kinds;
+
+	kinds.push_back({"python/typical", "bench.py",
+		"import os\nfrom collections import defaultdict\n\n",
+		[](size_t i) {
+			std::string n = str(i);
+			return "# count the values of batch " + n + "\n"
+				"def process_" + n + "(items, limit=" + n + "):\n"
+				"    \"\"\"Sum the items below the limit.\"\"\"\n"
+				"    total = 0\n"
+				"    for item in items:\n"
+				"        if item < limit and item % 2 == 0:\n"
+				"            total += item\n"
+				"        elif item is None:\n"
+				"            continue\n"
+				"    return total\n\n"
+				"class Worker" + n + ":\n"
+				"    def __init__(self, name='worker_" + n + "'):\n"
+				"        self.name = name\n\n";
+		}, ""});
+
+	kinds.push_back({"c/typical", "bench.c",
+		"#include <stdio.h>\n#include <stdlib.h>\n\n",
+		[](size_t i) {
+			std::string n = str(i);
+			return "/* sum the even values of buffer " + n + " */\n"
+				"int process_" + n + "(const int *items, int count) {\n"
+				"    int total = 0;\n"
+				"    for (int i = 0; i < count; i++) {\n"
+				"        if (items[i] % 2 == 0) {\n"
+				"            total += items[i];\n"
+				"        }\n"
+				"    }\n"
+				"    printf(\"batch " + n + ": %d\\n\", total);\n"
+				"    return total;\n"
+				"}\n\n"
+				"struct record_" + n + " {\n"
+				"    char *name;\n"
+				"    int size;\n"
+				"};\n\n";
+		}, ""});
+
+	kinds.push_back({"cpp/typical", "bench.cpp",
+		"#include <iostream>\n#include <vector>\n\nnamespace bench {\n\n",
+		[](size_t i) {
+			std::string n = str(i);
+			return "// collects the even values of batch " + n + "\n"
+				"class Worker" + n + " {\n"
+				"public:\n"
+				"    explicit Worker" + n + "(std::vector<int> items) : items_(std::move(items)) {}\n"
+				"    int process() const {\n"
+				"        int total = 0;\n"
+				"        for (int item : items_) {\n"
+				"            if (item % 2 == 0) {\n"
+				"                total += item;\n"
+				"            }\n"
+				"        }\n"
+				"        std::cout << \"batch " + n + ": \" << total << std::endl;\n"
+				"        return total;\n"
+				"    }\n"
+				"private:\n"
+				"    std::vector<int> items_;\n"
+				"};\n\n";
+		}, "}  // namespace bench\n"});
+
+	kinds.push_back({"javascript/typical", "bench.js",
+		"import { readFile } from 'fs';\nconst path = require('path');\n\n",
+		[](size_t i) {
+			std::string n = str(i);
+			return "// sum the even values of batch " + n + "\n"
+				"function process" + n + "(items, limit = " + n + ") {\n"
+				"    let total = 0;\n"
+				"    for (const item of items) {\n"
+				"        if (item < limit && item % 2 === 0) {\n"
+				"            total += item;\n"
+				"        }\n"
+				"    }\n"
+				"    console.log(`batch " + n + ": ${total}`);\n"
+				"    return total;\n"
+				"}\n\n"
+				"const double" + n + " = (x) => x * 2;\n\n";
+		}, ""});
+
+	// pathological: the whole input on one line
+	kinds.push_back({"python/long_line", "bench.py",
+		"values = [",
+		[](size_t i) { return "value_" + str(i) + " + " + str(i) + ", "; },
+		"0]\n"});
+	kinds.push_back({"javascript/long_line", "bench.js",
+		"const values = [",
+		[](size_t i) { return "{id: " + str(i) + ", name: 'item_" + str(i) + "'}, "; },
+		"null];\n"});
+	kinds.push_back({"cpp/long_line", "bench.cpp",
+		"int table[] = {",
+		[](size_t i) { return str(i) + ", "; },
+		"0};\n"});
+
+	// pathological: blocks nested 100 deep
+	const int depth = 100;
+	kinds.push_back({"python/deep_nesting", "bench.py", "",
+		[](size_t i) {
+			std::string out = "def nested_" + str(i) + "(x):\n";
+			for (int d = 1; d <= depth; ++d) {
+				out += std::string(4 * d, ' ') + "if x > " + str(d) + ":\n";
+			}
+			out += std::string(4 * (depth + 1), ' ') + "return x\n\n";
+			return out;
+		}, ""});
+	kinds.push_back({"c/deep_nesting", "bench.c", "",
+		[](size_t i) {
+			std::string out = "int nested_" + str(i) + "(int x) {\n";
+			for (int d = 1; d <= depth; ++d) {
+				out += "if (x > " + str(d) + ") {\n";
+			}
+			out += "return x;\n";
+			out += std::string(depth, '}') + "\nreturn 0;\n}\n\n";
+			return out;
+		}, ""});
+	kinds.push_back({"javascript/deep_nesting", "bench.js", "",
+		[](size_t i) {
+			std::string out = "function nested" + str(i) + "(x) {\n";
+			for (int d = 1; d <= depth; ++d) {
+				out += "while (x > " + str(d) + ") {\n";
+			}
+			out += "x--;\n";
+			out += std::string(depth, '}') + "\nreturn x;\n}\n\n";
+			return out;
+		}, ""});
+
+	return kinds;
+}
+
+// code of the given kind, as close to size bytes as whole units allow
+std::string generate(const InputKind& kind, size_t size) {
+	std::string code = kind.header;
+	code.reserve(size + 4096);
+	for (size_t i = 0;; ++i) {
+		std::string unit = kind.unit(i);
+		if (i > 0 && code.size() + unit.size() + kind.footer.size() > size) {
+			break;
+		}
+		code += unit;
+	}
+	code += kind.footer;
+	return code;
+}
+
+struct Benchmark {
+	std::string name;
+	std::function<void(std::string_view, const char*)> run;  // code, file name
+};
+
+std::vector<Benchmark> benchmarks(const Analyzer& analyzer) {
+	std::vector<Benchmark> out;
+	const CodeParser& parser = analyzer.codeParser();
+
+	out.push_back({"detect_language", [&parser](std::string_view code, const char* fileName) {
+		parser.guessLanguage(code, fileName);
+	}});
+	out.push_back({"parse", [&parser](std::string_view code, const char* fileName) {
+		TokenStream stream;
+		parser.parse(code, stream, fileName);
+	}});
+
+	// the Analyzer's metric passes are private: each is reached through a
+	// single-metric mask
+	struct MetricBench {
+		const char* name;
+		uint32_t mask;
+	};
+	const MetricBench metrics[] = {
+		{"metric/lines", METRIC_LINES},
+		{"metric/comments", METRIC_COMMENTS},
+		{"metric/nesting", METRIC_NESTING},
+		{"metric/cyclomatic", METRIC_CYCLOMATIC},
+		{"metric/tokens", METRIC_TOKENS},
+		{"metric/issues", METRIC_ISSUES},
+		{"metric/suggestions", METRIC_SUGGESTIONS},
+		{"metric/structure", METRIC_STRUCTURE}
+	};
+	for (const MetricBench& metric : metrics) {
+		uint32_t mask = metric.mask;
+		out.push_back({metric.name, [&analyzer, mask](std::string_view code, const char* fileName) {
+			AnalysisOptions options;
+			options.metrics = mask;
+			options.fileName = fileName;
+			analyzer.analyze(code, options);
+		}});
+	}
+
+	out.push_back({"analyze", [&analyzer](std::string_view code, const char* fileName) {
+		AnalysisOptions options;
+		options.fileName = fileName;
+		analyzer.analyze(code, options);
+	}});
+	out.push_back({"report", [&analyzer](std::string_view code, const char* fileName) {
+		AnalysisOptions options;
+		options.fileName = fileName;
+		analyzer.report(code, options);
+	}});
+	return out;
+}
+
+struct Sample {
+	std::string benchmark;
+	std::string input;
+	size_t bytes = 0;
+	uint64_t iterations = 0;
+	double nsPerByte = 0.0;     // fastest call
+	double meanNsPerByte = 0.0;
+	double allocationsPerCall = 0.0;
+};
+
+Sample measure(const Benchmark& benchmark, const InputKind& kind, const std::string& code, double minTime) {
+	Sample sample;
+	sample.benchmark = benchmark.name;
+	sample.input = kind.name;
+	sample.bytes = code.size();
+
+	// warm-up (first-use tables), then one call to count allocations
+	benchmark.run(code, kind.fileName);
+	uint64_t before = allocationCount.load(std::memory_order_relaxed);
+	benchmark.run(code, kind.fileName);
+	sample.allocationsPerCall = static_cast<double>(allocationCount.load(std::memory_order_relaxed) - before);
+
+	double best = 0.0;
+	double total = 0.0;
+	while (sample.iterations == 0 || total < minTime) {
+		Clock::time_point start = Clock::now();
+		benchmark.run(code, kind.fileName);
+		double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		best = sample.iterations == 0 ? seconds : std::min(best, seconds);
+		total += seconds;
+		sample.iterations++;
+	}
+	double bytes = static_cast<double>(std::max<size_t>(sample.bytes, 1));
+	sample.nsPerByte = best * 1e9 / bytes;
+	sample.meanNsPerByte = total / sample.iterations * 1e9 / bytes;
+	return sample;
+}
+
+// least-squares slope of log(time) against log(size): 1.0 is linear
+double scalingExponent(const std::vector<const Sample*>& samples) {
+	if (samples.size() < 2) {
+		return 0.0;
+	}
+	double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+	for (const Sample* sample : samples) {
+		double x = std::log(static_cast<double>(sample->bytes));
+		double y = std::log(sample->nsPerByte * sample->bytes);
+		sx += x;
+		sy += y;
+		sxx += x * x;
+		sxy += x * y;
+	}
+	double n = static_cast<double>(samples.size());
+	double denominator = n * sxx - sx * sx;
+	return denominator == 0.0 ? 0.0 : (n * sxy - sx * sy) / denominator;
+}
+
+size_t parseSize(const std::string& text) {
+	size_t multiplier = 1;
+	std::string digits = text;
+	if (!digits.empty() && (digits.back() == 'K' || digits.back() == 'k')) {
+		multiplier = 1024;
+		digits.pop_back();
+	}
+	else if (!digits.empty() && (digits.back() == 'M' || digits.back() == 'm')) {
+		multiplier = 1024 * 1024;
+		digits.pop_back();
+	}
+	return static_cast<size_t>(std::stoull(digits)) * multiplier;
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--max-size" && hasValue) {
+			options.maxSize = parseSize(argv[++i]);
+		}
+		else if (arg == "--min-time" && hasValue) {
+			options.minTime = std::stod(argv[++i]);
+		}
+		else if (arg == "--filter" && hasValue) {
+			options.filter = argv[++i];
+		}
+		else if (arg == "--json" && hasValue) {
+			options.jsonPath = argv[++i];
+		}
+		else if (arg == "--quick") {
+			options.maxSize = 1024 * 1024;
+			options.minTime = 0.05;
+		}
+		else {
+			std::cerr << "usage: " << argv[0]
+				<< " [--max-size N[K|M]] [--min-time SECONDS] [--filter TEXT] [--json FILE] [--quick]" << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+std::string jsonString(const std::string& text) {
+	std::string out = "\"";
+	for (char c : text) {
+		if (c == '"' || c == '\\') {
+			out += '\\';
+		}
+		out += c;
+	}
+	return out + "\"";
+}
+
+// one result per line so two runs diff cleanly
+void writeJson(const std::string& path, const Options& options, const std::vector<Sample>& samples,
+		const std::vector<std::pair<std::string, double>>& scaling) {
+	std::ofstream out(path);
+	char buffer[512];
+	out << "{\n";
+	out << "  \"analyzer_version\": " << ANALYZER_VERSION << ",\n";
+	out << "  \"max_size\": " << options.maxSize << ",\n";
+	out << "  \"results\": [\n";
+	for (size_t i = 0; i < samples.size(); ++i) {
+		const Sample& s = samples[i];
+		std::snprintf(buffer, sizeof(buffer),
+			"    {\"benchmark\": %s, \"input\": %s, \"bytes\": %zu, \"iterations\": %llu, "
+			"\"ns_per_byte\": %.4f, \"mean_ns_per_byte\": %.4f, \"mb_per_s\": %.2f, \"allocations_per_call\": %.0f}%s\n",
+			jsonString(s.benchmark).c_str(), jsonString(s.input).c_str(), s.bytes,
+			static_cast<unsigned long long>(s.iterations), s.nsPerByte, s.meanNsPerByte,
+			1e3 / std::max(s.nsPerByte, 1e-9), s.allocationsPerCall, i + 1 < samples.size() ? "," : "");
+		out << buffer;
+	}
+	out << "  ],\n";
+	out << "  \"scaling\": [\n";
+	for (size_t i = 0; i < scaling.size(); ++i) {
+		std::snprintf(buffer, sizeof(buffer), "    {\"run\": %s, \"exponent\": %.3f}%s\n",
+			jsonString(scaling[i].first).c_str(), scaling[i].second, i + 1 < scaling.size() ? "," : "");
+		out << buffer;
+	}
+	out << "  ]\n}\n";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		return 2;
+	}
+
+	Analyzer analyzer;
+	std::vector<Benchmark> benches = benchmarks(analyzer);
+	std::vector<InputKind> kinds = inputKinds();
+	std::vector<Sample> samples;
+
+	std::printf("%-20s %-26s %12s %8s %10s %10s %12s\n",
+		"benchmark", "input", "bytes", "iters", "ns/byte", "MB/s", "allocs/call");
+	for (const InputKind& kind : kinds) {
+		size_t lastBytes = 0;
+		for (size_t size : SIZES) {
+			if (size > options.maxSize) {
+				break;
+			}
+			std::vector<const Benchmark*> selected;
+			for (const Benchmark& benchmark : benches) {
+				std::string run = benchmark.name + " " + kind.name;
+				if (options.filter.empty() || run.find(options.filter) != std::string::npos) {
+					selected.push_back(&benchmark);
+				}
+			}
+			if (selected.empty()) {
+				break;
+			}
+			// generated once per size, for every benchmark; sizes below one
+			// unit give the same input again
+			std::string code = generate(kind, size);
+			if (code.size() == lastBytes) {
+				continue;
+			}
+			lastBytes = code.size();
+			for (const Benchmark* benchmark : selected) {
+				Sample sample = measure(*benchmark, kind, code, options.minTime);
+				std::printf("%-20s %-26s %12zu %8llu %10.3f %10.1f %12.0f\n",
+					sample.benchmark.c_str(), sample.input.c_str(), sample.bytes,
+					static_cast<unsigned long long>(sample.iterations), sample.nsPerByte,
+					1e3 / std::max(sample.nsPerByte, 1e-9), sample.allocationsPerCall);
+				std::fflush(stdout);
+				samples.push_back(std::move(sample));
+			}
+		}
+	}
+
+	// scaling curve per benchmark and input, from 100 KB up (smaller inputs
+	// are dominated by fixed costs)
+	std::vector<std::pair<std::string, double>> scaling;
+	std::printf("\n%-20s %-26s %10s\n", "benchmark", "input", "exponent");
+	for (const Benchmark& benchmark : benches) {
+		for (const InputKind& kind : kinds) {
+			std::vector<const Sample*> curve;
+			for (const Sample& sample : samples) {
+				if (sample.benchmark == benchmark.name && sample.input == kind.name && sample.bytes >= 100 * 1000) {
+					curve.push_back(&sample);
+				}
+			}
+			if (curve.size() < 2) {
+				continue;
+			}
+			double exponent = scalingExponent(curve);
+			std::printf("%-20s %-26s %10.3f\n", benchmark.name.c_str(), kind.name, exponent);
+			scaling.emplace_back(benchmark.name + " " + kind.name, exponent);
+		}
+	}
+
+	if (!options.jsonPath.empty()) {
+		writeJson(options.jsonPath, options, samples, scaling);
+	}
+	return 0;
+}
@@ -2,9 +2,402 @@
 #include <pybind11/stl.h>
 #include "CodeParser.hpp"
 #include "Analyzer.hpp"
+#include "ThreadPool.hpp"
+#include "ResultCache.hpp"
+#include "RepositoryScanner.hpp"
+#include "AnalysisSession.hpp"
+#include "AnalyzerStream.hpp"
+#include "ByteScan.hpp"
+#include "CoreStats.hpp"
+#include "DiskCache.hpp"
+#include "MappedFile.hpp"
+#include "ResultJson.hpp"
+#include "ResultSnapshot.hpp"
+#include "SharedCache.hpp"
+#include "Trace.hpp"
+#include "TokenSketch.hpp"
 
 namespace py = pybind11;
 
+// analysis runs without the GIL so other Python threads keep going
+using release_gil = py::call_guard<py::gil_scoped_release>;
+
+// analyze_json() output buffers larger than this are not kept for the next call
+constexpr size_t JSON_BUFFER_KEEP_BYTES = 4 * 1024 * 1024;
+
+// Source code handed over from Python without copying: the UTF-8 form of a
+// str, the contents of bytes, or any C-contiguous byte buffer (bytearray,
+// memoryview, mmap). The view stays valid until the call returns.
+struct SourceText {
+    std::string_view view;
+};
+
+// a list of sources for the batch entry points
+struct SourceList {
+    std::vector<std::string_view> views;
+};
+
+namespace pybind11 { namespace detail {
+
+// Buffers acquired while loading arguments, released once the call is over
+// (argument casters are destroyed with the GIL held).
+class SourceBuffers {
+public:
+    SourceBuffers() = default;
+    SourceBuffers(const SourceBuffers&) = delete;
+    SourceBuffers& operator=(const SourceBuffers&) = delete;
+    SourceBuffers(SourceBuffers&& other) noexcept : buffers_(std::move(other.buffers_)) {
+        other.buffers_.clear();
+    }
+    ~SourceBuffers() {
+        for (auto& buffer : buffers_) {
+            PyBuffer_Release(&buffer);
+        }
+    }
+
+    bool load(handle src, std::string_view& view) {
+        PyObject* obj = src.ptr();
+        if (PyUnicode_Check(obj)) {
+            // cached on the str object; no copy at all for ASCII text
+            Py_ssize_t size = 0;
+            const char* data = PyUnicode_AsUTF8AndSize(obj, &size);
+            if (data == nullptr) {
+                PyErr_Clear();
+                return false;
+            }
+            view = std::string_view(data, static_cast<size_t>(size));
+            return true;
+        }
+        if (PyBytes_Check(obj)) {
+            view = std::string_view(PyBytes_AS_STRING(obj), static_cast<size_t>(PyBytes_GET_SIZE(obj)));
+            return true;
+        }
+        if (!PyObject_CheckBuffer(obj)) {
+            return false;
+        }
+        Py_buffer buffer;
+        if (PyObject_GetBuffer(obj, &buffer, PyBUF_C_CONTIGUOUS) != 0) {
+            PyErr_Clear();
+            return false;
+        }
+        if (buffer.itemsize != 1) {
+            PyBuffer_Release(&buffer);
+            return false;
+        }
+        view = std::string_view(static_cast<const char*>(buffer.buf), static_cast<size_t>(buffer.len));
+        buffers_.push_back(buffer);
+        return true;
+    }
+
+private:
+    std::vector<Py_buffer> buffers_;
+};
+
+template <> struct type_caster<SourceText> {
+public:
+    PYBIND11_TYPE_CASTER(SourceText, const_name("str | bytes | Buffer"));
+
+    bool load(handle src, bool) {
+        return buffers_.load(src, value.view);
+    }
+
+private:
+    SourceBuffers buffers_;
+};
+
+template <> struct type_caster<SourceList> {
+public:
+    PYBIND11_TYPE_CASTER(SourceList, const_name("Sequence[str | bytes | Buffer]"));
+
+    bool load(handle src, bool) {
+        if (!isinstance<sequence>(src) || isinstance<str>(src) || isinstance<bytes>(src)) {
+            return false;
+        }
+        sequence items = reinterpret_borrow<sequence>(src);
+        value.views.resize(items.size());
+        for (size_t i = 0; i < value.views.size(); ++i) {
+            // the sequence keeps every item alive for the duration of the call
+            if (!buffers_.load(items[i], value.views[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    SourceBuffers buffers_;
+};
+
+}}  // namespace pybind11::detail
+
+// Feed every item of a Python iterable (bytes, str or byte buffers) to a
+// stream. Only the current item is held; the GIL is released while it is
+// analyzed (the stream locks itself, so other threads may feed it meanwhile).
+static void feedChunks(code_educator::AnalyzerStream& stream, py::iterable chunks) {
+    for (py::handle chunk : chunks) {
+        py::detail::make_caster<SourceText> text;
+        if (!text.load(chunk, true)) {
+            throw py::type_error("stream chunks must be str, bytes or byte buffers");
+        }
+        py::gil_scoped_release release;
+        stream.feed(py::detail::cast_op<SourceText&>(text).view);
+    }
+}
+
+// Run fn without the GIL, then convert its result to a Python object, timed
+// as the binding stage.
+template <typename Fn>
+static py::object convertResult(Fn&& fn) {
+    auto value = [&]() {
+        py::gil_scoped_release release;
+        return fn();
+    }();
+    code_educator::StageTimer timer(code_educator::Stage::Binding);
+    return py::cast(std::move(value));
+}
+
+// snapshot of the core stage timings and counters as plain Python values
+static py::dict coreStatsDict(const code_educator::CoreStats& stats) {
+    py::dict stages;
+    for (size_t s = 0; s < static_cast<size_t>(code_educator::Stage::COUNT); ++s) {
+        const code_educator::StageStats& stage = stats.stages[s];
+        py::list buckets;  // (upper bound ns, count) of the non-empty buckets
+        for (size_t b = 0; b < code_educator::HISTOGRAM_BUCKETS; ++b) {
+            if (stage.buckets[b] != 0) {
+                buckets.append(py::make_tuple(code_educator::histogramUpperBound(b), stage.buckets[b]));
+            }
+        }
+        py::dict d;
+        d["count"] = stage.count;
+        d["total_ns"] = stage.totalNs;
+        d["bytes"] = stage.bytes;
+        d["p50_ns"] = stage.quantileNs(0.50);
+        d["p90_ns"] = stage.quantileNs(0.90);
+        d["p99_ns"] = stage.quantileNs(0.99);
+        d["buckets"] = buckets;
+        stages[code_educator::stageName(static_cast<code_educator::Stage>(s))] = d;
+    }
+    py::dict counters;
+    for (size_t c = 0; c < static_cast<size_t>(code_educator::Counter::COUNT); ++c) {
+        counters[code_educator::counterName(static_cast<code_educator::Counter>(c))] = stats.counters[c];
+    }
+    py::dict out;
+    out["enabled"] = stats.enabled;
+    out["stages"] = stages;
+    out["counters"] = counters;
+    return out;
+}
+
+// One analyze_async() call queued on the native pool. It keeps the Python
+// objects it uses alive and is completed and freed with the GIL held.
+struct AsyncAnalysis {
+    py::object analyzer;
+    py::object source;
+    py::detail::SourceBuffers buffers;
+    std::string_view code;
+    code_educator::AnalysisOptions options;
+    bool asJson = false;
+    bool cached = false;
+    py::object loop;
+    py::object future;
+};
+
+// runs on the event loop thread: the future may have been cancelled since
+static void completeFuture(py::object future, py::object value, py::object error) {
+    if (future.attr("done")().cast<bool>()) {
+        return;
+    }
+    if (!error.is_none()) {
+        future.attr("set_exception")(error);
+    }
+    else {
+        future.attr("set_result")(value);
+    }
+}
+
+// Complete the future of call with its report (or error), on a pool thread
+// holding the GIL. Takes ownership of call.
+// References are held raw: a thread that takes the GIL back while the
+// interpreter finalizes is made to exit by unwinding its stack without the
+// GIL, so no Python object may be released by a destructor on the way.
+static void deliverAsyncResult(AsyncAnalysis* call, code_educator::AnalysisReport& report, const std::string& json,
+    bool failed, const std::string& message) {
+    PyObject* value = nullptr;
+    PyObject* error = nullptr;
+    try {
+        if (failed) {
+            error = PyObject_CallFunction(PyExc_RuntimeError, "s", message.c_str());
+        }
+        else if (call->asJson) {
+            value = PyBytes_FromStringAndSize(json.data(), static_cast<Py_ssize_t>(json.size()));
+        }
+        else {
+            code_educator::StageTimer timer(code_educator::Stage::Binding);
+            value = py::cast(std::move(report)).release().ptr();
+        }
+    }
+    catch (const std::exception& e) {
+        // conversion failed (cast_error, bad_alloc, a Python error): the
+        // awaiting coroutine still has to be woken up
+        std::string text = std::string("analysis result conversion failed: ") + e.what();
+        error = PyObject_CallFunction(PyExc_RuntimeError, "s", text.c_str());
+    }
+    if (value == nullptr && error == nullptr) {
+        // PyBytes / RuntimeError construction failed: report that error
+        PyObject* type = nullptr;
+        PyObject* traceback = nullptr;
+        PyErr_Fetch(&type, &error, &traceback);
+        PyErr_NormalizeException(&type, &error, &traceback);
+        Py_XDECREF(type);
+        Py_XDECREF(traceback);
+    }
+
+    PyObject* complete = nullptr;
+    try {
+        complete = py::cpp_function(&completeFuture).release().ptr();
+    }
+    catch (const std::exception&) {
+        PyErr_Clear();
+    }
+    PyObject* scheduled = complete == nullptr ? nullptr :
+        PyObject_CallMethod(call->loop.ptr(), "call_soon_threadsafe", "OOOO", complete, call->future.ptr(),
+            value != nullptr ? value : Py_None, error != nullptr ? error : Py_None);
+    if (scheduled == nullptr) {
+        // a closed loop has nobody waiting for the result; anything else
+        // leaves a coroutine hanging, so say why
+        PyObject* type = nullptr;
+        PyObject* reason = nullptr;
+        PyObject* traceback = nullptr;
+        PyErr_Fetch(&type, &reason, &traceback);
+        PyObject* closed = PyObject_CallMethod(call->loop.ptr(), "is_closed", nullptr);
+        PyErr_Clear();
+        if (closed == Py_True) {
+            Py_XDECREF(type);
+            Py_XDECREF(reason);
+            Py_XDECREF(traceback);
+        }
+        else {
+            PyErr_Restore(type, reason, traceback);
+            PyErr_WriteUnraisable(call->future.ptr());
+        }
+        Py_XDECREF(closed);
+    }
+    Py_XDECREF(scheduled);
+    Py_XDECREF(complete);
+    Py_XDECREF(value);
+    Py_XDECREF(error);
+    delete call;
+}
+
+static bool interpreterFinalizing() {
+#if PY_VERSION_HEX >= 0x030D0000
+    return Py_IsFinalizing() != 0;
+#else
+    return _Py_IsFinalizing() != 0;
+#endif
+}
+
+// Analyze on a pool thread, then hand the result to the loop through
+// call_soon_threadsafe (which wakes it through its self-pipe).
+static void runAsyncAnalysis(AsyncAnalysis* call, const code_educator::Analyzer* analyzer) {
+    code_educator::AnalysisReport report;
+    std::string json;
+    bool failed = false;
+    std::string message;
+    try {
+        report = analyzer->report(call->code, call->options);
+        if (call->asJson) {
+            code_educator::StageTimer timer(code_educator::Stage::Binding);
+            code_educator::ReportJsonOptions jsonOptions;
+            jsonOptions.tokenFrequency = call->options.countsTokens();
+            jsonOptions.cached = call->cached;
+            code_educator::writeReportJson(report, json, jsonOptions);
+        }
+    }
+    catch (const std::exception& e) {
+        failed = true;
+        message = e.what();
+    }
+    catch (...) {
+        failed = true;
+        message = "analysis failed";
+    }
+
+    if (!Py_IsInitialized() || interpreterFinalizing()) {
+        return;  // the interpreter is going away: nothing to complete, nothing can be freed
+    }
+    // no gil_scoped_acquire: its release would run during the unwinding
+    // described at deliverAsyncResult()
+    PyGILState_STATE gil = PyGILState_Ensure();
+    deliverAsyncResult(call, report, json, failed, message);
+    PyGILState_Release(gil);
+}
+
+// Queue report() on the native pool and return an asyncio future of loop
+// (the running loop by default). Cancelling the future cancels the analysis.
+static py::object analyzeAsync(py::object self, py::object source, const code_educator::AnalysisOptions& options,
+    bool asJson, bool cached, py::object loop) {
+    auto call = std::make_unique<AsyncAnalysis>();
+    if (!call->buffers.load(source, call->code)) {
+        throw py::type_error("analyze_async() expects str, bytes or a byte buffer");
+    }
+    if (loop.is_none()) {
+        loop = py::module_::import("asyncio").attr("get_running_loop")();
+    }
+    call->analyzer = self;
+    call->source = source;
+    call->options = options;
+    if (!call->options.budget.cancel) {
+        call->options.budget.cancel = std::make_shared<code_educator::CancelToken>();
+    }
+    call->asJson = asJson;
+    call->cached = cached;
+    call->loop = loop;
+    call->future = loop.attr("create_future")();
+
+    std::shared_ptr<code_educator::CancelToken> token = call->options.budget.cancel;
+    call->future.attr("add_done_callback")(py::cpp_function([token](py::object future) {
+        if (future.attr("cancelled")().cast<bool>()) {
+            token->cancel();
+        }
+    }));
+
+    py::object future = call->future;
+    const code_educator::Analyzer* analyzer = self.cast<const code_educator::Analyzer*>();
+    code_educator::ThreadPool::shared().submit([call = call.release(), analyzer]() {
+        runAsyncAnalysis(call, analyzer);
+    });
+    return future;
+}
+
+// A result snapshot read in place from a Python buffer (bytes, mmap, ...) or
+// a memory-mapped file, kept alive as long as the Python object.
+struct SnapshotHandle {
+    py::object owner;
+    py::detail::SourceBuffers buffers;
+    std::unique_ptr<code_educator::MappedFile> file;
+    std::unique_ptr<code_educator::SnapshotView> view;
+};
+
+static py::list snapshotStrings(const code_educator::SnapshotView::Strings& strings) {
+    py::list out;
+    for (std::string_view text : strings) {
+        out.append(py::str(text.data(), text.size()));
+    }
+    return out;
+}
+
+static py::dict snapshotPairs(const code_educator::SnapshotView::Strings& pairs) {
+    py::dict out;
+    for (auto it = pairs.begin(); it != pairs.end(); ++it) {
+        std::string_view key = *it;
+        ++it;
+        std::string_view value = *it;
+        out[py::str(key.data(), key.size())] = py::str(value.data(), value.size());
+    }
+    return out;
+}
+
 PYBIND11_MODULE(code_educator_core, m) {
     m.doc() = "Code Educator C++ core module";
 
@@ -27,27 +420,85 @@ PYBIND11_MODULE(code_educator_core, m) {
             }
         );
 
+    // LanguageGuess 바인딩
+    py::class_<code_educator::LanguageGuess>(m, "LanguageGuess")
+        .def_property_readonly("language",
+            [](const code_educator::LanguageGuess& guess) { return std::string(code_educator::languageName(guess.language)); })
+        .def_readonly("confidence", &code_educator::LanguageGuess::confidence)
+        .def_readonly("bytes_scanned", &code_educator::LanguageGuess::bytesScanned)
+        .def("__repr__",
+            [](const code_educator::LanguageGuess& guess) {
+                return std::string("<LanguageGuess language='") + code_educator::languageName(guess.language) +
+                       "' confidence=" + std::to_string(guess.confidence) + ">";
+            });
+
+    // LanguageDetector
+    py::class_<code_educator::LanguageDetector>(m, "LanguageDetector")
+        .def(py::init<size_t>(), py::arg("prefix_bytes") = code_educator::LanguageDetector::DEFAULT_PREFIX_BYTES)
+        .def("detect",
+             [](const code_educator::LanguageDetector& detector, SourceText code, const std::string& fileName) {
+                 return detector.detect(code.view, fileName);
+             },
+             "Score language features over a bounded prefix of code",
+             py::arg("code"), py::arg("file_name") = "", release_gil())
+        .def_static("extension_hint",
+             [](const std::string& fileName) {
+                 return std::string(code_educator::languageName(code_educator::LanguageDetector::extensionHint(fileName)));
+             },
+             "Language a file extension stands for ('unknown' when ambiguous)", py::arg("file_name"))
+        .def_property_readonly("prefix_bytes", &code_educator::LanguageDetector::prefixBytes);
+
     // CodeParser
     py::class_<code_educator::CodeParser>(m, "CodeParser")
         .def(py::init<>())
-        .def("parse", &code_educator::CodeParser::parse,
+        .def("parse",
+             [](const code_educator::CodeParser& parser, SourceText code) {
+                 return convertResult([&]() { return parser.parse(code.view); });
+             },
              "Parse code and return the code structure",
              py::arg("code"))
-        .def("detect_language", &code_educator::CodeParser::detectLanguage,
-             "Detect programming language of code",
-             py::arg("code"))
-        .def("calculate_complexity", &code_educator::CodeParser::calculateComplexity,
+        .def("parse_batch",
+             [](const code_educator::CodeParser& parser, SourceList codes, size_t threads) {
+                 return convertResult([&]() { return parser.parseBatch(codes.views, threads); });
+             },
+             "Parse many sources in parallel on the native thread pool",
+             py::arg("codes"), py::arg("threads") = 0)
+        .def("detect_language",
+             [](const code_educator::CodeParser& parser, SourceText code, const std::string& fileName) {
+                 return parser.detectLanguage(code.view, fileName);
+             },
+             "Detect programming language of code (file_name: its extension hints the language)",
+             py::arg("code"), py::arg("file_name") = "", release_gil())
+        .def("guess_language",
+             [](const code_educator::CodeParser& parser, SourceText code, const std::string& fileName) {
+                 return parser.guessLanguage(code.view, fileName);
+             },
+             "detect_language() with its confidence",
+             py::arg("code"), py::arg("file_name") = "", release_gil())
+        .def("calculate_complexity",
+             [](const code_educator::CodeParser& parser, SourceText code, const std::string& language) {
+                 return parser.calculateComplexity(code.view, language);
+             },
              "Calculate code complexity",
-             py::arg("code"), py::arg("language"))
-        .def("extract_imports", &code_educator::CodeParser::extractImports,
+             py::arg("code"), py::arg("language"), release_gil())
+        .def("extract_imports",
+             [](const code_educator::CodeParser& parser, SourceText code, const std::string& language) {
+                 return parser.extractImports(code.view, language);
+             },
              "Extract import statements from code",
-             py::arg("code"), py::arg("language"))
-        .def("extract_functions", &code_educator::CodeParser::extractFunctions,
+             py::arg("code"), py::arg("language"), release_gil())
+        .def("extract_functions",
+             [](const code_educator::CodeParser& parser, SourceText code, const std::string& language) {
+                 return parser.extractFunctions(code.view, language);
+             },
              "Extract function definitions from code",
-             py::arg("code"), py::arg("language"))
-        .def("extract_classes", &code_educator::CodeParser::extractClasses,
+             py::arg("code"), py::arg("language"), release_gil())
+        .def("extract_classes",
+             [](const code_educator::CodeParser& parser, SourceText code, const std::string& language) {
+                 return parser.extractClasses(code.view, language);
+             },
              "Extract class definitions from code",
-             py::arg("code"), py::arg("language"));
+             py::arg("code"), py::arg("language"), release_gil());
 
     // AnalysisResult 바인딩
     py::class_<code_educator::AnalysisResult>(m, "AnalysisResult")
@@ -61,6 +512,9 @@ PYBIND11_MODULE(code_educator_core, m) {
         .def_readwrite("potential_issues", &code_educator::AnalysisResult::potentialIssues)
         .def_readwrite("suggestions", &code_educator::AnalysisResult::suggestions)
         .def_readwrite("metadata", &code_educator::AnalysisResult::metadata)
+        .def_readwrite("truncated", &code_educator::AnalysisResult::truncated)
+        .def_readwrite("truncated_by", &code_educator::AnalysisResult::truncatedBy)
+        .def_readwrite("bytes_analyzed", &code_educator::AnalysisResult::bytesAnalyzed)
         .def("__repr__",
             [](const code_educator::AnalysisResult &ar) {
                 return "<AnalysisResult lines=" + std::to_string(ar.lineCount) +
@@ -69,36 +523,595 @@ PYBIND11_MODULE(code_educator_core, m) {
                        " nesting=" + std::to_string(ar.nestingLength) +
                        " complexity=" + std::to_string(ar.cyclomaticComplexity) +
                        " issues=" + std::to_string(ar.potentialIssues.size()) +
-                       " suggestions=" + std::to_string(ar.suggestions.size()) + ">";
+                       " suggestions=" + std::to_string(ar.suggestions.size()) +
+                       (ar.truncated ? " truncated=" + ar.truncatedBy : std::string()) + ">";
             }
         );
 
+    // AnalysisReport 바인딩
+    py::class_<code_educator::AnalysisReport>(m, "AnalysisReport")
+        .def(py::init<>())
+        .def_readwrite("structure", &code_educator::AnalysisReport::structure)
+        .def_readwrite("result", &code_educator::AnalysisReport::result)
+        .def_readwrite("quality_score", &code_educator::AnalysisReport::qualityScore)
+        .def_readwrite("cached", &code_educator::AnalysisReport::cached)
+        .def("__repr__",
+            [](const code_educator::AnalysisReport &r) {
+                return "<AnalysisReport language='" + r.structure.language +
+                       "' quality=" + std::to_string(r.qualityScore) +
+                       " cached=" + (r.cached ? "True" : "False") + ">";
+            }
+        );
+
+    // ResultCache
+    py::class_<code_educator::ResultCache, std::shared_ptr<code_educator::ResultCache>>(m, "ResultCache")
+        .def(py::init<size_t, size_t>(),
+             py::arg("max_bytes") = 64 * 1024 * 1024, py::arg("shards") = 16)
+        .def("stats",
+            [](const code_educator::ResultCache &cache) {
+                code_educator::CacheStats stats = cache.stats();
+                uint64_t lookups = stats.hits + stats.misses;
+                py::dict d;
+                d["hits"] = stats.hits;
+                d["misses"] = stats.misses;
+                d["insertions"] = stats.insertions;
+                d["evictions"] = stats.evictions;
+                d["entries"] = stats.entries;
+                d["bytes"] = stats.bytes;
+                d["capacity_bytes"] = stats.capacityBytes;
+                d["hit_rate"] = lookups ? static_cast<double>(stats.hits) / lookups : 0.0;
+                return d;
+            },
+            "Hit, miss and eviction counters and current size")
+        .def("clear", &code_educator::ResultCache::clear,
+             "Drop every cached report", release_gil())
+        .def_property_readonly("capacity", &code_educator::ResultCache::capacity);
+
+    // SharedCache (같은 이름의 공유 메모리 세그먼트에 붙은 프로세스끼리 공유)
+    py::class_<code_educator::SharedCache, std::shared_ptr<code_educator::SharedCache>>(m, "SharedCache")
+        .def(py::init<const std::string&, size_t, size_t>(),
+             "Attach to a shared memory segment, creating it with this size if it does not exist",
+             py::arg("name"), py::arg("max_bytes") = 64 * 1024 * 1024, py::arg("slots") = 0)
+        .def("stats",
+            [](const code_educator::SharedCache &cache) {
+                code_educator::SharedCacheStats stats = cache.stats();
+                uint64_t lookups = stats.hits + stats.misses;
+                py::dict d;
+                d["hits"] = stats.hits;
+                d["misses"] = stats.misses;
+                d["insertions"] = stats.insertions;
+                d["contended"] = stats.contended;
+                d["published_total"] = stats.publishedTotal;
+                d["slots"] = stats.slots;
+                d["capacity_bytes"] = stats.arenaBytes;
+                d["bytes_written"] = stats.arenaWritten;
+                d["hit_rate"] = lookups ? static_cast<double>(stats.hits) / lookups : 0.0;
+                return d;
+            },
+            "Hit and miss counters of this process and the totals of the segment")
+        .def_static("remove", &code_educator::SharedCache::remove,
+             "Unlink a segment (processes attached to it keep using it)", py::arg("name"))
+        .def_property_readonly("name", &code_educator::SharedCache::name)
+        .def_property_readonly("capacity", &code_educator::SharedCache::capacity);
+
+    // DiskCache (재시작과 프로세스 사이에 공유되는 디렉터리 캐시)
+    py::class_<code_educator::DiskCache, std::shared_ptr<code_educator::DiskCache>>(m, "DiskCache")
+        .def(py::init([](const std::string& directory, size_t maxBytes, bool sync) {
+                 code_educator::DiskCacheOptions options;
+                 options.maxBytes = maxBytes;
+                 options.sync = sync;
+                 return std::make_shared<code_educator::DiskCache>(directory, options);
+             }),
+             py::arg("directory"), py::arg("max_bytes") = 256 * 1024 * 1024, py::arg("sync") = false)
+        .def("stats",
+            [](const code_educator::DiskCache &cache) {
+                code_educator::DiskCacheStats stats = cache.stats();
+                uint64_t lookups = stats.hits + stats.misses;
+                py::dict d;
+                d["hits"] = stats.hits;
+                d["misses"] = stats.misses;
+                d["insertions"] = stats.insertions;
+                d["compactions"] = stats.compactions;
+                d["errors"] = stats.errors;
+                d["entries"] = stats.entries;
+                d["log_bytes"] = stats.logBytes;
+                d["capacity_bytes"] = stats.capacityBytes;
+                d["generation"] = stats.generation;
+                d["hit_rate"] = lookups ? static_cast<double>(stats.hits) / lookups : 0.0;
+                return d;
+            },
+            "Hit and miss counters of this process and the shared size of the cache")
+        .def("compact", &code_educator::DiskCache::compact,
+             "Rewrite the log keeping the most recently used reports", release_gil())
+        .def("clear", &code_educator::DiskCache::clear,
+             "Drop every stored report", release_gil())
+        .def_property_readonly("directory", &code_educator::DiskCache::directory)
+        .def_property_readonly("capacity", &code_educator::DiskCache::capacity);
+
+    // Metric 바인딩 (분석할 메트릭 비트마스크, | 로 조합)
+    py::enum_<code_educator::MetricMask>(m, "Metric", py::arithmetic())
+        .value("LINES", code_educator::METRIC_LINES)
+        .value("COMMENTS", code_educator::METRIC_COMMENTS)
+        .value("NESTING", code_educator::METRIC_NESTING)
+        .value("CYCLOMATIC", code_educator::METRIC_CYCLOMATIC)
+        .value("TOKENS", code_educator::METRIC_TOKENS)
+        .value("ISSUES", code_educator::METRIC_ISSUES)
+        .value("SUGGESTIONS", code_educator::METRIC_SUGGESTIONS)
+        .value("STRUCTURE", code_educator::METRIC_STRUCTURE)
+        .value("ALL", code_educator::METRIC_ALL)
+        .value("QUALITY", code_educator::METRIC_QUALITY);
+
+    // CancelToken 바인딩 (다른 스레드에서 cancel() 하면 진행 중인 분석이 부분 결과로 끝남)
+    py::class_<code_educator::CancelToken, std::shared_ptr<code_educator::CancelToken>>(m, "CancelToken")
+        .def(py::init<>())
+        .def("cancel", &code_educator::CancelToken::cancel, "Stop the analyses using this token")
+        .def_property_readonly("cancelled", &code_educator::CancelToken::cancelled);
+
+    // AnalysisOptions 바인딩
+    py::class_<code_educator::AnalysisOptions>(m, "AnalysisOptions")
+        .def(py::init([](bool tokenFrequency, size_t topTokens, uint32_t metrics, const std::string& fileName,
+                         double timeLimitMs, size_t memoryLimitBytes, std::shared_ptr<code_educator::CancelToken> cancel) {
+                 code_educator::AnalysisOptions options;
+                 options.tokenFrequency = tokenFrequency;
+                 options.topTokens = topTokens;
+                 options.metrics = metrics;
+                 options.fileName = fileName;
+                 options.budget.timeLimitNs = static_cast<uint64_t>(std::max(timeLimitMs, 0.0) * 1e6);
+                 options.budget.memoryLimitBytes = memoryLimitBytes;
+                 options.budget.cancel = std::move(cancel);
+                 return options;
+             }),
+             py::arg("token_frequency") = true, py::arg("top_tokens") = 0,
+             py::arg("metrics") = static_cast<uint32_t>(code_educator::METRIC_ALL), py::arg("file_name") = "",
+             py::arg("time_limit_ms") = 0.0, py::arg("memory_limit_bytes") = 0, py::arg("cancel") = py::none())
+        .def_readwrite("token_frequency", &code_educator::AnalysisOptions::tokenFrequency)
+        .def_readwrite("top_tokens", &code_educator::AnalysisOptions::topTokens)
+        .def_readwrite("metrics", &code_educator::AnalysisOptions::metrics)
+        .def_readwrite("file_name", &code_educator::AnalysisOptions::fileName)
+        .def_property("time_limit_ms",
+            [](const code_educator::AnalysisOptions& options) { return options.budget.timeLimitNs / 1e6; },
+            [](code_educator::AnalysisOptions& options, double ms) {
+                options.budget.timeLimitNs = static_cast<uint64_t>(std::max(ms, 0.0) * 1e6);
+            })
+        .def_property("memory_limit_bytes",
+            [](const code_educator::AnalysisOptions& options) { return options.budget.memoryLimitBytes; },
+            [](code_educator::AnalysisOptions& options, size_t bytes) { options.budget.memoryLimitBytes = bytes; })
+        .def_property("cancel",
+            [](const code_educator::AnalysisOptions& options) { return options.budget.cancel; },
+            [](code_educator::AnalysisOptions& options, std::shared_ptr<code_educator::CancelToken> cancel) {
+                options.budget.cancel = std::move(cancel);
+            });
+
+    // QualityInputs 바인딩
+    py::class_<code_educator::QualityInputs>(m, "QualityInputs")
+        .def(py::init<>())
+        .def_readwrite("cyclomatic_complexity", &code_educator::QualityInputs::cyclomaticComplexity)
+        .def_readwrite("comment_ratio", &code_educator::QualityInputs::commentRatio)
+        .def_readwrite("nesting_depth", &code_educator::QualityInputs::nestingLength)
+        .def_readwrite("issue_count", &code_educator::QualityInputs::issueCount);
+
+    // TokenSketch 바인딩 (스케치는 잠금이 없으므로 읽기/쓰기 모두 GIL을 쥔 채 실행)
+    py::class_<code_educator::TokenSketch>(m, "TokenSketch")
+        .def(py::init<size_t, size_t, size_t>(),
+             py::arg("top_capacity") = 256, py::arg("width") = 2048, py::arg("depth") = 4)
+        .def("add", [](code_educator::TokenSketch& sketch, const std::string& token, uint64_t count) {
+                 sketch.add(token, count);
+             },
+             "Count occurrences of a token", py::arg("token"), py::arg("count") = 1)
+        .def("estimate", [](const code_educator::TokenSketch& sketch, const std::string& token) {
+                 return sketch.estimate(token);
+             },
+             "Upper bound of the count of a token", py::arg("token"))
+        .def("top",
+             [](const code_educator::TokenSketch& sketch, size_t k) {
+                 std::vector<std::tuple<std::string, uint64_t, uint64_t>> out;
+                 for (auto& entry : sketch.top(k)) {
+                     out.emplace_back(std::move(entry.key), entry.count, entry.lowerBound);
+                 }
+                 return out;
+             },
+             "Most frequent tokens as (token, count, lower_bound), highest first (k = 0: all)",
+             py::arg("k") = 0)
+        .def("merge", &code_educator::TokenSketch::merge,
+             "Add the counts of a sketch of the same shape", py::arg("other"))
+        .def("clear", &code_educator::TokenSketch::clear)
+        .def("serialize",
+             [](const code_educator::TokenSketch& sketch) {
+                 return py::bytes(sketch.serialize());
+             },
+             "Binary form of the sketch")
+        .def_static("deserialize",
+             [](SourceText data) { return code_educator::TokenSketch::deserialize(data.view); },
+             "Read a sketch back from serialize() output", py::arg("data"), release_gil())
+        .def("save", &code_educator::TokenSketch::save,
+             "Write the sketch to a file", py::arg("path"))
+        .def_static("load", &code_educator::TokenSketch::load,
+             "Read a sketch written by save()", py::arg("path"), release_gil())
+        .def_property_readonly("total", &code_educator::TokenSketch::total)
+        .def_property_readonly("top_capacity", &code_educator::TokenSketch::topCapacity)
+        .def_property_readonly("width", &code_educator::TokenSketch::width)
+        .def_property_readonly("depth", &code_educator::TokenSketch::depth)
+        .def_property_readonly("memory_usage", &code_educator::TokenSketch::memoryUsage)
+        .def("__repr__",
+            [](const code_educator::TokenSketch &sketch) {
+                return "<TokenSketch total=" + std::to_string(sketch.total()) +
+                       " top_capacity=" + std::to_string(sketch.topCapacity()) + ">";
+            });
+
+    // QualityCheck 바인딩
+    py::class_<code_educator::QualityCheck>(m, "QualityCheck")
+        .def_readonly("passed", &code_educator::QualityCheck::passed)
+        .def_readonly("score", &code_educator::QualityCheck::score)
+        .def_readonly("threshold", &code_educator::QualityCheck::threshold)
+        .def_readonly("complete", &code_educator::QualityCheck::complete)
+        .def_readonly("decided_by", &code_educator::QualityCheck::decidedBy)
+        .def_readonly("bytes_analyzed", &code_educator::QualityCheck::bytesAnalyzed)
+        .def("__repr__",
+            [](const code_educator::QualityCheck &check) {
+                return std::string("<QualityCheck ") + (check.passed ? "passed" : "failed") +
+                       " score=" + std::to_string(check.score) +
+                       " decided_by=" + check.decidedBy + ">";
+            });
+
+    // Snapshot 바인딩 (버전이 붙은 바이너리 형식, 복사 없이 필드를 바로 읽음)
+    m.def("write_snapshot",
+          [](const code_educator::AnalysisReport& report) { return py::bytes(code_educator::writeSnapshot(report)); },
+          "Binary snapshot of a report", py::arg("report"));
+    m.def("write_snapshot",
+          [](const code_educator::CodeStructure& structure) { return py::bytes(code_educator::writeSnapshot(structure)); },
+          "Binary snapshot of a code structure", py::arg("structure"));
+    m.def("write_snapshot",
+          [](const code_educator::AnalysisResult& result) { return py::bytes(code_educator::writeSnapshot(result)); },
+          "Binary snapshot of an analysis result", py::arg("result"));
+    m.attr("SNAPSHOT_FORMAT") = code_educator::SNAPSHOT_FORMAT;
+
+    py::class_<SnapshotHandle>(m, "Snapshot")
+        .def(py::init([](py::object data) {
+                 auto handle = std::make_unique<SnapshotHandle>();
+                 std::string_view view;
+                 if (!handle->buffers.load(data, view)) {
+                     throw py::type_error("Snapshot() expects bytes or a byte buffer");
+                 }
+                 handle->owner = data;
+                 handle->view = std::make_unique<code_educator::SnapshotView>(view);
+                 return handle;
+             }),
+             "Read a snapshot in place (bytes, bytearray, memoryview or mmap; kept alive by the snapshot)",
+             py::arg("data"))
+        .def_static("load",
+             [](const std::string& path) {
+                 auto handle = std::make_unique<SnapshotHandle>();
+                 handle->file = std::make_unique<code_educator::MappedFile>(path);
+                 handle->view = std::make_unique<code_educator::SnapshotView>(handle->file->view());
+                 return handle;
+             },
+             "Memory-map a snapshot file and read it in place", py::arg("path"))
+        .def_property_readonly("has_structure", [](const SnapshotHandle& s) { return s.view->hasStructure(); })
+        .def_property_readonly("has_result", [](const SnapshotHandle& s) { return s.view->hasResult(); })
+        .def_property_readonly("analyzer_version", [](const SnapshotHandle& s) { return s.view->analyzerVersion(); })
+        .def_property_readonly("language", [](const SnapshotHandle& s) { return std::string(s.view->language()); })
+        .def_property_readonly("complexity", [](const SnapshotHandle& s) { return s.view->complexity(); })
+        .def_property_readonly("imports", [](const SnapshotHandle& s) { return snapshotStrings(s.view->imports()); })
+        .def_property_readonly("functions", [](const SnapshotHandle& s) { return snapshotStrings(s.view->functions()); })
+        .def_property_readonly("classes", [](const SnapshotHandle& s) { return snapshotStrings(s.view->classes()); })
+        .def_property_readonly("structure_metadata",
+            [](const SnapshotHandle& s) { return snapshotPairs(s.view->structureMetadata()); })
+        .def_property_readonly("line_count", [](const SnapshotHandle& s) { return s.view->lineCount(); })
+        .def_property_readonly("comment_count", [](const SnapshotHandle& s) { return s.view->commentCount(); })
+        .def_property_readonly("comment_ratio", [](const SnapshotHandle& s) { return s.view->commentRatio(); })
+        .def_property_readonly("nesting_depth", [](const SnapshotHandle& s) { return s.view->nestingLength(); })
+        .def_property_readonly("cyclomatic_complexity",
+            [](const SnapshotHandle& s) { return s.view->cyclomaticComplexity(); })
+        .def_property_readonly("potential_issues",
+            [](const SnapshotHandle& s) { return snapshotStrings(s.view->potentialIssues()); })
+        .def_property_readonly("suggestions", [](const SnapshotHandle& s) { return snapshotStrings(s.view->suggestions()); })
+        .def_property_readonly("metadata", [](const SnapshotHandle& s) { return snapshotPairs(s.view->metadata()); })
+        .def_property_readonly("token_frequency",
+            [](const SnapshotHandle& s) {
+                py::dict out;
+                s.view->forEachToken([&](std::string_view key, int count) {
+                    out[py::str(key.data(), key.size())] = count;
+                });
+                return out;
+            })
+        .def_property_readonly("quality_score", [](const SnapshotHandle& s) { return s.view->qualityScore(); })
+        .def_property_readonly("truncated", [](const SnapshotHandle& s) { return s.view->truncated(); })
+        .def_property_readonly("truncated_by", [](const SnapshotHandle& s) { return std::string(s.view->truncatedBy()); })
+        .def_property_readonly("bytes_analyzed", [](const SnapshotHandle& s) { return s.view->bytesAnalyzed(); })
+        .def("structure", [](const SnapshotHandle& s) { return s.view->structure(); }, "Copy out the CodeStructure")
+        .def("result", [](const SnapshotHandle& s) { return s.view->result(); }, "Copy out the AnalysisResult")
+        .def("report", [](const SnapshotHandle& s) { return s.view->report(); }, "Copy out the AnalysisReport")
+        .def("__len__", [](const SnapshotHandle& s) { return s.view->data().size(); })
+        .def("__repr__",
+            [](const SnapshotHandle& s) {
+                return "<Snapshot language='" + std::string(s.view->language()) +
+                       "' bytes=" + std::to_string(s.view->data().size()) + ">";
+            });
+
     // Analyzer
     py::class_<code_educator::Analyzer>(m, "Analyzer")
         .def(py::init<>())
-        .def("analyze", &code_educator::Analyzer::analyze,
-             "Analyze code and return detailed analysis results",
-             py::arg("code"))
-        .def("analyze_with_structure", &code_educator::Analyzer::analyzeWithSturcture,
+        .def("report",
+             [](const code_educator::Analyzer& analyzer, SourceText code, const code_educator::AnalysisOptions& options) {
+                 return convertResult([&]() { return analyzer.report(code.view, options); });
+             },
+             "Parse, analyze and score code in one call (uses the attached cache)",
+             py::arg("code"), py::arg("options") = code_educator::AnalysisOptions())
+        .def("analyze_json",
+             [](const code_educator::Analyzer& analyzer, SourceText code, const code_educator::AnalysisOptions& options,
+                bool cached) {
+                 // per-thread output buffer: its capacity carries over to the next call
+                 thread_local std::string buffer;
+                 {
+                     py::gil_scoped_release release;
+                     code_educator::AnalysisReport report = analyzer.report(code.view, options);
+                     code_educator::StageTimer timer(code_educator::Stage::Binding);
+                     code_educator::ReportJsonOptions json;
+                     json.tokenFrequency = options.countsTokens();
+                     json.cached = cached;
+                     buffer.clear();
+                     code_educator::writeReportJson(report, buffer, json);
+                 }
+                 py::bytes out(buffer.data(), buffer.size());
+                 if (buffer.capacity() > JSON_BUFFER_KEEP_BYTES) {
+                     std::string().swap(buffer);
+                 }
+                 return out;
+             },
+             "report() written straight to UTF-8 JSON bytes, with the keys of the /analyze response "
+             "(token_frequency when the options count tokens, cached on request)",
+             py::arg("code"), py::arg("options") = code_educator::AnalysisOptions(), py::arg("cached") = false)
+        .def("analyze_async", &analyzeAsync,
+             "report() on the native thread pool without blocking the event loop: returns an asyncio future "
+             "(of the running loop unless one is given) resolving to the AnalysisReport, or to the analyze_json() "
+             "bytes with as_json; cancelling the future cancels the analysis",
+             py::arg("code"), py::arg("options") = code_educator::AnalysisOptions(), py::arg("as_json") = false,
+             py::arg("cached") = false, py::arg("loop") = py::none())
+        .def("analyze_file",
+             [](const code_educator::Analyzer& analyzer, const std::string& path, const code_educator::AnalysisOptions& options) {
+                 return convertResult([&]() { return analyzer.analyzeFile(path, options); });
+             },
+             "Memory-map a file and analyze it in place (uses the attached cache)",
+             py::arg("path"), py::arg("options") = code_educator::AnalysisOptions())
+        .def("analyze_stream",
+             [](const code_educator::Analyzer& analyzer, py::iterable chunks, const std::string& language, size_t chunkBytes,
+                const code_educator::AnalysisOptions& options) {
+                 code_educator::AnalyzerStream stream(analyzer, language, chunkBytes, options);
+                 feedChunks(stream, chunks);
+                 py::gil_scoped_release release;
+                 return stream.finish();
+             },
+             "Analyze an iterable of chunks (e.g. a file opened in binary mode) with bounded memory",
+             py::arg("chunks"), py::arg("language") = "",
+             py::arg("chunk_bytes") = code_educator::AnalyzerStream::DEFAULT_CHUNK_BYTES,
+             py::arg("options") = code_educator::AnalysisOptions())
+        .def("sketch_tokens",
+             [](const code_educator::Analyzer& analyzer, SourceText code, code_educator::TokenSketch& sketch,
+                const std::string& language) {
+                 analyzer.sketchTokens(code.view, sketch, language);
+             },
+             "Add the identifiers of code to a TokenSketch (language detected when empty)",
+             py::arg("code"), py::arg("sketch"), py::arg("language") = "")
+        .def("set_cache", &code_educator::Analyzer::setCache,
+             "Attach a ResultCache used by report() (None disables caching)",
+             py::arg("cache"))
+        .def_property_readonly("cache", &code_educator::Analyzer::cache)
+        .def("set_disk_cache", &code_educator::Analyzer::setDiskCache,
+             "Attach a DiskCache used by report() after the memory cache (None disables it)",
+             py::arg("cache"))
+        .def_property_readonly("disk_cache", &code_educator::Analyzer::diskCache)
+        .def("set_shared_cache", &code_educator::Analyzer::setSharedCache,
+             "Attach a SharedCache used by report() after the memory cache (None disables it)",
+             py::arg("cache"))
+        .def_property_readonly("shared_cache", &code_educator::Analyzer::sharedCache)
+        .def("analyze",
+             [](const code_educator::Analyzer& analyzer, SourceText code, code_educator::AnalysisOptions options,
+                std::optional<uint32_t> metrics) {
+                 if (metrics) {
+                     options.metrics = *metrics;
+                 }
+                 return convertResult([&]() { return analyzer.analyze(code.view, options); });
+             },
+             "Analyze code and return detailed analysis results (metrics: Metric flags to compute)",
+             py::arg("code"), py::arg("options") = code_educator::AnalysisOptions(), py::arg("metrics") = py::none())
+        .def("analyze_batch",
+             [](const code_educator::Analyzer& analyzer, SourceList codes, size_t threads,
+                const code_educator::AnalysisOptions& options) {
+                 return convertResult([&]() { return analyzer.analyzeBatch(codes.views, threads, options); });
+             },
+             "Analyze many sources in parallel on the native thread pool",
+             py::arg("codes"), py::arg("threads") = 0, py::arg("options") = code_educator::AnalysisOptions())
+        .def("analyze_with_structure",
+             [](const code_educator::Analyzer& analyzer, SourceText code, const code_educator::CodeStructure& structure) {
+                 return analyzer.analyzeWithSturcture(code.view, structure);
+             },
              "Analyze code with existing structure information",
-             py::arg("code"), py::arg("structure"))
-        .def("calculate_quality_score", &code_educator::Analyzer::calculateQuality,
+             py::arg("code"), py::arg("structure"), release_gil())
+        .def("check_quality",
+             [](const code_educator::Analyzer& analyzer, SourceText code, int threshold, const std::string& fileName) {
+                 return analyzer.checkQuality(code.view, threshold, fileName);
+             },
+             "Pass/fail against a quality threshold, stopping as soon as the outcome is certain",
+             py::arg("code"), py::arg("threshold"), py::arg("file_name") = "", release_gil())
+        .def("check_quality_file", &code_educator::Analyzer::checkQualityFile,
+             "check_quality() on a memory-mapped file",
+             py::arg("path"), py::arg("threshold"), release_gil())
+        .def("calculate_quality_score",
+             py::overload_cast<const code_educator::AnalysisResult&>(&code_educator::Analyzer::calculateQuality, py::const_),
              "Calculate code quality score (0-100)",
              py::arg("result"))
-        .def("generate_suggestions", &code_educator::Analyzer::generateSuggestions,
+        .def("calculate_quality_score",
+             py::overload_cast<const code_educator::QualityInputs&>(&code_educator::Analyzer::calculateQuality, py::const_),
+             "Calculate code quality score (0-100) from the score inputs alone",
+             py::arg("inputs"))
+        .def("generate_suggestions",
+             [](const code_educator::Analyzer& analyzer, SourceText code, const code_educator::CodeStructure& structure) {
+                 return analyzer.generateSuggestions(code.view, structure);
+             },
              "Generate code improvement suggestions",
-             py::arg("code"), py::arg("structure"))
-        .def("analyze_python", &code_educator::Analyzer::analyzePython,
+             py::arg("code"), py::arg("structure"), release_gil())
+        .def("analyze_python",
+             [](const code_educator::Analyzer& analyzer, SourceText code) { return analyzer.analyzePython(code.view); },
              "Analyze Python code",
-             py::arg("code"))
-        .def("analyze_cpp", &code_educator::Analyzer::analyzeCpp,
+             py::arg("code"), release_gil())
+        .def("analyze_cpp",
+             [](const code_educator::Analyzer& analyzer, SourceText code) { return analyzer.analyzeCpp(code.view); },
              "Analyze C++ code",
-             py::arg("code"))
-        .def("analyze_javascript", &code_educator::Analyzer::analyzeJavaScript,
+             py::arg("code"), release_gil())
+        .def("analyze_javascript",
+             [](const code_educator::Analyzer& analyzer, SourceText code) { return analyzer.analyzeJavaScript(code.view); },
              "Analyze JavaScript code",
-             py::arg("code"));
+             py::arg("code"), release_gil());
+
+    // AnalysisSession 바인딩 (offsets are byte offsets into the UTF-8 text)
+    // 세션 내부 잠금으로 보호되므로 여러 스레드에서 GIL 없이 호출 가능
+    py::class_<code_educator::AnalysisSession>(m, "AnalysisSession")
+        .def(py::init([](const code_educator::Analyzer& analyzer, SourceText code, const std::string& language) {
+                 return new code_educator::AnalysisSession(analyzer, code.view, language);
+             }),
+             py::arg("analyzer"), py::arg("code") = "", py::arg("language") = "",
+             py::keep_alive<1, 2>())
+        .def("edit",
+             [](code_educator::AnalysisSession& session, size_t start, size_t end, SourceText replacement) {
+                 session.edit(start, end, replacement.view);
+             },
+             "Replace bytes [start, end) with replacement and update the analysis",
+             py::arg("start"), py::arg("end"), py::arg("replacement"), release_gil())
+        .def("result", &code_educator::AnalysisSession::result,
+             "Analysis result of the current text (token frequency only if options ask for it)",
+             py::arg("options") = code_educator::AnalysisOptions(), release_gil())
+        .def("structure", &code_educator::AnalysisSession::structure,
+             "Code structure of the current text", release_gil())
+        .def("report", &code_educator::AnalysisSession::report,
+             "Structure, analysis result and quality score of the current text",
+             py::arg("options") = code_educator::AnalysisOptions(), release_gil())
+        .def_property_readonly("text",
+            [](const code_educator::AnalysisSession& session) {
+                return py::bytes(session.text());
+            })
+        .def_property_readonly("language",
+            [](const code_educator::AnalysisSession& session) {
+                return std::string(code_educator::languageName(session.language()));
+            })
+        .def_property_readonly("last_relexed_lines", &code_educator::AnalysisSession::lastRelexedLines);
+
+    // AnalyzerStream 바인딩 (스트림 내부 잠금으로 보호되므로 GIL 없이 호출 가능)
+    py::class_<code_educator::AnalyzerStream>(m, "AnalyzerStream")
+        .def(py::init<const code_educator::Analyzer&, const std::string&, size_t, const code_educator::AnalysisOptions&>(),
+             py::arg("analyzer"), py::arg("language") = "",
+             py::arg("chunk_bytes") = code_educator::AnalyzerStream::DEFAULT_CHUNK_BYTES,
+             py::arg("options") = code_educator::AnalysisOptions(),
+             py::keep_alive<1, 2>())
+        .def("feed",
+             [](code_educator::AnalyzerStream& stream, SourceText chunk) { stream.feed(chunk.view); },
+             "Append the next chunk of the input",
+             py::arg("chunk"), release_gil())
+        .def("feed_all", &feedChunks,
+             "Append every chunk of an iterable",
+             py::arg("chunks"))
+        .def("finish", &code_educator::AnalyzerStream::finish,
+             "Analyze the rest of the input and return the report of all of it", release_gil())
+        .def_property_readonly("bytes_fed", &code_educator::AnalyzerStream::bytesFed)
+        .def_property_readonly("language",
+            [](const code_educator::AnalyzerStream& stream) {
+                return std::string(code_educator::languageName(stream.language()));
+            });
+
+    // RepositoryScanner 바인딩
+    py::class_<code_educator::ScanOptions>(m, "ScanOptions")
+        .def(py::init<>())
+        .def_readwrite("extensions", &code_educator::ScanOptions::extensions)
+        .def_readwrite("ignore", &code_educator::ScanOptions::ignore)
+        .def_readwrite("worst_count", &code_educator::ScanOptions::worstCount)
+        .def_readwrite("threads", &code_educator::ScanOptions::threads)
+        .def_readwrite("max_file_bytes", &code_educator::ScanOptions::maxFileBytes)
+        .def_readwrite("follow_symlinks", &code_educator::ScanOptions::followSymlinks)
+        .def_readwrite("token_sketch_capacity", &code_educator::ScanOptions::tokenSketchCapacity);
+
+    py::class_<code_educator::LanguageTotals>(m, "LanguageTotals")
+        .def_readonly("files", &code_educator::LanguageTotals::files)
+        .def_readonly("bytes", &code_educator::LanguageTotals::bytes)
+        .def_readonly("lines", &code_educator::LanguageTotals::lines)
+        .def_readonly("comments", &code_educator::LanguageTotals::comments)
+        .def_readonly("issues", &code_educator::LanguageTotals::issues)
+        .def_readonly("average_quality", &code_educator::LanguageTotals::averageQuality);
+
+    py::class_<code_educator::FileSummary>(m, "FileSummary")
+        .def_readonly("path", &code_educator::FileSummary::path)
+        .def_readonly("language", &code_educator::FileSummary::language)
+        .def_readonly("quality_score", &code_educator::FileSummary::qualityScore)
+        .def_readonly("line_count", &code_educator::FileSummary::lineCount)
+        .def_readonly("cyclomatic_complexity", &code_educator::FileSummary::cyclomaticComplexity)
+        .def_readonly("issue_count", &code_educator::FileSummary::issueCount);
+
+    py::class_<code_educator::RepositoryReport>(m, "RepositoryReport")
+        .def_readonly("root", &code_educator::RepositoryReport::root)
+        .def_readonly("files_scanned", &code_educator::RepositoryReport::filesScanned)
+        .def_readonly("files_skipped", &code_educator::RepositoryReport::filesSkipped)
+        .def_readonly("files_failed", &code_educator::RepositoryReport::filesFailed)
+        .def_readonly("bytes", &code_educator::RepositoryReport::bytes)
+        .def_readonly("total_lines", &code_educator::RepositoryReport::totalLines)
+        .def_readonly("total_issues", &code_educator::RepositoryReport::totalIssues)
+        .def_readonly("average_quality", &code_educator::RepositoryReport::averageQuality)
+        .def_readonly("languages", &code_educator::RepositoryReport::languages)
+        .def_readonly("quality_histogram", &code_educator::RepositoryReport::qualityHistogram)
+        .def_readonly("worst_files", &code_educator::RepositoryReport::worstFiles)
+        .def_readonly("errors", &code_educator::RepositoryReport::errors)
+        .def_readonly("token_sketches", &code_educator::RepositoryReport::tokenSketches)
+        .def_readonly("seconds", &code_educator::RepositoryReport::seconds)
+        .def("__repr__",
+            [](const code_educator::RepositoryReport &r) {
+                return "<RepositoryReport files=" + std::to_string(r.filesScanned) +
+                       " lines=" + std::to_string(r.totalLines) +
+                       " issues=" + std::to_string(r.totalIssues) +
+                       " seconds=" + std::to_string(r.seconds) + ">";
+            }
+        );
+
+    py::class_<code_educator::RepositoryScanner>(m, "RepositoryScanner")
+        .def(py::init<const code_educator::Analyzer&, code_educator::ScanOptions>(),
+             py::arg("analyzer"), py::arg("options") = code_educator::ScanOptions(),
+             py::keep_alive<1, 2>())
+        .def("scan", &code_educator::RepositoryScanner::scan,
+             "Analyze every matching file under root in parallel and aggregate the results",
+             py::arg("root"), release_gil())
+        .def_property_readonly("options", &code_educator::RepositoryScanner::options);
+
+    m.def("thread_count", []() { return code_educator::ThreadPool::shared().size(); },
+          "Number of worker threads in the native pool");
+    m.def("byte_scan_kernel", &code_educator::byteScanKernel,
+          "Vector kernel used to skip literals and comments: avx2, sse2 or scalar");
+
+    m.def("core_stats", []() { return coreStatsDict(code_educator::coreStats()); },
+          "Per-stage latency histograms (ns) and counters of the native core, summed over threads");
+    m.def("reset_core_stats", &code_educator::resetCoreStats,
+          "Start core_stats() counting from zero");
+    m.def("set_core_stats_enabled", &code_educator::setCoreStatsEnabled,
+          "Turn stage timing on or off (on by default)", py::arg("enabled"));
+
+    // TraceCapture (with 블록 동안 현재 스레드의 스팬만 기록)
+    py::class_<code_educator::TraceCapture>(m, "TraceCapture")
+        .def(py::init<>())
+        .def("__enter__", [](code_educator::TraceCapture& capture) -> code_educator::TraceCapture& { return capture; },
+             py::return_value_policy::reference)
+        .def("__exit__", [](code_educator::TraceCapture& capture, py::args) { capture.stop(); })
+        .def("stop", &code_educator::TraceCapture::stop, "Stop recording spans of this thread")
+        .def("chrome_json", &code_educator::TraceCapture::chromeJson,
+             "Spans recorded by this capture as Chrome / Perfetto trace JSON", release_gil())
+        .def("span_count", [](const code_educator::TraceCapture& capture) { return capture.spans().size(); });
+
+    m.def("set_tracing_enabled", &code_educator::setTracingEnabled,
+          "Record trace spans on every thread (TraceCapture traces one thread without this)", py::arg("enabled"));
+    m.def("tracing_enabled", &code_educator::tracingEnabled);
+    m.def("trace_json",
+          [](uint64_t sinceNs) { return code_educator::traceToChromeJson(code_educator::traceSpans(sinceNs)); },
+          "Recorded spans of every thread as Chrome / Perfetto trace JSON (since_ns: trace_clock_ns() value)",
+          py::arg("since_ns") = 0, release_gil());
+    m.def("clear_trace", &code_educator::clearTrace, "Forget the spans recorded so far");
+    m.def("trace_clock_ns", &code_educator::traceClockNs, "Clock the span start times are measured on");
+
+    m.attr("ANALYZER_VERSION") = code_educator::ANALYZER_VERSION;
 
     m.def("version", []() { return "0.1.0"; }, "Return the version of code_educator_core");
 }
 
-export PYTHONPATH="$PYTHONPATH:$(pwd)/build"
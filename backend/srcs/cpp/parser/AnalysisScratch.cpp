@@ -0,0 +1,69 @@
+#include "AnalysisScratch.hpp"
+
+namespace code_educator {
+
+namespace {
+
+struct ThreadScratch {
+	AnalysisScratch scratch;
+	bool leased = false;
+};
+
+ThreadScratch& threadScratch() {
+	thread_local ThreadScratch local;
+	return local;
+}
+
+void release(TokenStream& stream) {
+	stream.tokens = std::vector<Token>();
+	stream.lines = std::vector<LineInfo>();
+}
+
+}  // namespace
+
+size_t AnalysisScratch::capacityBytes() const {
+	return (stream.tokens.capacity() + piece.tokens.capacity()) * sizeof(Token) +
+		(stream.lines.capacity() + piece.lines.capacity()) * sizeof(LineInfo) + tokens.memoryUsage();
+}
+
+ScratchLease::ScratchLease() {
+	ThreadScratch& local = threadScratch();
+	if (local.leased) {
+		own_.reset(new AnalysisScratch());
+		scratch_ = own_.get();
+		return;
+	}
+	local.leased = true;
+	scratch_ = &local.scratch;
+}
+
+/*
+ * Return the scratch to the thread
+ * Contents are dropped and capacity kept, unless it grew past
+ * SCRATCH_KEEP_BYTES.
+ */
+ScratchLease::~ScratchLease() {
+	if (own_) {
+		return;
+	}
+	AnalysisScratch& scratch = *scratch_;
+	if (scratch.capacityBytes() > SCRATCH_KEEP_BYTES) {
+		release(scratch.stream);
+		release(scratch.piece);
+	}
+	else {
+		scratch.stream.tokens.clear();
+		scratch.stream.lines.clear();
+		scratch.piece.tokens.clear();
+		scratch.piece.lines.clear();
+	}
+	if (scratch.tokens.memoryUsage() > SCRATCH_KEEP_COUNTER_BYTES) {
+		scratch.tokens.clear();
+	}
+	else {
+		scratch.tokens.reset();
+	}
+	threadScratch().leased = false;
+}
+
+}  // namespace code_educator
@@ -0,0 +1,450 @@
+#include "AnalysisSession.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace code_educator {
+
+namespace {
+
+// replace v[begin, end) with the contents of src
+template <typename T>
+void replaceRange(std::vector<T>& v, size_t begin, size_t end, std::vector<T>& src) {
+	size_t common = std::min(end - begin, src.size());
+	std::move(src.begin(), src.begin() + common, v.begin() + begin);
+	if (src.size() > common) {
+		v.insert(v.begin() + end, std::make_move_iterator(src.begin() + common), std::make_move_iterator(src.end()));
+	}
+	else {
+		v.erase(v.begin() + begin + common, v.begin() + end);
+	}
+}
+
+}  // namespace
+
+/*
+ * Start a session on a buffer
+ * @param analyzer: analyzer used to build results (must outlive the session)
+ * @param code: initial contents
+ * @param language: language name, or empty to detect it
+ */
+AnalysisSession::AnalysisSession(const Analyzer& analyzer, std::string_view code, const std::string& language)
+	: analyzer_(analyzer), text_(code) {
+	if (language.empty()) {
+		language_ = languageFromName(analyzer_.codeParser().detectLanguage(text_));
+		detect_ = language_ == Language::Unknown;
+	}
+	else {
+		language_ = languageFromName(language);
+		detect_ = false;
+	}
+	rebuild();
+}
+
+/*
+ * Apply an edit and bring every metric up to date
+ * @param start: first byte to replace
+ * @param end: one past the last byte to replace
+ * @param replacement: new text for [start, end)
+ */
+void AnalysisSession::edit(size_t start, size_t end, std::string_view replacement) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (start > end || end > text_.size()) {
+		throw std::out_of_range("edit range outside the text");
+	}
+
+	// keep the removed bytes: the replaced tokens are read back from them
+	std::string removed = text_.substr(start, end - start);
+	text_.replace(start, end - start, replacement.data(), replacement.size());
+	structureValid_ = false;
+
+	if (detect_) {
+		Language detected = languageFromName(analyzer_.codeParser().detectLanguage(text_));
+		if (detected != Language::Unknown) {
+			language_ = detected;
+			detect_ = false;
+			rebuild();
+			return;
+		}
+	}
+
+	size_t first = lineOf(start);
+	std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(replacement.size()) - static_cast<std::ptrdiff_t>(end - start);
+	size_t relexedEnd = relex(first, start, start + replacement.size(), delta, removed);
+	remeasure(first, relexedEnd);
+
+	// matches a little before the edit may read into it, and the first token
+	// after it is read back by the next match
+	size_t tokenBegin = records_[first].firstToken;
+	size_t tokenEnd = relexedEnd < records_.size() ? records_[relexedEnd].firstToken : stream_.tokens.size();
+	size_t lookback = tokenBegin > STRUCTURE_LOOKBACK ? tokenBegin - STRUCTURE_LOOKBACK : 0;
+	restructure(lineOfToken(lookback), lineOfToken(tokenEnd) + 1);
+}
+
+void AnalysisSession::rebuild() {
+	records_.clear();
+	stream_ = TokenStream();
+	stream_.language = language_;
+	frequency_.clear();
+	lines_ = 0;
+	comments_ = 0;
+	cyclomatic_ = 0;
+	nestingCounts_.clear();
+	std::fill(std::begin(factCounts_), std::end(factCounts_), 0);
+	control_ = 0;
+	indentCounts_.clear();
+	structureValid_ = false;
+
+	size_t relexedEnd = relex(0, 0, 0, 0, std::string());
+	remeasure(0, relexedEnd);
+	restructure(0, records_.size());
+}
+
+// index of the line holding byte `offset`
+size_t AnalysisSession::lineOf(size_t offset) const {
+	auto it = std::upper_bound(records_.begin(), records_.end(), offset,
+		[](size_t value, const LineRecord& record) { return value < record.offset; });
+	return it == records_.begin() ? 0 : static_cast<size_t>(it - records_.begin()) - 1;
+}
+
+// index of the line holding token `token` (the last line if it is past the end)
+size_t AnalysisSession::lineOfToken(size_t token) const {
+	auto it = std::upper_bound(records_.begin(), records_.end(), token,
+		[](size_t value, const LineRecord& record) { return value < record.firstToken; });
+	return it == records_.begin() ? 0 : static_cast<size_t>(it - records_.begin()) - 1;
+}
+
+void AnalysisSession::countToken(int step) {
+	frequency_.add(key_, step);
+}
+
+void AnalysisSession::account(const LineMetrics& metrics, int step) {
+	lines_ += step * metrics.lines;
+	comments_ += step * metrics.comments;
+	cyclomatic_ += step * metrics.cyclomatic;
+	if (static_cast<size_t>(metrics.nesting) >= nestingCounts_.size()) {
+		nestingCounts_.resize(metrics.nesting + 1, 0);
+	}
+	nestingCounts_[metrics.nesting] += step;
+	for (uint32_t facts = metrics.facts; facts != 0; facts &= facts - 1) {
+		factCounts_[__builtin_ctz(facts)] += step;
+	}
+}
+
+void AnalysisSession::account(const LineStructure& structure, int step) {
+	control_ += step * structure.control;
+	if (structure.indent < 0) {
+		return;
+	}
+	if (static_cast<size_t>(structure.indent) >= indentCounts_.size()) {
+		indentCounts_.resize(structure.indent + 1, 0);
+	}
+	indentCounts_[structure.indent] += step;
+}
+
+/*
+ * Re-lex from the start of line `first` of the new text
+ * Lines are scanned one at a time. Once past the edited bytes, scanning stops
+ * at the first line that starts at an old line start with the same lexer
+ * state: from there on the old tokens are still valid and only move.
+ * @param first: first line touched by the edit
+ * @param editStart: start of the edit
+ * @param editEnd: end of the replacement in the new text
+ * @param delta: change in text length
+ * @param removed: bytes the edit replaced
+ * @return: one past the last re-lexed line
+ */
+size_t AnalysisSession::relex(size_t first, size_t editStart, size_t editEnd, std::ptrdiff_t delta, const std::string& removed) {
+	Lexer lexer(language_);
+	const char* data = text_.data();
+	size_t size = text_.size();
+
+	LexState state;
+	MetricCarry carry;
+	size_t pos = 0;
+	if (first < records_.size()) {
+		state = records_[first].state;
+		carry = records_[first].carry;
+		pos = records_[first].offset;
+	}
+
+	TokenStream fresh;
+	fresh.language = language_;
+	std::vector<LineRecord> freshRecords;
+	size_t reuse = records_.size();  // first old line kept
+
+	while (true) {
+		LineRecord record;
+		record.offset = pos;
+		record.state = state;
+		record.firstToken = fresh.tokens.size();
+		freshRecords.push_back(std::move(record));
+
+		const void* nl = std::memchr(data + pos, '\n', size - pos);
+		if (nl == nullptr) {
+			lexer.scan(data + pos, size - pos, pos, state, fresh);
+			lexer.finish(state, fresh);
+			break;
+		}
+		size_t next = static_cast<size_t>(static_cast<const char*>(nl) - data) + 1;
+		lexer.scan(data + pos, next - pos, pos, state, fresh);
+		pos = next;
+
+		if (pos >= editEnd) {
+			size_t old = static_cast<size_t>(static_cast<std::ptrdiff_t>(pos) - delta);
+			auto it = std::lower_bound(records_.begin() + first, records_.end(), old,
+				[](const LineRecord& r, size_t value) { return r.offset < value; });
+			if (it != records_.end() && it->offset == old && it->state.sameCarry(state)) {
+				reuse = static_cast<size_t>(it - records_.begin());
+				break;
+			}
+		}
+	}
+	freshRecords[0].carry = std::move(carry);
+
+	size_t tokenBegin = first < records_.size() ? records_[first].firstToken : stream_.tokens.size();
+	size_t tokenEnd = reuse < records_.size() ? records_[reuse].firstToken : stream_.tokens.size();
+	size_t lineEnd = reuse < records_.size() ? reuse : stream_.lines.size();
+	std::ptrdiff_t lineDelta = static_cast<std::ptrdiff_t>(freshRecords.size()) - static_cast<std::ptrdiff_t>(reuse - first);
+	std::ptrdiff_t tokenDelta = static_cast<std::ptrdiff_t>(fresh.tokens.size()) - static_cast<std::ptrdiff_t>(tokenEnd - tokenBegin);
+
+	// token frequency: drop the replaced tokens (read back from the old
+	// bytes), count the new ones
+	size_t removedEnd = editStart + removed.size();
+	for (size_t i = tokenBegin; i < tokenEnd; ++i) {
+		const Token& token = stream_.tokens[i];
+		if (token.type != TokenType::Identifier) {
+			continue;
+		}
+		key_.clear();
+		for (size_t p = token.offset; p < token.offset + token.length; ++p) {
+			if (p < editStart) {
+				key_ += text_[p];
+			}
+			else if (p < removedEnd) {
+				key_ += removed[p - editStart];
+			}
+			else {
+				key_ += text_[static_cast<size_t>(static_cast<std::ptrdiff_t>(p) + delta)];
+			}
+		}
+		countToken(-1);
+	}
+
+	// everything after the re-lexed lines only moves
+	for (size_t i = tokenEnd; i < stream_.tokens.size(); ++i) {
+		stream_.tokens[i].offset = static_cast<size_t>(static_cast<std::ptrdiff_t>(stream_.tokens[i].offset) + delta);
+		stream_.tokens[i].line = static_cast<uint32_t>(static_cast<std::ptrdiff_t>(stream_.tokens[i].line) + lineDelta);
+	}
+	for (size_t i = lineEnd; i < stream_.lines.size(); ++i) {
+		stream_.lines[i].offset = static_cast<size_t>(static_cast<std::ptrdiff_t>(stream_.lines[i].offset) + delta);
+	}
+	for (size_t i = reuse; i < records_.size(); ++i) {
+		LineRecord& record = records_[i];
+		record.offset = static_cast<size_t>(static_cast<std::ptrdiff_t>(record.offset) + delta);
+		record.firstToken = static_cast<size_t>(static_cast<std::ptrdiff_t>(record.firstToken) + tokenDelta);
+		record.state.line = static_cast<uint32_t>(static_cast<std::ptrdiff_t>(record.state.line) + lineDelta);
+		record.state.lineOffset = record.offset;
+	}
+	for (LineRecord& record : freshRecords) {
+		record.firstToken += tokenBegin;
+	}
+
+	for (size_t i = first; i < reuse; ++i) {
+		account(records_[i].metrics, -1);
+		account(records_[i].structure, -1);
+	}
+	for (const LineRecord& record : freshRecords) {
+		account(record.metrics, 1);  // empty until remeasure() and restructure()
+	}
+
+	size_t freshLines = freshRecords.size();
+	size_t freshTokens = fresh.tokens.size();
+	replaceRange(stream_.tokens, tokenBegin, tokenEnd, fresh.tokens);
+	replaceRange(stream_.lines, first, lineEnd, fresh.lines);
+	replaceRange(records_, first, reuse, freshRecords);
+	for (size_t i = tokenBegin; i < tokenBegin + freshTokens; ++i) {
+		const Token& token = stream_.tokens[i];
+		if (token.type == TokenType::Identifier) {
+			key_.assign(text_, token.offset, token.length);
+			countToken(1);
+		}
+	}
+
+	lastRelexed_ = freshLines;
+	return first + freshLines;
+}
+
+/*
+ * Re-evaluate line metrics from line `first`
+ * Stops at the first line after the re-lexed ones whose stored metric carry
+ * equals the current one.
+ * @param first: first re-lexed line
+ * @param relexedEnd: one past the last re-lexed line
+ */
+void AnalysisSession::remeasure(size_t first, size_t relexedEnd) {
+	MetricEngine engine(language_);
+	engine.setTokenFrequency(false);
+	engine.restore(records_[first].carry);
+
+	const char* base = text_.data();
+	for (size_t i = first; i < records_.size(); ++i) {
+		LineRecord& record = records_[i];
+		if (i >= relexedEnd && record.carry == engine.carry()) {
+			break;
+		}
+		record.carry = engine.carry();
+		if (i >= stream_.lines.size()) {
+			continue;  // trailing empty line
+		}
+
+		size_t end = i + 1 < records_.size() ? records_[i + 1].firstToken : stream_.tokens.size();
+		engine.resetCounters();
+		engine.consumeLine(base, stream_.lines[i], stream_.tokens.data() + record.firstToken, end - record.firstToken);
+
+		const MetricCounters& counters = engine.counters();
+		account(record.metrics, -1);
+		record.metrics.lines = counters.lineCount;
+		record.metrics.comments = counters.commentCount;
+		record.metrics.cyclomatic = counters.cyclomaticComplexity - 1;
+		record.metrics.nesting = counters.nestingLength;
+		record.metrics.facts = counters.facts;
+		account(record.metrics, 1);
+	}
+}
+
+/*
+ * Find the structure matches of lines [first, end) again
+ * @param first: first line to search
+ * @param end: one past the last line to search
+ */
+void AnalysisSession::restructure(size_t first, size_t end) {
+	const CodeParser& parser = analyzer_.codeParser();
+	bool structured = CodeParser::hasStructure(language_);
+	CodeStructure found;
+
+	end = std::min(end, records_.size());
+	for (size_t i = first; i < end; ++i) {
+		LineRecord& record = records_[i];
+		LineStructure& line = record.structure;
+		account(line, -1);
+		line.imports.clear();
+		line.functions.clear();
+		line.classes.clear();
+		line.control = 0;
+		if (structured) {
+			size_t tokenEnd = i + 1 < records_.size() ? records_[i + 1].firstToken : stream_.tokens.size();
+			line.control = parser.appendStructure(text_, stream_, record.firstToken, tokenEnd, found);
+			line.imports.swap(found.imports);
+			line.functions.swap(found.functions);
+			line.classes.swap(found.classes);
+		}
+		line.indent = i < stream_.lines.size() && (stream_.lines[i].flags & LINE_NONBLANK) ? stream_.lines[i].leading : -1;
+		account(line, 1);
+	}
+	structureValid_ = false;
+}
+
+/*
+ * Code structure of the current text, joined from the lines (cached until
+ * the next edit)
+ * @return: imports, functions and classes
+ */
+const CodeStructure& AnalysisSession::currentStructure() const {
+	if (structureValid_) {
+		return structure_;
+	}
+
+	structure_ = CodeStructure();
+	structure_.complexity = static_cast<int>(text_.size() / 100);
+	if (!CodeParser::hasStructure(language_)) {
+		structure_.language = "unknown";
+		structureValid_ = true;
+		return structure_;
+	}
+
+	structure_.language = languageName(language_);
+	for (const LineRecord& record : records_) {
+		const LineStructure& line = record.structure;
+		if (line.imports.empty() && line.functions.empty() && line.classes.empty()) {
+			continue;
+		}
+		structure_.imports.insert(structure_.imports.end(), line.imports.begin(), line.imports.end());
+		structure_.functions.insert(structure_.functions.end(), line.functions.begin(), line.functions.end());
+		structure_.classes.insert(structure_.classes.end(), line.classes.begin(), line.classes.end());
+	}
+	int maxIndent = 0;
+	for (size_t level = indentCounts_.size(); level-- > 0;) {
+		if (indentCounts_[level] > 0) {
+			maxIndent = static_cast<int>(level);
+			break;
+		}
+	}
+	structure_.complexity += static_cast<int>(control_) + maxIndent / 2;
+	structureValid_ = true;
+	return structure_;
+}
+
+/*
+ * Analysis result of the current text, from the running line totals
+ * @param options: metrics to include; the budget does not apply
+ * @return: analysis result
+ */
+AnalysisResult AnalysisSession::currentResult(const AnalysisOptions& options) const {
+	MetricCounters totals;
+	totals.lineCount = static_cast<int>(lines_);
+	totals.commentCount = static_cast<int>(comments_);
+	totals.cyclomaticComplexity = 1 + static_cast<int>(cyclomatic_);
+	for (size_t level = nestingCounts_.size(); level-- > 0;) {
+		if (nestingCounts_[level] > 0) {
+			totals.nestingLength = static_cast<int>(level);
+			break;
+		}
+	}
+	for (int bit = 0; bit < 32; ++bit) {
+		if (factCounts_[bit] > 0) {
+			totals.facts |= 1u << bit;
+		}
+	}
+	AnalysisResult result = analyzer_.resultFromMetrics(text_.size(), currentStructure(), language_, totals, options);
+	if (options.countsTokens()) {
+		frequency_.exportTo(result.tokenFrequency, options.topTokens);
+	}
+	return result;
+}
+
+CodeStructure AnalysisSession::structure() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return currentStructure();
+}
+
+AnalysisResult AnalysisSession::result(const AnalysisOptions& options) const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return currentResult(options);
+}
+
+AnalysisReport AnalysisSession::report(const AnalysisOptions& options) const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	AnalysisReport report;
+	report.structure = currentStructure();
+	report.result = currentResult(options);
+	report.qualityScore = analyzer_.calculateQuality(report.result);
+	return report;
+}
+
+std::string AnalysisSession::text() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return text_;
+}
+
+Language AnalysisSession::language() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return language_;
+}
+
+size_t AnalysisSession::lastRelexedLines() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return lastRelexed_;
+}
+
+}  // namespace code_educator
@@ -1,7 +1,207 @@
 #include "Analyzer.hpp"
+#include "CoreStats.hpp"
+#include "DiskCache.hpp"
+#include "ThreadPool.hpp"
+#include "MappedFile.hpp"
+#include "SharedCache.hpp"
+#include <algorithm>
+#include <cstdint>
 
 namespace code_educator {
 
+namespace {
+
+// hash seed that keeps reports computed with different options apart in the
+// cache (0 for the default options); a file name only matters through the
+// extension prior it gives the language detector
+uint64_t optionsSeed(const AnalysisOptions& options) {
+	uint64_t seed = (options.tokenFrequency ? 0 : 1) | (static_cast<uint64_t>(options.topTokens) << 1) |
+		(static_cast<uint64_t>(METRIC_ALL & ~options.metrics) << 56);
+	return seed ^ (LanguageDetector::extensionId(options.fileName) * 0x9E3779B97F4A7C15ull);
+}
+
+// issues findPotentialIssues() reports, in report order
+enum IssueFlag : uint32_t {
+	ISSUE_LONG_CODE = 1 << 0,
+	ISSUE_DEEP_NESTING = 1 << 1,
+	ISSUE_HIGH_CYCLOMATIC = 1 << 2,
+	ISSUE_EVAL = 1 << 3,
+	ISSUE_BARE_EXCEPT = 1 << 4,
+	ISSUE_GLOBAL = 1 << 5,
+	ISSUE_USING_NAMESPACE_STD = 1 << 6,
+	ISSUE_COUNT = 7
+};
+
+const char* const ISSUE_TEXT[ISSUE_COUNT] = {
+	"Code is too long, consider breaking it into smaller functions.",
+	"Code has high nesting length, consider refactoring.",
+	"Code has high cyclomatic complexity, consider refactoring.",
+	"Avoid using eval() for security reasons.",
+	"Consider specifying the exception type in the except clause.",
+	"Avoid using global variables unless necessary.",
+	"Avoid using 'using namespace std;' in header files."
+};
+
+// score deductions of calculateQuality()
+const int ISSUE_PENALTY = 3;
+
+int cyclomaticPenalty(int complexity) {
+	if (complexity > 15) {
+		return 20;  // reduce score for high cyclomatic complexity
+	}
+	if (complexity > 10) {
+		return 10;  // reduce score for moderate cyclomatic complexity
+	}
+	if (complexity > 5) {
+		return 5;   // reduce score for low cyclomatic complexity
+	}
+	return 0;
+}
+
+int commentPenalty(double ratio) {
+	if (ratio < 0.1) {
+		return 10;  // reduce score for low comment ratio
+	}
+	if (ratio < 0.4) {
+		return 5;   // reduce score for high comment ratio
+	}
+	return 0;
+}
+
+int nestingPenalty(int nesting) {
+	if (nesting > 5) {
+		return 15;  // reduce score for high nesting length
+	}
+	if (nesting > 3) {
+		return 8;   // reduce score for moderate nesting length
+	}
+	if (nesting > 1) {
+		return 3;   // reduce score for low nesting length
+	}
+	return 0;
+}
+
+// bytes lexed between two checks of a quality gate or an analysis budget
+const size_t QUALITY_WINDOW_BYTES = 64 * 1024;
+
+// end of the next quality gate window: a line end (or blank) near the window size
+size_t windowEnd(std::string_view code, size_t at) {
+	if (code.size() - at <= QUALITY_WINDOW_BYTES) {
+		return code.size();
+	}
+	std::string_view window = code.substr(at, QUALITY_WINDOW_BYTES);
+	size_t cut = window.rfind('\n');
+	if (cut == std::string_view::npos) {
+		cut = window.find_last_of(" \t");
+	}
+	if (cut != std::string_view::npos) {
+		return at + cut + 1;
+	}
+	// one huge token: take everything up to the next blank
+	size_t next = code.find_first_of(" \t\n", at + QUALITY_WINDOW_BYTES);
+	return next == std::string_view::npos ? code.size() : next + 1;
+}
+
+uint32_t issueFlags(size_t codeLength, Language language, const MetricCounters& metrics) {
+	uint32_t issues = 0;
+
+	// length of the codes
+	if (codeLength > 1000) {
+		issues |= ISSUE_LONG_CODE;
+	}
+
+	// complexity of the code
+	if (metrics.nestingLength > 5) {
+		issues |= ISSUE_DEEP_NESTING;
+	}
+	// cyclomatic complexity
+	if (metrics.cyclomaticComplexity > 10) {
+		issues |= ISSUE_HIGH_CYCLOMATIC;
+	}
+
+	// Check for potential issues based on language
+	if (language == Language::Python) {
+		if (metrics.facts & FACT_EVAL_CALL) {
+			issues |= ISSUE_EVAL;
+		}
+
+		if (metrics.facts & FACT_BARE_EXCEPT) {
+			issues |= ISSUE_BARE_EXCEPT;
+		}
+		else if (metrics.facts & FACT_GLOBAL) {
+			issues |= ISSUE_GLOBAL;
+		}
+	}
+	else if (language == Language::Cpp) {
+		if (metrics.facts & FACT_USING_NAMESPACE_STD) {
+			issues |= ISSUE_USING_NAMESPACE_STD;
+		}
+	}
+	else if (language == Language::JavaScript) {
+		if (metrics.facts & FACT_EVAL_CALL) {
+			issues |= ISSUE_EVAL;
+		}
+	}
+
+	return issues;
+}
+
+// largest total deduction code in a language can get
+int maxDeduction(Language language) {
+	MetricCounters worst;
+	worst.nestingLength = 6;
+	worst.cyclomaticComplexity = 16;
+	worst.facts = ~0u;
+	int issues = __builtin_popcount(issueFlags(SIZE_MAX, language, worst));
+	return cyclomaticPenalty(16) + commentPenalty(0.0) + nestingPenalty(6) + issues * ISSUE_PENALTY;
+}
+
+/*
+ * Find the deduction that puts the score below the threshold
+ * Deductions are added cheapest metric first; with partial counters the
+ * comment ratio is left out, since more lines may still raise it.
+ * @param codeLength: length of the code in bytes
+ * @param language: language of the code
+ * @param metrics: counters so far
+ * @param threshold: lowest passing score
+ * @param complete: final score inputs (nullptr while counting)
+ * @param check: receives the failing bound and its metric
+ * @return: true if the threshold is out of reach
+ */
+bool failureCause(size_t codeLength, Language language, const MetricCounters& metrics, int threshold,
+		const QualityInputs* complete, QualityCheck* check) {
+	uint32_t issues = issueFlags(codeLength, language, metrics);
+	uint32_t otherIssues = issues & ~(ISSUE_LONG_CODE | ISSUE_HIGH_CYCLOMATIC | ISSUE_DEEP_NESTING);
+
+	struct Step {
+		const char* metric;
+		int deduction;
+	};
+	const Step steps[] = {
+		{"code_length", (issues & ISSUE_LONG_CODE) ? ISSUE_PENALTY : 0},
+		{"cyclomatic_complexity", cyclomaticPenalty(metrics.cyclomaticComplexity) +
+			((issues & ISSUE_HIGH_CYCLOMATIC) ? ISSUE_PENALTY : 0)},
+		{"nesting_depth", nestingPenalty(metrics.nestingLength) + ((issues & ISSUE_DEEP_NESTING) ? ISSUE_PENALTY : 0)},
+		{"potential_issues", __builtin_popcount(otherIssues) * ISSUE_PENALTY},
+		{"comment_ratio", complete != nullptr ? commentPenalty(complete->commentRatio) : 0}
+	};
+
+	int score = 100;
+	for (const Step& step : steps) {
+		score -= step.deduction;
+		if (score < threshold) {
+			check->passed = false;
+			check->decidedBy = step.metric;
+			if (complete == nullptr) {
+				check->score = std::max(score, 0);
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+}  // namespace
 
 Analyzer::Analyzer(): parser() {}  // constructor
 
@@ -10,18 +210,275 @@ Analyzer::~Analyzer() {}  // destructor
 /*
  * Analyze code and return the analysis result
  * @param code: code to analyze
+ * @param options: token frequency settings
  * @return: analysis result
  */
-AnalysisResult Analyzer::analyze(const std::string& code) {
+AnalysisResult Analyzer::analyze(std::string_view code, const AnalysisOptions& options) const {
+	StageTimer timer(Stage::Analyze, code.size());
+	if (options.budget.limited()) {
+		return reportWithinBudget(code, options).result;
+	}
+	addCounter(Counter::BytesAnalyzed, code.size());
+	ScratchLease scratch;
+
+	// detect language, tokenize once and parse code structure (if needed)
+	CodeStructure structure = tokenizeAndParse(code, scratch->stream, options);
+
+	// analyze code with structure, reusing the same tokens
+	return analyzeTokens(code, structure, scratch->stream, options, &scratch->tokens);
+}
+
+/*
+ * Parse, analyze and score code in one call
+ * With a cache attached, inputs already seen by this analyzer version are
+ * served from it instead of being analyzed again. The memory cache is looked
+ * up first, then the cache shared with other processes, then the disk
+ * cache; a hit further down is copied into the caches before it.
+ * @param code: code to analyze
+ * @param options: token frequency settings (part of the cache key)
+ * @return: structure, analysis result and quality score
+ */
+AnalysisReport Analyzer::report(std::string_view code, const AnalysisOptions& options) const {
+	StageTimer timer(Stage::Report, code.size());
+	if (!cache_ && !sharedCache_ && !diskCache_) {
+		return computeReport(code, options);
+	}
+
+	CacheKey key;
+	key.hash = hashContent(code, optionsSeed(options));
+	key.version = ANALYZER_VERSION;
+
+	std::shared_ptr<const AnalysisReport> hit = cache_ ? cache_->find(key) : nullptr;
+	if (hit) {
+		addCounter(Counter::CacheHits);
+		AnalysisReport copy = *hit;
+		copy.cached = true;
+		return copy;
+	}
+	if (sharedCache_) {
+		std::shared_ptr<AnalysisReport> shared = sharedCache_->find(key);
+		if (shared) {
+			addCounter(Counter::SharedCacheHits);
+			if (cache_) {
+				cache_->insert(key, shared);
+			}
+			AnalysisReport copy = *shared;
+			copy.cached = true;
+			return copy;
+		}
+	}
+	if (diskCache_) {
+		std::shared_ptr<AnalysisReport> stored = diskCache_->find(key);
+		if (stored) {
+			addCounter(Counter::DiskCacheHits);
+			if (sharedCache_) {
+				sharedCache_->insert(key, *stored);
+			}
+			if (cache_) {
+				cache_->insert(key, stored);
+			}
+			AnalysisReport copy = *stored;
+			copy.cached = true;
+			return copy;
+		}
+	}
+
+	addCounter(Counter::CacheMisses);
+	auto computed = std::make_shared<AnalysisReport>(computeReport(code, options));
+	if (!computed->result.truncated) {
+		if (diskCache_) {
+			diskCache_->insert(key, *computed);
+		}
+		if (sharedCache_) {
+			sharedCache_->insert(key, *computed);
+		}
+		if (cache_) {
+			cache_->insert(key, computed);
+		}
+	}
+	return *computed;
+}
+
+/*
+ * Analyze a file without reading it into memory first
+ * The file is mapped read-only and analyzed in place.
+ * @param path: file to analyze (its extension hints the language)
+ * @param options: token frequency settings
+ * @return: structure, analysis result and quality score
+ */
+AnalysisReport Analyzer::analyzeFile(const std::string& path, const AnalysisOptions& options) const {
+	MappedFile file(path);
+	if (!options.fileName.empty()) {
+		return report(file.view(), options);
+	}
+	AnalysisOptions named = options;
+	named.fileName = path;
+	return report(file.view(), named);
+}
+
+/*
+ * Add the identifiers of code to a token sketch
+ * @param code: code to sketch
+ * @param sketch: sketch to add to
+ * @param language: language name, or empty to detect it
+ */
+void Analyzer::sketchTokens(std::string_view code, TokenSketch& sketch, const std::string& language) const {
+	Lexer lexer(languageFromName(language.empty() ? parser.detectLanguage(code) : language));
+	TokenStream stream = lexer.tokenize(code);
+	for (const Token& token : stream.tokens) {
+		if (token.type == TokenType::Identifier) {
+			sketch.add(std::string_view(code.data() + token.offset, token.length));
+		}
+	}
+}
+
+AnalysisReport Analyzer::computeReport(std::string_view code, const AnalysisOptions& options) const {
+	if (options.budget.limited()) {
+		return reportWithinBudget(code, options);
+	}
+	addCounter(Counter::BytesAnalyzed, code.size());
+	AnalysisReport report;
+	ScratchLease scratch;
+	const TokenStream& stream = scratch->stream;
+	report.structure = tokenizeAndParse(code, scratch->stream, options);
+
+	// the score needs the metric pass whatever the result keeps
+	MetricEngine engine(stream.language);
+	engine.setTokenFrequency(options.countsTokens());
+	std::swap(engine.counters().tokenFrequency, scratch->tokens);
+	{
+		StageTimer timer(Stage::Metrics, code.size());
+		engine.consume(code.data(), stream);
+	}
+	report.result = resultFromMetrics(code.length(), report.structure, stream.language, engine.counters(), options);
+	report.qualityScore = calculateQuality(qualityInputs(code.length(), stream.language, engine.counters()));
+	std::swap(engine.counters().tokenFrequency, scratch->tokens);
+	return report;
+}
+
+/*
+ * Compute a report under a time, memory and cancellation budget
+ * The input is lexed and measured a window at a time, like checkQuality(),
+ * and the budget is checked before each window, and again while the
+ * structure is searched. Once it runs out the rest of the input is skipped:
+ * the structure and metrics cover what was read, and the result is flagged
+ * as truncated. Issues that depend on the length
+ * alone still see the whole input.
+ * @param code: code to analyze
+ * @param options: metrics to compute and the budget
+ * @return: structure, analysis result and quality score (possibly partial)
+ */
+AnalysisReport Analyzer::reportWithinBudget(std::string_view code, const AnalysisOptions& options) const {
+	BudgetTracker tracker(options.budget);
+	AnalysisReport report;
+	ScratchLease scratch;
+
+	Language language = parser.guessLanguage(code, options.fileName).language;
+	Lexer lexer(language);
+	MetricEngine engine(language);
+	engine.setTokenFrequency(options.countsTokens());
+	std::swap(engine.counters().tokenFrequency, scratch->tokens);
+	bool keepTokens = options.needsStructure();
+	LexState state;
+	TokenStream& stream = scratch->stream;
+	TokenStream& piece = scratch->piece;
+	stream.language = language;
+	piece.language = language;
+
+	auto memoryHeld = [&]() {
+		return (stream.tokens.capacity() + piece.tokens.capacity()) * sizeof(Token) +
+			(stream.lines.capacity() + piece.lines.capacity()) * sizeof(LineInfo) +
+			engine.counters().tokenFrequency.memoryUsage();
+	};
+	auto take = [&]() {
+		engine.consume(code.data(), piece);
+		if (keepTokens) {
+			stream.tokens.insert(stream.tokens.end(), piece.tokens.begin(), piece.tokens.end());
+			stream.lines.insert(stream.lines.end(), piece.lines.begin(), piece.lines.end());
+		}
+		piece.tokens.clear();
+		piece.lines.clear();
+	};
+
+	size_t at = 0;
+	while (at < code.size() && !tracker.exhausted(memoryHeld())) {
+		size_t end = windowEnd(code, at);
+		lexer.scan(code.data() + at, end - at, at, state, piece);
+		if (end == code.size()) {
+			lexer.finish(state, piece);
+		}
+		take();
+		at = end;
+	}
+	if (at < code.size()) {
+		// close the line the last window stopped in
+		lexer.finish(state, piece);
+		take();
+	}
+	addCounter(Counter::BytesAnalyzed, at);
+
+	std::string_view read = code.substr(0, at);
+	if (keepTokens) {
+		report.structure = parser.structureOf(read, stream, tracker, memoryHeld());
+	}
+	else {
+		report.structure.language = CodeParser::hasStructure(language) ? languageName(language) : "unknown";
+		report.structure.complexity = 0;
+	}
+	report.result = resultFromMetrics(code.length(), report.structure, language, engine.counters(), options);
+	report.result.bytesAnalyzed = at;
+	if (tracker.stop() != BudgetStop::None) {
+		report.result.truncated = true;
+		report.result.truncatedBy = budgetStopName(tracker.stop());
+	}
+	report.qualityScore = calculateQuality(qualityInputs(code.length(), language, engine.counters()));
+	std::swap(engine.counters().tokenFrequency, scratch->tokens);
+	return report;
+}
+
+/*
+ * Tokenize code and extract its structure
+ * Without METRIC_STRUCTURE or METRIC_SUGGESTIONS only the language is set.
+ * @param code: code to tokenize
+ * @param stream: receives the tokens
+ * @param options: metrics to compute
+ * @return: code structure
+ */
+CodeStructure Analyzer::tokenizeAndParse(std::string_view code, TokenStream& stream, const AnalysisOptions& options) const {
+	if (options.needsStructure()) {
+		return parser.parse(code, stream, options.fileName);
+	}
 
-	// detect language
-	std::string language = parser.detectLanguage(code);
+	Lexer lexer(parser.guessLanguage(code, options.fileName).language);
+	lexer.tokenize(code, stream);
+	CodeStructure structure;
+	structure.language = CodeParser::hasStructure(stream.language) ? languageName(stream.language) : "unknown";
+	structure.complexity = 0;
+	return structure;
+}
 
-	// parse code structure
-	CodeStructure structure = parser.parse(code);
+/*
+ * Attach a result cache
+ * @param cache: cache to use in report(), or nullptr to disable caching
+ */
+void Analyzer::setCache(std::shared_ptr<ResultCache> cache) {
+	cache_ = std::move(cache);
+}
 
-	// analyze code with structure
-	return analyzeWithSturcture(code, structure);
+/*
+ * Attach a persistent result cache
+ * @param cache: disk cache to use in report(), or nullptr to disable it
+ */
+void Analyzer::setDiskCache(std::shared_ptr<DiskCache> cache) {
+	diskCache_ = std::move(cache);
+}
+
+/*
+ * Attach a result cache shared with other processes
+ * @param cache: shared cache to use in report(), or nullptr to disable it
+ */
+void Analyzer::setSharedCache(std::shared_ptr<SharedCache> cache) {
+	sharedCache_ = std::move(cache);
 }
 
 /*
@@ -30,29 +487,109 @@ AnalysisResult Analyzer::analyze(const std::string& code) {
  * @param structure: code structure
  * @return: analysis result
  */
-AnalysisResult Analyzer::analyzeWithSturcture(const std::string& code, const CodeStructure& structure) {
+AnalysisResult Analyzer::analyzeWithSturcture(std::string_view code, const CodeStructure& structure) const {
+	Lexer lexer(languageFromName(structure.language));
+	return analyzeTokens(code, structure, lexer.tokenize(code));
+}
+
+/*
+ * Analyze a batch of inputs in parallel
+ * @param codes: codes to analyze
+ * @param threads: maximum number of threads to use (0: every pool worker)
+ * @param options: metrics to compute
+ * @return: analysis results, in input order
+ */
+std::vector<AnalysisResult> Analyzer::analyzeBatch(const std::vector<std::string_view>& codes, size_t threads,
+		const AnalysisOptions& options) const {
+	std::vector<AnalysisResult> results(codes.size());
+	ThreadPool::shared().parallelFor(codes.size(), [&](size_t i) {
+		results[i] = analyze(codes[i], options);
+	}, threads);
+	return results;
+}
+
+/*
+ * Compute every metric from one token stream
+ * Line, comment, nesting, cyclomatic and token counts all come from a single
+ * MetricEngine pass; issues and suggestions reuse those values. The pass is
+ * skipped when only the structure is requested.
+ * @param code: code to analyze
+ * @param structure: code structure
+ * @param stream: tokens of code
+ * @param options: metrics and token frequency settings
+ * @return: analysis result
+ */
+AnalysisResult Analyzer::analyzeTokens(std::string_view code, const CodeStructure& structure, const TokenStream& stream,
+		const AnalysisOptions& options, TokenCounter* counts) const {
+	MetricEngine engine(stream.language);
+	if (counts != nullptr) {
+		std::swap(engine.counters().tokenFrequency, *counts);
+	}
+	if (options.wants(METRIC_ALL & ~METRIC_STRUCTURE)) {
+		StageTimer timer(Stage::Metrics, code.size());
+		engine.setTokenFrequency(options.countsTokens());
+		engine.consume(code.data(), stream);
+	}
+	AnalysisResult result = resultFromMetrics(code.length(), structure, stream.language, engine.counters(), options);
+	if (counts != nullptr) {
+		std::swap(engine.counters().tokenFrequency, *counts);
+	}
+	return result;
+}
+
+/*
+ * Build the analysis result from finished metric counters
+ * @param codeLength: length of the analyzed code in bytes
+ * @param structure: code structure
+ * @param language: language the code was tokenized as
+ * @param metrics: counters of the whole code
+ * @param options: metrics to fill in and how many counted tokens to keep
+ * @return: analysis result
+ */
+AnalysisResult Analyzer::resultFromMetrics(size_t codeLength, const CodeStructure& structure, Language language, const MetricCounters& metrics,
+		const AnalysisOptions& options) const {
 	AnalysisResult result;
+	result.bytesAnalyzed = codeLength;
 
-	result.lineCount = countLines(code);
-	result.commentCount = countComments(code, structure.language);
-	if (result.lineCount > 0) {
-		result.commentRatio = static_cast<double>(result.commentCount) / result.lineCount;
-	} else {
-		result.commentRatio = 0.0;  // avoid division by zero
+	if (options.wants(METRIC_LINES)) {
+		result.lineCount = metrics.lineCount;
+	}
+	if (options.wants(METRIC_COMMENTS)) {
+		result.commentCount = metrics.commentCount;
+		if (metrics.lineCount > 0) {
+			result.commentRatio = static_cast<double>(metrics.commentCount) / metrics.lineCount;
+		} else {
+			result.commentRatio = 0.0;  // avoid division by zero
+		}
+	}
+	if (options.wants(METRIC_NESTING)) {
+		result.nestingLength = metrics.nestingLength;
+	}
+	if (options.wants(METRIC_CYCLOMATIC)) {
+		result.cyclomaticComplexity = metrics.cyclomaticComplexity;
+	}
+	if (options.countsTokens()) {
+		StageTimer timer(Stage::TokenTable);
+		metrics.tokenFrequency.exportTo(result.tokenFrequency, options.topTokens);
+	}
+	if (options.wants(METRIC_ISSUES)) {
+		StageTimer timer(Stage::Issues);
+		result.potentialIssues = findPotentialIssues(codeLength, language, metrics);
 	}
-	result.nestingLength = calculateNestingLength(code, structure.language);
-	result.cyclomaticComplexity = calculateCyclomaticComplexity(code, structure.language);
-	result.tokenFrequency = calculateTokenFrequency(code);
-	result.potentialIssues = findPotentialIssues(code, structure.language);
 
 	// generate suggestions
-	result.suggestions = generateSuggestions(code, structure);
+	if (options.wants(METRIC_SUGGESTIONS)) {
+		StageTimer timer(Stage::Suggestions);
+		result.suggestions = suggestionsFor(structure, metrics);
+	}
 
 	// add metadata
-	result.metadata["language"] = structure.language;
-	result.metadata["function_count"] = std::to_string(structure.functions.size());
-	result.metadata["class_count"] = std::to_string(structure.classes.size());
-	result.metadata["import_count"] = std::to_string(structure.imports.size());
+	if (options.wants(METRIC_STRUCTURE)) {
+		result.metadata["language"] = structure.language;
+		result.metadata["function_count"] = std::to_string(structure.functions.size());
+		result.metadata["class_count"] = std::to_string(structure.classes.size());
+		result.metadata["import_count"] = std::to_string(structure.imports.size());
+	}
 
 	return result;
 }
@@ -62,43 +599,29 @@ AnalysisResult Analyzer::analyzeWithSturcture(const std::string& code, const Cod
  * @param result: analysis result
  * @return: quality score (0 to 100)
  */
-int Analyzer::calculateQuality(const AnalysisResult& result) {
+int Analyzer::calculateQuality(const AnalysisResult& result) const {
+	QualityInputs inputs;
+	inputs.cyclomaticComplexity = result.cyclomaticComplexity;
+	inputs.commentRatio = result.commentRatio;
+	inputs.nestingLength = result.nestingLength;
+	inputs.issueCount = result.potentialIssues.size();
+	return calculateQuality(inputs);
+}
+
+/*
+ * Calculate the quality of the code from the score inputs alone
+ * @param inputs: complexity, comment ratio, nesting and issue count
+ * @return: quality score (0 to 100)
+ */
+int Analyzer::calculateQuality(const QualityInputs& inputs) const {
 	// Basic score is 100 (highest)
 	int score = 100;
 
 	// Calculate the quality based on various metrics
-	// 1. cyclomatic complexity
-	if (result.cyclomaticComplexity > 15) {
-		score -= 20;  // reduce score for high cyclomatic complexity
-	}
-	else if (result.cyclomaticComplexity > 10) {
-		score -= 10;  // reduce score for moderate cyclomatic complexity
-	}
-	else if (result.cyclomaticComplexity > 5) {
-		score -= 5;  // reduce score for low cyclomatic complexity
-	}
-
-	// 2. comment ratio
-	if (result.commentRatio < 0.1) {
-		score -= 10;  // reduce score for low comment ratio
-	}
-	else if (result.commentRatio < 0.4) {
-		score -= 5;  // reduce score for high comment ratio
-	}
-
-	// 3. nesting length
-	if (result.nestingLength > 5) {
-		score -= 15;  // reduce score for high nesting length
-	}
-	else if (result.nestingLength > 3) {
-		score -= 8;  // reduce score for moderate nesting length
-	}
-	else if (result.nestingLength > 1) {
-		score -= 3;  // reduce score for low nesting length
-	}
-
-	// 4. potential issues
-	score -= result.potentialIssues.size() * 3;  // reduce score for each potential issue
+	score -= cyclomaticPenalty(inputs.cyclomaticComplexity);
+	score -= commentPenalty(inputs.commentRatio);
+	score -= nestingPenalty(inputs.nestingLength);
+	score -= static_cast<int>(inputs.issueCount) * ISSUE_PENALTY;  // reduce score for each potential issue
 
 	if (score < 0) {
 		score = 0;  // ensure score is not negative
@@ -109,14 +632,112 @@ int Analyzer::calculateQuality(const AnalysisResult& result) {
 	return score;
 }
 
+/*
+ * Check code against a quality threshold
+ * The score only goes down from 100 and every deduction but the comment
+ * ratio only grows as more code is read, so the input is lexed and measured
+ * a window at a time and the check stops once the deductions so far already
+ * put the score below the threshold. Deductions are tallied cheapest first
+ * (code length, cyclomatic complexity, nesting, other issues, comment ratio)
+ * and the one that crosses the threshold is reported as deciding.
+ * @param code: code to check
+ * @param threshold: lowest passing score
+ * @param fileName: name whose extension hints the language (may be empty)
+ * @return: outcome, the metric that decided it and how much was read
+ */
+QualityCheck Analyzer::checkQuality(std::string_view code, int threshold, std::string_view fileName) const {
+	StageTimer timer(Stage::QualityGate, code.size());
+	QualityCheck check;
+	check.threshold = threshold;
+
+	Language language = parser.guessLanguage(code, fileName).language;
+
+	// decided before reading anything: nothing can fail it, or nothing can pass
+	int floor = std::max(0, 100 - maxDeduction(language));
+	if (threshold <= floor || threshold > 100) {
+		check.passed = threshold <= floor;
+		check.score = check.passed ? floor : 100;
+		check.decidedBy = "threshold";
+		return check;
+	}
+
+	Lexer lexer(language);
+	MetricEngine engine(language);
+	engine.setTokenFrequency(false);
+	LexState state;
+	TokenStream piece;
+	piece.language = language;
+
+	size_t at = 0;
+	for (;;) {
+		// the length alone may already decide it
+		if (failureCause(code.size(), language, engine.counters(), threshold, nullptr, &check)) {
+			check.bytesAnalyzed = at;
+			return check;
+		}
+		if (at == code.size()) {
+			break;
+		}
+
+		size_t end = windowEnd(code, at);
+		piece.tokens.clear();
+		piece.lines.clear();
+		lexer.scan(code.data() + at, end - at, at, state, piece);
+		if (end == code.size()) {
+			lexer.finish(state, piece);
+		}
+		engine.consume(code.data(), piece);
+		at = end;
+	}
+
+	// every metric is known: score it exactly like report()
+	QualityInputs inputs = qualityInputs(code.size(), language, engine.counters());
+	check.complete = true;
+	check.bytesAnalyzed = code.size();
+	check.score = calculateQuality(inputs);
+	check.passed = check.score >= threshold;
+	if (check.passed) {
+		check.decidedBy = "all";
+	}
+	else {
+		failureCause(code.size(), language, engine.counters(), threshold, &inputs, &check);
+	}
+	return check;
+}
+
+/*
+ * Check a file against a quality threshold
+ * @param path: file to check (memory-mapped and read in place)
+ * @param threshold: lowest passing score
+ * @return: outcome of checkQuality()
+ */
+QualityCheck Analyzer::checkQualityFile(const std::string& path, int threshold) const {
+	MappedFile file(path);
+	return checkQuality(file.view(), threshold, path);
+}
+
 /*
  * Generate suggestions based on code structure
  * @param code: code to analyze
  * @param structure: code structure
  * @return: suggestions for improvement
  */
-std::vector<std::string> Analyzer::generateSuggestions(const std::string& code, const CodeStructure& structure) {
+std::vector<std::string> Analyzer::generateSuggestions(std::string_view code, const CodeStructure& structure) const {
+	Lexer lexer(languageFromName(structure.language));
+	MetricEngine engine(lexer.language());
+	engine.consume(code.data(), lexer.tokenize(code));
+	return suggestionsFor(structure, engine.counters());
+}
+
+/*
+ * Suggestions from the code structure and the facts found while counting
+ * @param structure: code structure
+ * @param metrics: counters of the metric pass
+ * @return: suggestions for improvement
+ */
+std::vector<std::string> Analyzer::suggestionsFor(const CodeStructure& structure, const MetricCounters& metrics) const {
 	std::vector<std::string> suggestions;
+	uint32_t facts = metrics.facts;
 
 	// 1. complexity
 	if (structure.complexity > 10) {
@@ -138,34 +759,34 @@ std::vector<std::string> Analyzer::generateSuggestions(const std::string& code,
 
 	// 5. Suggestion based on language
 	if (structure.language == "python") {
-		if (code.find("except:") != std::string::npos) {
+		if (facts & FACT_BARE_EXCEPT) {
 			suggestions.push_back("Consider specifying the exception type in the except clause.");
 		}
-		else if (code.find("global ") != std::string::npos) {
+		else if (facts & FACT_GLOBAL) {
 			suggestions.push_back("Avoid using global variables unless necessary.");
 		}
 	}
 	else if (structure.language == "cpp") {
-		if (code.find("new") != std::string::npos && code.find("delete") == std::string::npos) {
+		if ((facts & FACT_NEW) && !(facts & FACT_DELETE)) {
 			suggestions.push_back("Consider using smart pointers to manage memory.");
 		}
-		else if (code.find("using namespace std;") != std::string::npos) {
+		else if (facts & FACT_USING_NAMESPACE_STD) {
 			suggestions.push_back("Avoid using 'using namespace std;' in header files.");
 		}
 	}
 	else if (structure.language == "javascript") {
-		if (code.find("var ") != std::string::npos) {
+		if (facts & FACT_VAR) {
 			suggestions.push_back("Consider using 'let' or 'const' instead of 'var'.");
 		}
-		else if (code.find("==") != std::string::npos) {
+		else if (facts & FACT_LOOSE_EQUALITY) {
 			suggestions.push_back("Consider using '===' for strict equality comparison.");
 		}
 	}
 	else if (structure.language == "c") {
-		if (code.find("malloc") != std::string::npos && code.find("free") == std::string::npos) {
+		if ((facts & FACT_MALLOC) && !(facts & FACT_FREE)) {
 			suggestions.push_back("Consider using 'free' to deallocate memory allocated with 'malloc'.");
 		}
-		else if (code.find("strcpy") != std::string::npos) {
+		else if (facts & FACT_STRCPY) {
 			suggestions.push_back("Consider using 'strncpy' to avoid buffer overflow.");
 		}
 	}
@@ -178,13 +799,14 @@ std::vector<std::string> Analyzer::generateSuggestions(const std::string& code,
  * @param code: code to analyze
  * @return: analysis result
  */
-AnalysisResult Analyzer::analyzePython(const std::string& code) {
-	CodeStructure structure = parser.parse(code);
+AnalysisResult Analyzer::analyzePython(std::string_view code) const {
+	TokenStream stream;
+	CodeStructure structure = parser.parse(code, stream);
 
 	if (structure.language != "python") {
 		throw std::runtime_error("Language mismatch: expected Python");
 	}
-	return analyzeWithSturcture(code, structure);
+	return analyzeTokens(code, structure, stream);
 }
 
 /*
@@ -192,13 +814,14 @@ AnalysisResult Analyzer::analyzePython(const std::string& code) {
  * @param code: code to analyze
  * @return: analysis result
  */
-AnalysisResult Analyzer::analyzeCpp(const std::string& code) {
-	CodeStructure structure = parser.parse(code);
+AnalysisResult Analyzer::analyzeCpp(std::string_view code) const {
+	TokenStream stream;
+	CodeStructure structure = parser.parse(code, stream);
 
 	if (structure.language != "cpp") {
 		throw std::runtime_error("Language mismatch: expected C++");
 	}
-	return analyzeWithSturcture(code, structure);
+	return analyzeTokens(code, structure, stream);
 }
 
 /*
@@ -206,13 +829,14 @@ AnalysisResult Analyzer::analyzeCpp(const std::string& code) {
  * @param code: code to analyze
  * @return: analysis result
  */
-AnalysisResult Analyzer::analyzeJavaScript(const std::string& code) {
-	CodeStructure structure = parser.parse(code);
+AnalysisResult Analyzer::analyzeJavaScript(std::string_view code) const {
+	TokenStream stream;
+	CodeStructure structure = parser.parse(code, stream);
 
 	if (structure.language != "javascript") {
 		throw std::runtime_error("Language mismatch: expected JavaScript");
 	}
-	return analyzeWithSturcture(code, structure);
+	return analyzeTokens(code, structure, stream);
 }
 
 /*
@@ -220,293 +844,44 @@ AnalysisResult Analyzer::analyzeJavaScript(const std::string& code) {
  * @param code: code to analyze
  * @return: analysis result
  */
-AnalysisResult Analyzer::analyzeC(const std::string& code) {
-	CodeStructure structure = parser.parse(code);
+AnalysisResult Analyzer::analyzeC(std::string_view code) const {
+	TokenStream stream;
+	CodeStructure structure = parser.parse(code, stream);
 
 	if (structure.language != "c") {
 		throw std::runtime_error("Language mismatch: expected C");
 	}
-	return analyzeWithSturcture(code, structure);
+	return analyzeTokens(code, structure, stream);
 }
 
-/*
- * Count lines of code
- * @param code: code to analyze
- * @return: number of lines in the code
- */
-int Analyzer::countLines(const std::string& code) {
-	std::istringstream stream(code);
-	std::string line;
-	int count = 0;
-
-	while (std::getline(stream, line)) {
-		if (!line.empty() && line.find_first_not_of(" \t\r\n") != std::string::npos) {
-			count++;
+// to find the potential issues in the code based on language
+std::vector<std::string> Analyzer::findPotentialIssues(size_t codeLength, Language language, const MetricCounters& metrics) const {
+	std::vector<std::string> issues;
+	uint32_t flags = issueFlags(codeLength, language, metrics);
+	for (uint32_t i = 0; i < ISSUE_COUNT; ++i) {
+		if (flags & (1u << i)) {
+			issues.push_back(ISSUE_TEXT[i]);
 		}
 	}
-	return count;
+	return issues;
 }
 
 /*
- * Count comments in the code (single line and multiline)
- * @param code: code to analyze
- * @param language: language of the code
- * @return: number of comments in the code
+ * Score inputs from metric counters
+ * @param codeLength: length of the code in bytes
+ * @param language: language the code was tokenized as
+ * @param metrics: counters of the whole code
+ * @return: inputs of calculateQuality()
  */
-int Analyzer::countComments(const std::string& code, const std::string& language) {
-	int count = 0;
-	bool multilineComment = false;
-	std::istringstream stream(code);
-	std::string line;
-
-	// comment for python
-	if (language == "python") {
-		while (std::getline(stream, line)) {
-			if (line.find("#") != std::string::npos) {
-				count++;
-			}
-		}
-
-		if (line.find("'''") != std::string::npos || line.find("\"\"\"") != std::string::npos) {
-			multilineComment = !multilineComment;
-			count++;
-		}
-		if (multilineComment) {
-			count++;
-		}
-	}
-	// c, cpp and javascript are same format of comments
-	else if (language == "cpp" || language == "c" || language == "javascript") {
-		while (std::getline(stream, line)) {
-			if (line.find("//") != std::string::npos) {
-				count++;
-			}
-			if (line.find("/*") != std::string::npos && line.find("*/") != std::string::npos) {  // single line comment /* like this */
-				count++;
-			}
-			if (line.find("/*") != std::string::npos) {
-				multilineComment = true;
-			}
-			if (multilineComment) {
-				count++;
-			}
-			if (line.find("*/") != std::string::npos) {  // close multiline comment
-				multilineComment = false;
-			}
-		}
-	}
-	else {
-		throw std::runtime_error("Unsupported language for comment counting");
-	}
-	return count;
-}
-
-int Analyzer::calculateNestingLength(const std::string& code, const std::string& language) {
-	int maxDepth = 0;
-	int currentDepth = 0;
-	std::istringstream stream(code);
-	std::string line;
-
-	if (language == "python") {
-		int prevIndent = 0;
-
-		while (std::getline(stream, line)) {
-			// skip empty lines
-			if (line.empty() || line.find_first_not_of(" \t") == std::string::npos) {
-				continue;
-			}
-
-			// count indentation
-			int indent = 0;
-			for (size_t i = 0; i < line.size(); ++i) {
-				char c = line[i];
-				if (c == ' ') {  // single space
-					indent++;
-				}
-				else if (c == '\t') {  // tab, assuming tab is 4 spaces
-					indent += 4;
-				}
-				else {
-					break;
-				}
-			}
-
-			if (indent > prevIndent) {
-				currentDepth += (indent - prevIndent) / 4;  // assuming 4 spaces per indent
-			}
-			else if (indent < prevIndent) {
-				currentDepth -= (prevIndent - indent) / 4;  // assuming 4 spaces per indent
-			}
-
-			prevIndent = indent;
-			maxDepth = std::max(maxDepth, currentDepth);
-		}
-	}
-	else {  // c, c++ and javascript
-		bool inString = false;
-		bool inChar = false;
-		bool inComment = false;
-
-		while (std::getline(stream, line)) {
-			for (size_t i = 0; i < line.size(); i++) {
-				char c = line[i];
-
-				if (c == '"' && !inChar && !inComment) {
-					if (i > 0 && line[i - 1] != '\\') continue; // skip escaped quotes
-					inString = !inString;
-					continue;
-				}
-
-				if (c == '\'' && !inString && !inComment) {
-					if (i > 0 && line[i - 1] != '\\') continue; // skip escaped quotes
-					inChar = !inChar;
-					continue;
-				}
-
-				if (i < line.size() - 1 && c == '/' && line[i + 1] == '/' && !inString && !inChar) {
-					break;  // single line comment
-				}
-				if (i < line.size() - 1 && c == '/' && line[i + 1] == '*' && !inString && !inChar) {
-					inComment = true;
-					continue;
-				}
-
-				if (i > 0 && c == '*' && line[i - 1] == '/' && inComment) {
-					inComment = false;
-					continue;
-				}
-
-				if (inString || inChar || inComment) {
-					continue;
-				}
-
-				// {} indentation
-				if (c == '{') {
-					currentDepth++;
-					maxDepth = std::max(maxDepth, currentDepth);
-				}
-				else if (c == '}') {
-					currentDepth--;
-					maxDepth = std::max(maxDepth, currentDepth);
-				}
-			}
-		}
-	}
-
-	return maxDepth;
-}
-
-int Analyzer::calculateCyclomaticComplexity(const std::string& code, const std::string& language) {
-	int complexity = 1;  // start with 1 for the function itself
-
-	// some regex of complexity
-	std::regex if_regex("if\\s*\\(.*\\)");
-	std::regex for_regex("for\\s*\\(.*\\)");
-	std::regex while_regex("while\\s*\\(.*\\)");
-	std::regex case_regex("case\\s+.*:");
-	std::regex switch_regex("switch\\s*\\(.*\\)");
-	std::regex and_regex("&&");
-	std::regex or_regex("\\|\\|");
-	std::regex tenary_regex("\\?");
-
-	// python
-	std::regex except_regex("except\\s*\\(.*\\)");
-	// C++ and JavaScript
-	std::regex catch_regex("catch\\s*\\(.*\\)");
-	// C and C++
-	std::regex goto_regex("goto\\s+\\w+");
-
-	// search for control structures start and end
-	std::string::const_iterator searchStart(code.cbegin());
-	std::string::const_iterator searchEnd(code.cend());
-
-	// calculate complexity based on control structures
-	complexity += std::distance(std::sregex_iterator(searchStart, searchEnd, if_regex), std::sregex_iterator());
-	complexity += std::distance(std::sregex_iterator(searchStart, searchEnd, for_regex), std::sregex_iterator());
-	complexity += std::distance(std::sregex_iterator(searchStart, searchEnd, while_regex), std::sregex_iterator());
-	complexity += std::distance(std::sregex_iterator(searchStart, searchEnd, case_regex), std::sregex_iterator());
-	complexity += std::distance(std::sregex_iterator(searchStart, searchEnd, switch_regex), std::sregex_iterator());
-	complexity += std::distance(std::sregex_iterator(searchStart, searchEnd, and_regex), std::sregex_iterator());
-	complexity += std::distance(std::sregex_iterator(searchStart, searchEnd, or_regex), std::sregex_iterator());
-	complexity += std::distance(std::sregex_iterator(searchStart, searchEnd, tenary_regex), std::sregex_iterator());
-	complexity += std::distance(std::sregex_iterator(searchStart, searchEnd, except_regex), std::sregex_iterator());
-	complexity += std::distance(std::sregex_iterator(searchStart, searchEnd, catch_regex), std::sregex_iterator());
-
-	// special case for python
-	if (language == "python") {
-		complexity += std::distance(std::sregex_iterator(searchStart, searchEnd, except_regex), std::sregex_iterator());
-	}
-	else if (language == "c" || language == "cpp") {  // there's no catch in c
-		complexity += std::distance(std::sregex_iterator(searchStart, searchEnd, goto_regex), std::sregex_iterator());
-	}
-	else if (language == "javascript" || language == "cpp") {  // there's no goto in javascript
-		complexity += std::distance(std::sregex_iterator(searchStart, searchEnd, catch_regex), std::sregex_iterator());
-	}
-
-	return complexity;
-}
-
-// To calculate the token frequency
-std::map<std::string, int> Analyzer::calculateTokenFrequency(const std::string& code) {
-	std::map<std::string, int> frequency;
-	std::regex word_regex("\\b[a-zA-Z_][a-zA-Z0-9_]*\\b");
-
-	auto words_begin = std::sregex_iterator(code.begin(), code.end(), word_regex);
-	auto words_end = std::sregex_iterator();
-
-	for (std::sregex_iterator i = words_begin; i != words_end; ++i) {
-		std::string word = (*i).str();
-		frequency[word]++;
-	}
-
-	return frequency;
-}
-
-// to find the potential issues in the code based on language
-std::vector<std::string> Analyzer::findPotentialIssues(const std::string& code, const std::string& language) {
-	std::vector<std::string> issues;
-
-	// length of the codes
-	if (code.length() > 1000) {
-		issues.push_back("Code is too long, consider breaking it into smaller functions.");
-	}
-
-	// complexity of the code
-	int nestingLength = calculateNestingLength(code, language);
-	if (nestingLength > 5) {
-		issues.push_back("Code has high nesting length, consider refactoring.");
-	}
-	// cyclomatic complexity
-	int cycComplexity = calculateCyclomaticComplexity(code, language);
-	if (cycComplexity > 10) {
-		issues.push_back("Code has high cyclomatic complexity, consider refactoring.");
-	}
-
-	// Check for potential issues based on language
-	if (language == "python") {
-		if (code.find("eval(") != std::string::npos) {
-			issues.push_back("Avoid using eval() for security reasons.");
-		}
-
-		if (code.find("except") != std::string::npos) {
-			issues.push_back("Consider specifying the exception type in the except clause.");
-		}
-		else if (code.find("global ") != std::string::npos) {
-			issues.push_back("Avoid using global variables unless necessary.");
-		}
-	}
-	else if (language == "cpp") {
-		if (code.find("using namespace std;") != std::string::npos) {
-			issues.push_back("Avoid using 'using namespace std;' in header files.");
-		}
-	}
-	else if (language == "javascript") {
-		if (code.find("eval(") != std::string::npos) {
-			issues.push_back("Avoid using eval() for security reasons.");
-		}
-	}
-
-	return issues;
+QualityInputs Analyzer::qualityInputs(size_t codeLength, Language language, const MetricCounters& metrics) const {
+	QualityInputs inputs;
+	inputs.cyclomaticComplexity = metrics.cyclomaticComplexity;
+	if (metrics.lineCount > 0) {
+		inputs.commentRatio = static_cast<double>(metrics.commentCount) / metrics.lineCount;
+	}
+	inputs.nestingLength = metrics.nestingLength;
+	inputs.issueCount = static_cast<size_t>(__builtin_popcount(issueFlags(codeLength, language, metrics)));
+	return inputs;
 }
 
 }  // namespace code_educator
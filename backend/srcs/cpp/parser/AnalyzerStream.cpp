@@ -0,0 +1,193 @@
+#include "AnalyzerStream.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace code_educator {
+
+namespace {
+
+// Where the bytes of [from, text.size()) can be cut for the lexer: right after
+// the last line end, else right after the last blank. 0 if neither is found.
+size_t cutPoint(std::string_view text, size_t from) {
+	std::string_view tail = text.substr(from);
+	size_t at = tail.rfind('\n');
+	if (at == std::string_view::npos) {
+		at = tail.find_last_of(" \t");
+	}
+	return at == std::string_view::npos ? 0 : from + at + 1;
+}
+
+}  // namespace
+
+/*
+ * Start a stream
+ * @param analyzer: analyzer used to build the report (must outlive the stream)
+ * @param language: language name, or empty to detect it from the first window
+ * @param chunkBytes: bytes lexed at a time
+ * @param options: metrics and token frequency settings
+ */
+AnalyzerStream::AnalyzerStream(const Analyzer& analyzer, const std::string& language, size_t chunkBytes,
+		const AnalysisOptions& options)
+	: analyzer_(analyzer), options_(options), chunkBytes_(std::max<size_t>(chunkBytes, 1)), detect_(language.empty()),
+	  language_(languageFromName(language)), lexer_(language_), engine_(language_) {
+	engine_.setTokenFrequency(options_.countsTokens());
+}
+
+/*
+ * Append input
+ * Whole windows are analyzed as soon as chunkBytes are pending; the bytes
+ * after the last line end (or blank) wait for the next feed.
+ * @param chunk: next bytes of the input
+ */
+void AnalyzerStream::feed(std::string_view chunk) {
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (finished_) {
+		throw std::logic_error("feed() after finish()");
+	}
+	total_ += chunk.size();
+
+	while (!chunk.empty()) {
+		size_t take = std::min(chunk.size(), chunkBytes_);
+		buffer_.append(chunk.data(), take);
+		chunk.remove_prefix(take);
+
+		if (buffer_.size() - lexed_ < chunkBytes_) {
+			continue;
+		}
+		size_t cut = cutPoint(buffer_, std::max(searched_, lexed_));
+		if (cut == 0) {
+			// no blank at all: keep collecting until one arrives
+			searched_ = buffer_.size();
+			continue;
+		}
+		process(cut, false);
+	}
+}
+
+/*
+ * Analyze the remaining input
+ * @return: structure, analysis result and quality score of the whole input
+ */
+AnalysisReport AnalyzerStream::finish() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (finished_) {
+		throw std::logic_error("finish() called twice");
+	}
+	process(buffer_.size(), true);
+	finished_ = true;
+
+	AnalysisReport report;
+	if (CodeParser::hasStructure(language_) && !options_.needsStructure()) {
+		structure_.language = languageName(language_);
+		structure_.complexity = 0;
+	}
+	else if (CodeParser::hasStructure(language_)) {
+		structure_.language = languageName(language_);
+		structure_.complexity = static_cast<int>(total_ / 100) + control_ + maxIndent_ / 2;
+	}
+	else {
+		structure_.language = "unknown";
+		structure_.complexity = static_cast<int>(total_ / 100);
+	}
+	report.result = analyzer_.resultFromMetrics(total_, structure_, language_, engine_.counters(), options_);
+	report.qualityScore = analyzer_.calculateQuality(analyzer_.qualityInputs(total_, language_, engine_.counters()));
+	report.structure = std::move(structure_);
+
+	// release the buffers; only the report is needed from here on
+	std::string().swap(buffer_);
+	window_ = TokenStream();
+	piece_ = TokenStream();
+	return report;
+}
+
+/*
+ * Lex and measure buffer_[lexed_, end), then collect the structure of the
+ * window and drop everything but the held tail
+ * @param end: cut point in buffer_
+ * @param last: end of input
+ */
+void AnalyzerStream::process(size_t end, bool last) {
+	if (detect_) {
+		language_ = languageFromName(analyzer_.codeParser().detectLanguage(std::string_view(buffer_.data(), end)));
+		lexer_ = Lexer(language_);
+		engine_ = MetricEngine(language_);
+		engine_.setTokenFrequency(options_.countsTokens());
+		detect_ = false;
+	}
+
+	// a string, comment or directive cut at a blank continues as a new piece
+	bool resumesPiece = state_.mode != LexMode::Code;
+
+	piece_.tokens.clear();
+	piece_.lines.clear();
+	lexer_.scan(buffer_.data() + lexed_, end - lexed_, lexed_, state_, piece_);
+	if (last) {
+		lexer_.finish(state_, piece_);
+	}
+	lexed_ = end;
+
+	engine_.consume(buffer_.data(), piece_);
+	for (const LineInfo& line : piece_.lines) {
+		if (line.flags & LINE_NONBLANK) {
+			maxIndent_ = std::max(maxIndent_, static_cast<int>(line.leading));
+		}
+	}
+
+	std::vector<Token>& tokens = window_.tokens;
+	size_t hold = 0;
+	if (CodeParser::hasStructure(language_) && options_.needsStructure()) {
+		window_.language = language_;
+		auto from = piece_.tokens.begin();
+		if (resumesPiece && !tokens.empty() && from != piece_.tokens.end()) {
+			// glue the two pieces back together for the structure pass
+			Token& back = tokens.back();
+			if (back.line == from->line && back.type == from->type && back.offset + back.length == from->offset) {
+				back.length += from->length;
+				++from;
+			}
+		}
+		tokens.insert(tokens.end(), from, piece_.tokens.end());
+
+		// hold the last tokens back as lookahead; start the tail at a line
+		// start when that line is not too long, so the first held token
+		// looks like the first token of its line
+		hold = tokens.size();
+		if (!last && hold > TAIL_TOKENS) {
+			hold -= TAIL_TOKENS;
+			size_t lineStart = hold;
+			while (lineStart > 0 && hold - lineStart < TAIL_TOKENS && tokens[lineStart - 1].line == tokens[hold].line) {
+				lineStart--;
+			}
+			if (lineStart == 0 || tokens[lineStart - 1].line != tokens[hold].line) {
+				hold = lineStart;
+			}
+		}
+		else if (!last) {
+			hold = 0;
+		}
+		control_ += analyzer_.codeParser().appendStructure(buffer_, window_, hold, structure_);
+	}
+
+	// keep only the bytes of the held tokens and the input after end
+	size_t keep = hold < tokens.size() ? tokens[hold].offset : lexed_;
+	tokens.erase(tokens.begin(), tokens.begin() + hold);
+	for (Token& token : tokens) {
+		token.offset -= keep;
+	}
+	buffer_.erase(0, keep);
+	lexed_ -= keep;
+	searched_ = lexed_;
+	state_.lineOffset = state_.lineOffset >= keep ? state_.lineOffset - keep : 0;
+}
+
+size_t AnalyzerStream::bytesFed() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return total_;
+}
+
+Language AnalyzerStream::language() const {
+	std::lock_guard<std::mutex> lock(mutex_);
+	return language_;
+}
+
+}  // namespace code_educator
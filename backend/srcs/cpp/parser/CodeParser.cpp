@@ -1,5 +1,6 @@
 #include "CodeParser.hpp"
-#include <regex>
+#include "CoreStats.hpp"
+#include "ThreadPool.hpp"
 #include <algorithm>
 #include <iostream>
 #include <sstream>
@@ -14,201 +15,328 @@ CodeParser::CodeParser() {
 CodeParser::~CodeParser() {
 }
 
-std::string CodeParser::detectLanguage(const std::string& code) {
+std::string CodeParser::detectLanguage(std::string_view code, std::string_view fileName) const {
+    return languageName(guessLanguage(code, fileName).language);
+}
 
-    // Python characteristics check
-    if (code.find("def ") != std::string::npos ||
-        code.find("import ") != std::string::npos ||
-        code.find("class ") != std::string::npos && code.find(":") != std::string::npos) {
-        return "python";
-    }
+LanguageGuess CodeParser::guessLanguage(std::string_view code, std::string_view fileName) const {
+    StageTimer timer(Stage::DetectLanguage);
+    return detector_.detect(code, fileName);
+}
 
-    // C characteristics check
-    if (code.find("int main") != std::string::npos ||
-		code.find("#include <stdio.h>") != std::string::npos ||
-		code.find("printf") != std::string::npos) {
-		return "c";
-	}
-
-    // C++ characteristics check
-    if (code.find("#include") != std::string::npos ||
-        code.find("int main") != std::string::npos ||
-        code.find("std::") != std::string::npos) {
-        return "cpp";
-    }
+int CodeParser::calculateComplexity(std::string_view code, const std::string& language) const {
+    Lexer lexer(languageFromName(language));
+    return complexityOf(code, lexer.tokenize(code));
+}
 
-    // JavaScript characteristics check
-    if (code.find("function ") != std::string::npos ||
-        code.find("const ") != std::string::npos ||
-        code.find("let ") != std::string::npos ||
-        code.find("=>") != std::string::npos) {
-        return "javascript";
-    }
+std::vector<std::string> CodeParser::extractImports(std::string_view code, const std::string& language) const {
+    Lexer lexer(languageFromName(language));
+    TokenStream stream = lexer.tokenize(code);
+    return importsOf(code, stream, 0, stream.tokens.size());
+}
 
-    return "unknown";  // default value
+std::vector<std::string> CodeParser::extractFunctions(std::string_view code, const std::string& language) const {
+    Lexer lexer(languageFromName(language));
+    TokenStream stream = lexer.tokenize(code);
+    return functionsOf(code, stream, 0, stream.tokens.size());
 }
 
-int CodeParser::calculateComplexity(const std::string& code, const std::string& language) {
-    int complexity = 0;
+std::vector<std::string> CodeParser::extractClasses(std::string_view code, const std::string& language) const {
+    Lexer lexer(languageFromName(language));
+    TokenStream stream = lexer.tokenize(code);
+    return classesOf(code, stream, 0, stream.tokens.size());
+}
 
-    // default complexity based on lines of code
-    complexity += code.length() / 100;
-
-    // control structures complexity
-    std::regex if_regex("if\\s*\\(|if\\s+");
-    std::regex for_regex("for\\s*\\(|for\\s+");
-    std::regex while_regex("while\\s*\\(|while\\s+");
-    std::regex switch_regex("switch\\s*\\(");
-    std::regex try_regex("try\\s*\\{|try:");
-
-    // search for control structures
-    std::string::const_iterator searchStart(code.cbegin());
-    std::string::const_iterator searchEnd(code.cend());
-    std::regex_iterator<std::string::const_iterator> if_it(searchStart, searchEnd, if_regex);
-    std::regex_iterator<std::string::const_iterator> for_it(searchStart, searchEnd, for_regex);
-    std::regex_iterator<std::string::const_iterator> while_it(searchStart, searchEnd, while_regex);
-    std::regex_iterator<std::string::const_iterator> switch_it(searchStart, searchEnd, switch_regex);
-    std::regex_iterator<std::string::const_iterator> try_it(searchStart, searchEnd, try_regex);
-
-    std::regex_iterator<std::string::const_iterator> end;
-
-	// calculate complexity based on control structures
-    complexity += std::distance(if_it, end) * 1;
-    complexity += std::distance(for_it, end) * 2;
-    complexity += std::distance(while_it, end) * 2;
-    complexity += std::distance(switch_it, end) * 3;
-    complexity += std::distance(try_it, end) * 1;
+namespace {
 
-    // indentation complexity
+// tokens searched for structure between two budget checks
+constexpr size_t STRUCTURE_WINDOW_TOKENS = 4096;
+
+// deepest leading whitespace of a non-blank line
+int deepestIndent(const TokenStream& stream) {
     int max_indent = 0;
-    int current_indent = 0;
-
-    std::istringstream stream(code);
-    std::string line;
-    while (std::getline(stream, line)) {
-        // skip empty lines
-        size_t indent = line.find_first_not_of(" \t");
-        if (indent != std::string::npos) {
-            current_indent = indent;
-            max_indent = std::max(max_indent, current_indent);
+    for (const LineInfo& line : stream.lines) {
+        if (line.flags & LINE_NONBLANK) {
+            max_indent = std::max(max_indent, static_cast<int>(line.leading));
         }
     }
-
-    complexity += max_indent / 2;
-
-    return complexity;
+    return max_indent;
 }
 
-std::vector<std::string> CodeParser::extractImports(const std::string& code, const std::string& language) {
-    std::vector<std::string> imports;
+bool isPunct(const char* base, const std::vector<Token>& tokens, size_t i, const char* op) {
+    return i < tokens.size() && tokens[i].type == TokenType::Punct && tokenIs(base, tokens[i], op);
+}
 
-    if (language == "python") {
-        std::regex import_regex("(import|from)\\s+([\\w\\.]+)\\s*.*");
+bool isWord(const std::vector<Token>& tokens, size_t i, Keyword keyword) {
+    return i < tokens.size() && tokens[i].keyword == keyword;
+}
 
-        std::string::const_iterator searchStart(code.cbegin());
-        std::string::const_iterator searchEnd(code.cend());
-        std::sregex_iterator words_begin = std::sregex_iterator(searchStart, searchEnd, import_regex);
-        std::sregex_iterator words_end = std::sregex_iterator();
+bool isControlKeyword(const Token& token) {
+    switch (token.keyword) {
+        case Keyword::If: case Keyword::For: case Keyword::While: case Keyword::Switch:
+        case Keyword::Else: case Keyword::Return: case Keyword::Do: case Keyword::Case:
+        case Keyword::New: case Keyword::Delete: case Keyword::Throw: case Keyword::Sizeof:
+        case Keyword::Catch: case Keyword::Goto:
+            return true;
+        default:
+            return false;
+    }
+}
 
-        for (std::sregex_iterator i = words_begin; i != words_end; ++i) {
-            std::smatch match = *i;
-            imports.push_back(match.str());
+// index of the ')' matching the '(' at i, or tokens.size() if it is not
+// found before token `end`
+size_t matchParen(const char* base, const std::vector<Token>& tokens, size_t i, size_t end) {
+    int depth = 0;
+    end = std::min(end, tokens.size());
+    for (; i < end; ++i) {
+        if (tokens[i].type != TokenType::Punct) {
+            continue;
+        }
+        if (tokenIs(base, tokens[i], "(")) {
+            depth++;
+        }
+        else if (tokenIs(base, tokens[i], ")")) {
+            if (--depth == 0) {
+                return i;
+            }
+        }
+        else if (tokenIs(base, tokens[i], "{") || tokenIs(base, tokens[i], ";")) {
+            break;  // not a parameter list
         }
     }
-    else if (language == "cpp") {
-        // C++ include
-        std::regex include_regex("#include\\s*[<\"]([\\w\\./]+)[>\"]");
+    return tokens.size();
+}
+
+// text from the start of token `first` to the end of token `last`
+std::string spanText(std::string_view code, const Token& first, const Token& last) {
+    return std::string(code.substr(first.offset, last.offset + last.length - first.offset));
+}
 
-        std::string::const_iterator searchStart(code.cbegin());
-        std::string::const_iterator searchEnd(code.cend());
-        std::sregex_iterator words_begin = std::sregex_iterator(searchStart, searchEnd, include_regex);
-        std::sregex_iterator words_end = std::sregex_iterator();
+}  // namespace
+
+/*
+ * Complexity from control structures and indentation
+ * if: 1, for/while: 2, switch: 3, try: 1, plus half of the deepest indentation
+ */
+int CodeParser::complexityOf(std::string_view code, const TokenStream& stream) const {
+    int complexity = code.length() / 100;
+    complexity += controlComplexityOf(code, stream, 0, stream.tokens.size());
+
+    // indentation complexity
+    complexity += deepestIndent(stream) / 2;
 
-        for (std::sregex_iterator i = words_begin; i != words_end; ++i) {
-            std::smatch match = *i;
-            imports.push_back(match.str());
+    return complexity;
+}
+
+// control structure part of the complexity, for tokens [begin, limit)
+int CodeParser::controlComplexityOf(std::string_view code, const TokenStream& stream, size_t begin, size_t limit) const {
+    const char* base = code.data();
+    const std::vector<Token>& tokens = stream.tokens;
+    int complexity = 0;
+
+    for (size_t i = begin; i < limit; ++i) {
+        switch (tokens[i].keyword) {
+            case Keyword::If:
+            case Keyword::Elif:
+                complexity += 1;
+                break;
+            case Keyword::For:
+            case Keyword::While:
+                complexity += 2;
+                break;
+            case Keyword::Switch:
+                if (isPunct(base, tokens, i + 1, "(")) {
+                    complexity += 3;
+                }
+                break;
+            case Keyword::Try:
+                if (isPunct(base, tokens, i + 1, "{") || isPunct(base, tokens, i + 1, ":")) {
+                    complexity += 1;
+                }
+                break;
+            default:
+                break;
         }
     }
-    else if (language == "javascript") {
-        // JavaScript import
-        std::regex import_regex("(import|require)\\s*[\\({]?\\s*['\"]([\\w\\./]+)['\"]");
 
-        std::string::const_iterator searchStart(code.cbegin());
-        std::string::const_iterator searchEnd(code.cend());
-        std::sregex_iterator words_begin = std::sregex_iterator(searchStart, searchEnd, import_regex);
-        std::sregex_iterator words_end = std::sregex_iterator();
+    return complexity;
+}
+
+std::vector<std::string> CodeParser::importsOf(std::string_view code, const TokenStream& stream, size_t begin, size_t limit) const {
+    const char* base = code.data();
+    const std::vector<Token>& tokens = stream.tokens;
+    std::vector<std::string> imports;
 
-        for (std::sregex_iterator i = words_begin; i != words_end; ++i) {
-            std::smatch match = *i;
-            imports.push_back(match.str());
+    if (stream.language == Language::Python) {
+        // import x / from x import y, as the first token of a line
+        for (size_t i = begin; i < limit; ++i) {
+            const Token& token = tokens[i];
+            if (token.type != TokenType::Identifier || (i > 0 && tokens[i - 1].line == token.line)) {
+                continue;
+            }
+            if (token.keyword != Keyword::Import && token.keyword != Keyword::From) {
+                continue;
+            }
+            if (i + 1 >= tokens.size() || tokens[i + 1].line != token.line ||
+                !(tokens[i + 1].type == TokenType::Identifier || isPunct(base, tokens, i + 1, "."))) {
+                continue;
+            }
+            size_t last = i + 1;
+            while (last + 1 < tokens.size() && tokens[last + 1].line == token.line &&
+                   tokens[last + 1].type != TokenType::Comment) {
+                last++;
+            }
+            imports.push_back(spanText(code, token, tokens[last]));
+        }
+    }
+    else if (stream.language == Language::Cpp || stream.language == Language::C) {
+        // #include <x> / #include "x"
+        for (size_t i = begin; i < limit; ++i) {
+            const Token& token = tokens[i];
+            if (token.type != TokenType::Directive) {
+                continue;
+            }
+            const char* p = base + token.offset;
+            const char* end = p + token.length;
+            const char* q = p + 1;
+            while (q < end && (*q == ' ' || *q == '\t')) {
+                ++q;
+            }
+            if (end - q < 7 || std::string(q, 7) != "include") {
+                continue;
+            }
+            q += 7;
+            while (q < end && (*q == ' ' || *q == '\t')) {
+                ++q;
+            }
+            if (q == end || (*q != '<' && *q != '"')) {
+                continue;
+            }
+            char close = (*q == '<') ? '>' : '"';
+            const char* name_end = std::find(q + 1, end, close);
+            if (name_end == end || name_end == q + 1) {
+                continue;
+            }
+            imports.push_back(std::string(p, name_end + 1));
+        }
+    }
+    else if (stream.language == Language::JavaScript) {
+        for (size_t i = begin; i < limit; ++i) {
+            const Token& token = tokens[i];
+            if (token.type != TokenType::Identifier || isPunct(base, tokens, i - 1, ".")) {
+                continue;
+            }
+            // require('x') and import('x')
+            if ((token.keyword == Keyword::Require || token.keyword == Keyword::Import) &&
+                isPunct(base, tokens, i + 1, "(") &&
+                i + 2 < tokens.size() && tokens[i + 2].type == TokenType::String) {
+                size_t last = isPunct(base, tokens, i + 3, ")") ? i + 3 : i + 2;
+                imports.push_back(spanText(code, token, tokens[last]));
+                continue;
+            }
+            // import 'x' / import x from 'x' / import {a, b} from 'x'
+            if (token.keyword == Keyword::Import) {
+                size_t lookaheadEnd = std::min(tokens.size(), i + 64);
+                for (size_t j = i + 1; j < lookaheadEnd; ++j) {
+                    if (tokens[j].type == TokenType::String) {
+                        if (j == i + 1 || isWord(tokens, j - 1, Keyword::From)) {
+                            imports.push_back(spanText(code, token, tokens[j]));
+                        }
+                        break;
+                    }
+                    if (isPunct(base, tokens, j, ";") || isPunct(base, tokens, j, "(")) {
+                        break;
+                    }
+                }
+            }
         }
     }
-	else if (language == "c") {
-		// C include
-		std::regex include_regex("#include\\s*[<\"]([\\w\\./]+)[>\"]");
-		std::string::const_iterator searchStart(code.cbegin());
-		std::string::const_iterator searchEnd(code.cend());
-		std::sregex_iterator words_begin = std::sregex_iterator(searchStart, searchEnd, include_regex);
-		std::sregex_iterator words_end = std::sregex_iterator();
-		for (std::sregex_iterator i = words_begin; i != words_end; ++i) {
-			std::smatch match = *i;
-			imports.push_back(match.str());
-		}
-	}
 
     return imports;
 }
 
-std::vector<std::string> CodeParser::extractFunctions(const std::string& code, const std::string& language) {
+std::vector<std::string> CodeParser::functionsOf(std::string_view code, const TokenStream& stream, size_t begin, size_t limit) const {
+    const char* base = code.data();
+    const std::vector<Token>& tokens = stream.tokens;
     std::vector<std::string> functions;
 
-    if (language == "python") {
-        // Find Python function definitions
-        std::regex func_regex("def\\s+([\\w_]+)\\s*\\(");
-
-        std::string::const_iterator searchStart(code.cbegin());
-        std::string::const_iterator searchEnd(code.cend());
-        std::sregex_iterator words_begin = std::sregex_iterator(searchStart, searchEnd, func_regex);
-        std::sregex_iterator words_end = std::sregex_iterator();
-
-        for (std::sregex_iterator i = words_begin; i != words_end; ++i) {
-            std::smatch match = *i;
-            if (match.size() > 1) {
-                functions.push_back(match[1].str());
+    if (stream.language == Language::Python) {
+        // def name(
+        for (size_t i = begin; i < limit && i + 2 < tokens.size(); ++i) {
+            if (isWord(tokens, i, Keyword::Def) && tokens[i + 1].type == TokenType::Identifier &&
+                isPunct(base, tokens, i + 2, "(")) {
+                functions.push_back(tokenText(base, tokens[i + 1]));
             }
         }
     }
-    else if (language == "cpp") {
-        std::regex func_regex("(\\w+)\\s+(\\w+)\\s*\\([^)]*\\)\\s*\\{");
-
-        std::string::const_iterator searchStart(code.cbegin());
-        std::string::const_iterator searchEnd(code.cend());
-        std::sregex_iterator words_begin = std::sregex_iterator(searchStart, searchEnd, func_regex);
-        std::sregex_iterator words_end = std::sregex_iterator();
-
-        for (std::sregex_iterator i = words_begin; i != words_end; ++i) {
-            std::smatch match = *i;
-            if (match.size() > 2 && match[1].str() != "if" && match[1].str() != "for" &&
-                match[1].str() != "while" && match[1].str() != "switch") {
-                functions.push_back(match[2].str());
+    else if (stream.language == Language::Cpp || stream.language == Language::C) {
+        // type [*&] name[::name](params) [const|noexcept|override|final] {
+        for (size_t i = begin; i < limit && i + 3 < tokens.size(); ++i) {
+            if (tokens[i].type != TokenType::Identifier || isControlKeyword(tokens[i])) {
+                continue;
+            }
+            size_t lookaheadEnd = std::min(tokens.size(), i + LOOKAHEAD_TOKENS);
+            size_t j = i + 1;
+            while (j < lookaheadEnd &&
+                   (isPunct(base, tokens, j, "*") || isPunct(base, tokens, j, "&") || isPunct(base, tokens, j, "&&"))) {
+                j++;
+            }
+            if (j >= lookaheadEnd || tokens[j].type != TokenType::Identifier || isControlKeyword(tokens[j])) {
+                continue;
+            }
+            size_t name_first = j;
+            while (j + 2 < lookaheadEnd && isPunct(base, tokens, j + 1, "::")) {
+                if (isPunct(base, tokens, j + 2, "~") && j + 3 < lookaheadEnd && tokens[j + 3].type == TokenType::Identifier) {
+                    j += 3;
+                }
+                else if (tokens[j + 2].type == TokenType::Identifier) {
+                    j += 2;
+                }
+                else {
+                    break;
+                }
+            }
+            if (j + 1 >= lookaheadEnd || !isPunct(base, tokens, j + 1, "(")) {
+                continue;
+            }
+            size_t close = matchParen(base, tokens, j + 1, lookaheadEnd);
+            if (close >= tokens.size()) {
+                continue;
+            }
+            size_t k = close + 1;
+            while (k < lookaheadEnd && (isWord(tokens, k, Keyword::Const) || isWord(tokens, k, Keyword::Noexcept) ||
+                   isWord(tokens, k, Keyword::Override) || isWord(tokens, k, Keyword::Final))) {
+                k++;
+            }
+            if (k < lookaheadEnd && isPunct(base, tokens, k, "{")) {
+                functions.push_back(spanText(code, tokens[name_first], tokens[j]));
             }
         }
     }
-    else if (language == "javascript") {
-        // JavaScript function definition search
-        std::regex func_regex("function\\s+(\\w+)\\s*\\(|const\\s+(\\w+)\\s*=\\s*function|let\\s+(\\w+)\\s*=\\s*function");
-
-        std::string::const_iterator searchStart(code.cbegin());
-        std::string::const_iterator searchEnd(code.cend());
-        std::sregex_iterator words_begin = std::sregex_iterator(searchStart, searchEnd, func_regex);
-        std::sregex_iterator words_end = std::sregex_iterator();
-
-        for (std::sregex_iterator i = words_begin; i != words_end; ++i) {
-            std::smatch match = *i;
-            for (size_t j = 1; j < match.size(); ++j) {
-                if (match[j].matched && !match[j].str().empty()) {
-                    functions.push_back(match[j].str());
-                    break;
+    else if (stream.language == Language::JavaScript) {
+        for (size_t i = begin; i < limit && i + 2 < tokens.size(); ++i) {
+            // function name( / function* name(
+            if (isWord(tokens, i, Keyword::Function)) {
+                size_t j = isPunct(base, tokens, i + 1, "*") ? i + 2 : i + 1;
+                if (j < tokens.size() && tokens[j].type == TokenType::Identifier && isPunct(base, tokens, j + 1, "(")) {
+                    functions.push_back(tokenText(base, tokens[j]));
+                }
+                continue;
+            }
+            // const|let|var name = [async] function / (...) => / x =>
+            if ((isWord(tokens, i, Keyword::Const) || isWord(tokens, i, Keyword::Let) || isWord(tokens, i, Keyword::Var)) &&
+                tokens[i + 1].type == TokenType::Identifier && isPunct(base, tokens, i + 2, "=")) {
+                size_t j = isWord(tokens, i + 3, Keyword::Async) ? i + 4 : i + 3;
+                bool is_function = isWord(tokens, j, Keyword::Function);
+                if (!is_function && j < tokens.size() && tokens[j].type == TokenType::Identifier) {
+                    is_function = isPunct(base, tokens, j + 1, "=>");
+                }
+                else if (!is_function && isPunct(base, tokens, j, "(")) {
+                    size_t close = matchParen(base, tokens, j, i + LOOKAHEAD_TOKENS - 1);
+                    is_function = isPunct(base, tokens, close + 1, "=>");
+                }
+                if (is_function) {
+                    functions.push_back(tokenText(base, tokens[i + 1]));
                 }
             }
         }
@@ -217,121 +345,71 @@ std::vector<std::string> CodeParser::extractFunctions(const std::string& code, c
     return functions;
 }
 
-std::vector<std::string> CodeParser::extractClasses(const std::string& code, const std::string& language) {
+std::vector<std::string> CodeParser::classesOf(std::string_view code, const TokenStream& stream, size_t begin, size_t limit) const {
+    const char* base = code.data();
+    const std::vector<Token>& tokens = stream.tokens;
     std::vector<std::string> classes;
 
-    if (language == "python") {
-        std::regex class_regex("class\\s+(\\w+)");
-
-        std::string::const_iterator searchStart(code.cbegin());
-        std::string::const_iterator searchEnd(code.cend());
-        std::sregex_iterator words_begin = std::sregex_iterator(searchStart, searchEnd, class_regex);
-        std::sregex_iterator words_end = std::sregex_iterator();
-
-        for (std::sregex_iterator i = words_begin; i != words_end; ++i) {
-            std::smatch match = *i;
-            if (match.size() > 1) {
-                classes.push_back(match[1].str());
+    if (stream.language == Language::C) {
+        // C struct definition: struct name {
+        for (size_t i = begin; i < limit && i + 2 < tokens.size(); ++i) {
+            if (isWord(tokens, i, Keyword::Struct) && tokens[i + 1].type == TokenType::Identifier &&
+                isPunct(base, tokens, i + 2, "{")) {
+                classes.push_back(tokenText(base, tokens[i + 1]));
             }
         }
     }
-    else if (language == "cpp") {
-        // C++ class definetion search
-        std::regex class_regex("class\\s+(\\w+)");
-
-        std::string::const_iterator searchStart(code.cbegin());
-        std::string::const_iterator searchEnd(code.cend());
-        std::sregex_iterator words_begin = std::sregex_iterator(searchStart, searchEnd, class_regex);
-        std::sregex_iterator words_end = std::sregex_iterator();
-
-        for (std::sregex_iterator i = words_begin; i != words_end; ++i) {
-            std::smatch match = *i;
-            if (match.size() > 1) {
-                classes.push_back(match[1].str());
+    else if (stream.language != Language::Unknown) {
+        // class name (but not C++ template parameters: template <class T>)
+        for (size_t i = begin; i < limit && i + 1 < tokens.size(); ++i) {
+            if (!isWord(tokens, i, Keyword::Class) || tokens[i + 1].type != TokenType::Identifier) {
+                continue;
             }
-        }
-    }
-    else if (language == "javascript") {
-        // JavaScript definition search
-        std::regex class_regex("class\\s+(\\w+)");
-
-        std::string::const_iterator searchStart(code.cbegin());
-        std::string::const_iterator searchEnd(code.cend());
-        std::sregex_iterator words_begin = std::sregex_iterator(searchStart, searchEnd, class_regex);
-        std::sregex_iterator words_end = std::sregex_iterator();
-
-        for (std::sregex_iterator i = words_begin; i != words_end; ++i) {
-            std::smatch match = *i;
-            if (match.size() > 1) {
-                classes.push_back(match[1].str());
+            if (i > 0 && (isPunct(base, tokens, i - 1, "<") || isPunct(base, tokens, i - 1, ","))) {
+                continue;
             }
+            classes.push_back(tokenText(base, tokens[i + 1]));
         }
     }
-	else if (language == "c") {
-		// C struct definition search
-		std::regex struct_regex("struct\\s+(\\w+)");
-		std::string::const_iterator searchStart(code.cbegin());
-		std::string::const_iterator searchEnd(code.cend());
-		std::sregex_iterator words_begin = std::sregex_iterator(searchStart, searchEnd, struct_regex);
-		std::sregex_iterator words_end = std::sregex_iterator();
-
-		for (std::sregex_iterator i = words_begin; i != words_end; ++i) {
-			std::smatch match = *i;
-			if (match.size() > 1) {
-				classes.push_back(match[1].str());
-			}
-		}
-	}
 
     return classes;
 }
 
-CodeStructure CodeParser::parsePython(const std::string& code) {
+CodeStructure CodeParser::parseTokens(std::string_view code, const TokenStream& stream) const {
+    StageTimer timer(Stage::Structure, code.size());
     CodeStructure structure;
-    structure.language = "python";
-    structure.imports = extractImports(code, "python");
-    structure.functions = extractFunctions(code, "python");
-    structure.classes = extractClasses(code, "python");
-    structure.complexity = calculateComplexity(code, "python");
+    structure.language = languageName(stream.language);
+    structure.imports = importsOf(code, stream, 0, stream.tokens.size());
+    structure.functions = functionsOf(code, stream, 0, stream.tokens.size());
+    structure.classes = classesOf(code, stream, 0, stream.tokens.size());
+    structure.complexity = complexityOf(code, stream);
 
     return structure;
 }
 
-CodeStructure CodeParser::parseCpp(const std::string& code) {
-    CodeStructure structure;
-    structure.language = "cpp";
-    structure.imports = extractImports(code, "cpp");
-    structure.functions = extractFunctions(code, "cpp");
-    structure.classes = extractClasses(code, "cpp");
-    structure.complexity = calculateComplexity(code, "cpp");
-
-    return structure;
+CodeStructure CodeParser::parsePython(std::string_view code) const {
+    Lexer lexer(Language::Python);
+    return parseTokens(code, lexer.tokenize(code));
 }
 
-CodeStructure CodeParser::parseJavaScript(const std::string& code) {
-    CodeStructure structure;
-    structure.language = "javascript";
-    structure.imports = extractImports(code, "javascript");
-    structure.functions = extractFunctions(code, "javascript");
-    structure.classes = extractClasses(code, "javascript");
-    structure.complexity = calculateComplexity(code, "javascript");
+CodeStructure CodeParser::parseCpp(std::string_view code) const {
+    Lexer lexer(Language::Cpp);
+    return parseTokens(code, lexer.tokenize(code));
+}
 
-    return structure;
+CodeStructure CodeParser::parseJavaScript(std::string_view code) const {
+    Lexer lexer(Language::JavaScript);
+    return parseTokens(code, lexer.tokenize(code));
 }
 
 // C parse
-CodeStructure CodeParser::parseC(const std::string &code) {
-	CodeStructure structure;
-	structure.language = "c";
-	structure.imports = extractImports(code, "c");
-	structure.functions = extractFunctions(code, "c");
-	structure.classes = extractClasses(code, "c");
-	structure.complexity = calculateComplexity(code, "c");
-
-	return structure;
+CodeStructure CodeParser::parseC(std::string_view code) const {
+	Lexer lexer(Language::C);
+	return parseTokens(code, lexer.tokenize(code));
 }
 
-CodeStructure CodeParser::parse(const std::string& code) {
+CodeStructure CodeParser::parse(std::string_view code) const {
+    StageTimer timer(Stage::Parse, code.size());
     std::string language = detectLanguage(code);  // dectect language
 
     if (language == "python") {
@@ -340,6 +418,9 @@ CodeStructure CodeParser::parse(const std::string& code) {
     else if (language == "cpp") {
         return parseCpp(code);
     }
+    else if (language == "c") {
+        return parseC(code);
+    }
     else if (language == "javascript") {
         return parseJavaScript(code);
     }
@@ -350,4 +431,101 @@ CodeStructure CodeParser::parse(const std::string& code) {
     return structure;
 }
 
+std::vector<CodeStructure> CodeParser::parseBatch(const std::vector<std::string_view>& codes, size_t threads) const {
+    std::vector<CodeStructure> structures(codes.size());
+    ThreadPool::shared().parallelFor(codes.size(), [&](size_t i) {
+        structures[i] = parse(codes[i]);
+    }, threads);
+    return structures;
+}
+
+CodeStructure CodeParser::parse(std::string_view code, TokenStream& stream, std::string_view fileName) const {
+    StageTimer timer(Stage::Parse, code.size());
+    Lexer lexer(guessLanguage(code, fileName).language);
+    lexer.tokenize(code, stream);
+    return structureOf(code, stream);
+}
+
+/*
+ * Structure of one window of a long input
+ * Matches are taken only where they start before `limit`; the tokens after it
+ * serve as lookahead and are passed again with the next window.
+ * @param code: buffer the token offsets point into
+ * @param stream: tokens of the window
+ * @param limit: number of leading tokens whose matches are collected
+ * @param structure: imports, functions and classes are appended here
+ * @return: control structure complexity of the leading tokens
+ */
+int CodeParser::appendStructure(std::string_view code, const TokenStream& stream, size_t limit, CodeStructure& structure) const {
+    return appendStructure(code, stream, 0, limit, structure);
+}
+
+/*
+ * Structure of a range of tokens
+ * Matches are taken only where they start in [begin, end); the tokens around
+ * the range are read as context (one before it, lookahead after it).
+ * @param code: buffer the token offsets point into
+ * @param stream: tokens to read
+ * @param begin: first token whose matches are collected
+ * @param end: one past the last token whose matches are collected
+ * @param structure: imports, functions and classes are appended here
+ * @return: control structure complexity of the range
+ */
+int CodeParser::appendStructure(std::string_view code, const TokenStream& stream, size_t begin, size_t end,
+    CodeStructure& structure) const {
+    end = std::min(end, stream.tokens.size());
+    begin = std::min(begin, end);
+    std::vector<std::string> imports = importsOf(code, stream, begin, end);
+    std::vector<std::string> functions = functionsOf(code, stream, begin, end);
+    std::vector<std::string> classes = classesOf(code, stream, begin, end);
+    structure.imports.insert(structure.imports.end(), imports.begin(), imports.end());
+    structure.functions.insert(structure.functions.end(), functions.begin(), functions.end());
+    structure.classes.insert(structure.classes.end(), classes.begin(), classes.end());
+    return controlComplexityOf(code, stream, begin, end);
+}
+
+bool CodeParser::hasStructure(Language language) {
+    return language == Language::Python || language == Language::C || language == Language::Cpp ||
+           language == Language::JavaScript;
+}
+
+CodeStructure CodeParser::structureOf(std::string_view code, const TokenStream& stream) const {
+    if (hasStructure(stream.language)) {
+        return parseTokens(code, stream);
+    }
+
+    CodeStructure structure;
+    structure.language = "unknown";
+    structure.complexity = code.length() / 100;
+    return structure;
+}
+
+/*
+ * Structure of a tokenized buffer under a budget
+ * @param code: buffer the token offsets point into
+ * @param stream: tokens of the buffer
+ * @param tracker: budget of the call, checked before each window of tokens
+ * @param memoryBytes: bytes the call holds (for the memory limit)
+ * @return: code structure of the windows searched before the budget ran out
+ */
+CodeStructure CodeParser::structureOf(std::string_view code, const TokenStream& stream, BudgetTracker& tracker,
+    size_t memoryBytes) const {
+    if (!hasStructure(stream.language)) {
+        return structureOf(code, stream);
+    }
+
+    StageTimer timer(Stage::Structure, code.size());
+    CodeStructure structure;
+    structure.language = languageName(stream.language);
+    int control = 0;
+    for (size_t begin = 0; begin < stream.tokens.size(); begin += STRUCTURE_WINDOW_TOKENS) {
+        if (tracker.exhausted(memoryBytes)) {
+            break;
+        }
+        control += appendStructure(code, stream, begin, begin + STRUCTURE_WINDOW_TOKENS, structure);
+    }
+    structure.complexity = static_cast<int>(code.length() / 100) + control + deepestIndent(stream) / 2;
+    return structure;
+}
+
 } // namespace code_educator
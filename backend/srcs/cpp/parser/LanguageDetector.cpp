@@ -0,0 +1,485 @@
+#include "LanguageDetector.hpp"
+#include <algorithm>
+#include <cctype>
+#include <unordered_map>
+
+namespace code_educator {
+
+namespace {
+
+// score slots, in tie-break order: shared C-family evidence goes to C++
+enum Slot { PY, CPP, C, JS, SLOTS };
+
+const Language SLOT_LANGUAGE[SLOTS] = {Language::Python, Language::Cpp, Language::C, Language::JavaScript};
+
+struct Weights {
+	float w[SLOTS];  // PY, CPP, C, JS
+};
+
+struct WordWeight {
+	const char* word;
+	Weights weights;
+};
+
+//                                    PY    CPP   C     JS
+const WordWeight WORDS[] = {
+	{"def",                          {{3.0f, 0.0f, 0.0f, 0.0f}}},
+	{"elif",                         {{3.0f, 0.0f, 0.0f, 0.0f}}},
+	{"self",                         {{2.0f, 0.0f, 0.0f, 0.0f}}},
+	{"None",                         {{2.0f, 0.0f, 0.0f, 0.0f}}},
+	{"True",                         {{1.0f, 0.0f, 0.0f, 0.0f}}},
+	{"False",                        {{1.0f, 0.0f, 0.0f, 0.0f}}},
+	{"lambda",                       {{1.5f, 0.0f, 0.0f, 0.0f}}},
+	{"except",                       {{2.0f, 0.0f, 0.0f, 0.0f}}},
+	{"raise",                        {{1.5f, 0.0f, 0.0f, 0.0f}}},
+	{"pass",                         {{1.0f, 0.0f, 0.0f, 0.0f}}},
+	{"print",                        {{1.0f, 0.0f, 0.0f, 0.0f}}},
+	{"nonlocal",                     {{2.0f, 0.0f, 0.0f, 0.0f}}},
+	{"global",                       {{1.0f, 0.0f, 0.0f, 0.0f}}},
+	{"__init__",                     {{3.0f, 0.0f, 0.0f, 0.0f}}},
+	{"__name__",                     {{3.0f, 0.0f, 0.0f, 0.0f}}},
+	{"and",                          {{0.5f, 0.0f, 0.0f, 0.0f}}},
+	{"or",                           {{0.5f, 0.0f, 0.0f, 0.0f}}},
+	{"not",                          {{0.5f, 0.0f, 0.0f, 0.0f}}},
+	{"is",                           {{0.5f, 0.0f, 0.0f, 0.0f}}},
+	{"import",                       {{1.0f, 0.0f, 0.0f, 1.0f}}},
+	{"from",                         {{1.5f, 0.0f, 0.0f, 0.5f}}},
+	{"class",                        {{1.0f, 1.0f, 0.0f, 0.5f}}},
+	{"async",                        {{0.5f, 0.0f, 0.0f, 1.0f}}},
+	{"await",                        {{0.5f, 0.0f, 0.0f, 1.0f}}},
+
+	{"include",                      {{0.0f, 2.0f, 2.0f, 0.0f}}},
+	{"define",                       {{0.0f, 1.5f, 1.5f, 0.0f}}},
+	{"ifdef",                        {{0.0f, 1.0f, 1.0f, 0.0f}}},
+	{"ifndef",                       {{0.0f, 1.0f, 1.0f, 0.0f}}},
+	{"endif",                        {{0.0f, 1.0f, 1.0f, 0.0f}}},
+	{"pragma",                       {{0.0f, 1.0f, 1.0f, 0.0f}}},
+	{"typedef",                      {{0.0f, 1.0f, 1.5f, 0.0f}}},
+	{"struct",                       {{0.0f, 1.0f, 1.5f, 0.0f}}},
+	{"unsigned",                     {{0.0f, 1.0f, 1.0f, 0.0f}}},
+	{"sizeof",                       {{0.0f, 1.0f, 1.0f, 0.0f}}},
+	{"void",                         {{0.0f, 1.0f, 1.0f, 0.2f}}},
+	{"char",                         {{0.0f, 1.0f, 1.0f, 0.0f}}},
+	{"int",                          {{0.0f, 0.5f, 0.5f, 0.0f}}},
+	{"long",                         {{0.0f, 0.5f, 0.5f, 0.0f}}},
+	{"double",                       {{0.0f, 0.5f, 0.5f, 0.0f}}},
+	{"NULL",                         {{0.0f, 0.5f, 1.5f, 0.0f}}},
+	{"printf",                       {{0.0f, 0.5f, 2.0f, 0.0f}}},
+	{"fprintf",                      {{0.0f, 0.5f, 2.0f, 0.0f}}},
+	{"sprintf",                      {{0.0f, 0.5f, 2.0f, 0.0f}}},
+	{"snprintf",                     {{0.0f, 0.5f, 2.0f, 0.0f}}},
+	{"scanf",                        {{0.0f, 0.5f, 2.0f, 0.0f}}},
+	{"malloc",                       {{0.0f, 0.5f, 2.0f, 0.0f}}},
+	{"calloc",                       {{0.0f, 0.5f, 2.0f, 0.0f}}},
+	{"realloc",                      {{0.0f, 0.5f, 2.0f, 0.0f}}},
+	{"free",                         {{0.0f, 0.3f, 1.0f, 0.0f}}},
+	{"stdio",                        {{0.0f, 0.0f, 3.0f, 0.0f}}},
+	{"stdlib",                       {{0.0f, 0.5f, 2.0f, 0.0f}}},
+
+	{"std",                          {{0.0f, 3.0f, 0.0f, 0.0f}}},
+	{"namespace",                    {{0.0f, 3.0f, 0.0f, 0.0f}}},
+	{"template",                     {{0.0f, 3.0f, 0.0f, 0.0f}}},
+	{"typename",                     {{0.0f, 3.0f, 0.0f, 0.0f}}},
+	{"virtual",                      {{0.0f, 3.0f, 0.0f, 0.0f}}},
+	{"override",                     {{0.0f, 2.0f, 0.0f, 0.0f}}},
+	{"nullptr",                      {{0.0f, 3.0f, 0.0f, 0.0f}}},
+	{"constexpr",                    {{0.0f, 3.0f, 0.0f, 0.0f}}},
+	{"noexcept",                     {{0.0f, 3.0f, 0.0f, 0.0f}}},
+	{"public",                       {{0.0f, 1.5f, 0.0f, 0.3f}}},
+	{"private",                      {{0.0f, 1.5f, 0.0f, 0.3f}}},
+	{"protected",                    {{0.0f, 1.5f, 0.0f, 0.3f}}},
+	{"cout",                         {{0.0f, 3.0f, 0.0f, 0.0f}}},
+	{"cin",                          {{0.0f, 3.0f, 0.0f, 0.0f}}},
+	{"cerr",                         {{0.0f, 3.0f, 0.0f, 0.0f}}},
+	{"endl",                         {{0.0f, 3.0f, 0.0f, 0.0f}}},
+	{"iostream",                     {{0.0f, 3.0f, 0.0f, 0.0f}}},
+	{"vector",                       {{0.0f, 1.5f, 0.0f, 0.0f}}},
+	{"auto",                         {{0.0f, 1.5f, 0.2f, 0.0f}}},
+	{"bool",                         {{0.0f, 1.0f, 0.5f, 0.0f}}},
+	{"delete",                       {{0.0f, 1.5f, 0.0f, 0.3f}}},
+	{"new",                          {{0.0f, 1.0f, 0.0f, 1.0f}}},
+	{"this",                         {{0.0f, 1.0f, 0.0f, 1.0f}}},
+
+	{"function",                     {{0.0f, 0.0f, 0.0f, 3.0f}}},
+	{"let",                          {{0.0f, 0.0f, 0.0f, 2.0f}}},
+	{"var",                          {{0.0f, 0.0f, 0.0f, 2.0f}}},
+	{"const",                        {{0.0f, 0.5f, 0.5f, 1.0f}}},
+	{"console",                      {{0.0f, 0.0f, 0.0f, 3.0f}}},
+	{"require",                      {{0.0f, 0.0f, 0.0f, 2.0f}}},
+	{"module",                       {{0.0f, 0.0f, 0.0f, 1.0f}}},
+	{"exports",                      {{0.0f, 0.0f, 0.0f, 2.0f}}},
+	{"export",                       {{0.0f, 0.0f, 0.0f, 2.0f}}},
+	{"undefined",                    {{0.0f, 0.0f, 0.0f, 3.0f}}},
+	{"null",                         {{0.0f, 0.0f, 0.0f, 1.0f}}},
+	{"typeof",                       {{0.0f, 0.0f, 0.0f, 2.0f}}},
+	{"prototype",                    {{0.0f, 0.0f, 0.0f, 2.0f}}},
+	{"document",                     {{0.0f, 0.0f, 0.0f, 2.0f}}},
+	{"window",                       {{0.0f, 0.0f, 0.0f, 1.0f}}},
+	{"JSON",                         {{0.0f, 0.0f, 0.0f, 1.0f}}}
+};
+
+const std::unordered_map<std::string_view, Weights>& wordWeights() {
+	static const std::unordered_map<std::string_view, Weights> table = [] {
+		std::unordered_map<std::string_view, Weights> out;
+		for (const WordWeight& entry : WORDS) {
+			out.emplace(entry.word, entry.weights);
+		}
+		return out;
+	}();
+	return table;
+}
+
+struct ExtensionHint {
+	const char* extension;
+	Weights prior;
+};
+
+// a known extension is worth a few strong features; ".h" is split between C and C++
+const ExtensionHint EXTENSIONS[] = {
+	{".py",  {{6.0f, 0.0f, 0.0f, 0.0f}}},
+	{".pyw", {{6.0f, 0.0f, 0.0f, 0.0f}}},
+	{".pyi", {{6.0f, 0.0f, 0.0f, 0.0f}}},
+	{".c",   {{0.0f, 0.0f, 6.0f, 0.0f}}},
+	{".h",   {{0.0f, 3.0f, 3.0f, 0.0f}}},
+	{".cpp", {{0.0f, 6.0f, 0.0f, 0.0f}}},
+	{".cc",  {{0.0f, 6.0f, 0.0f, 0.0f}}},
+	{".cxx", {{0.0f, 6.0f, 0.0f, 0.0f}}},
+	{".hpp", {{0.0f, 6.0f, 0.0f, 0.0f}}},
+	{".hh",  {{0.0f, 6.0f, 0.0f, 0.0f}}},
+	{".hxx", {{0.0f, 6.0f, 0.0f, 0.0f}}},
+	{".js",  {{0.0f, 0.0f, 0.0f, 6.0f}}},
+	{".mjs", {{0.0f, 0.0f, 0.0f, 6.0f}}},
+	{".cjs", {{0.0f, 0.0f, 0.0f, 6.0f}}},
+	{".jsx", {{0.0f, 0.0f, 0.0f, 6.0f}}}
+};
+
+const ExtensionHint* findExtension(std::string_view fileName) {
+	size_t slash = fileName.find_last_of("/\\");
+	if (slash != std::string_view::npos) {
+		fileName.remove_prefix(slash + 1);
+	}
+	size_t dot = fileName.rfind('.');
+	if (dot == std::string_view::npos || dot == 0) {
+		return nullptr;
+	}
+	std::string_view extension = fileName.substr(dot);
+	for (const ExtensionHint& hint : EXTENSIONS) {
+		std::string_view known = hint.extension;
+		if (known.size() == extension.size() &&
+			std::equal(known.begin(), known.end(), extension.begin(), [](char a, char b) {
+				return a == std::tolower(static_cast<unsigned char>(b));
+			})) {
+			return &hint;
+		}
+	}
+	return nullptr;
+}
+
+// evidence needed before a guess can be settled early, and the lead it needs
+const float SETTLED_SCORE = 40.0f;
+const float SETTLED_RATIO = 4.0f;
+// less evidence than this is no guess at all
+const float MIN_SCORE = 2.0f;
+// evidence at which the confidence stops being discounted
+const float FULL_EVIDENCE = 20.0f;
+
+inline bool isWordStart(unsigned char c) {
+	return std::isalpha(c) || c == '_' || c == '$';
+}
+
+inline bool isWordByte(unsigned char c) {
+	return std::isalnum(c) || c == '_' || c == '$';
+}
+
+class Scorer {
+public:
+	explicit Scorer(const Weights* prior) {
+		for (int i = 0; i < SLOTS; ++i) {
+			score_[i] = prior != nullptr ? prior->w[i] : 0.0f;
+		}
+	}
+
+	void add(const Weights& weights) {
+		for (int i = 0; i < SLOTS; ++i) {
+			score_[i] += weights.w[i];
+		}
+	}
+	void add(Slot slot, float amount) {
+		score_[slot] += amount;
+	}
+	void addCFamily(float amount) {
+		score_[C] += amount;
+		score_[CPP] += amount;
+		score_[JS] += amount;
+	}
+
+	int leader() const {
+		int best = 0;
+		for (int i = 1; i < SLOTS; ++i) {
+			if (score_[i] > score_[best]) {
+				best = i;
+			}
+		}
+		return best;
+	}
+	float runnerUp(int leader) const {
+		float second = 0.0f;
+		for (int i = 0; i < SLOTS; ++i) {
+			if (i != leader) {
+				second = std::max(second, score_[i]);
+			}
+		}
+		return second;
+	}
+	bool settled() const {
+		int best = leader();
+		return score_[best] >= SETTLED_SCORE && score_[best] >= SETTLED_RATIO * runnerUp(best);
+	}
+
+	LanguageGuess guess(size_t scanned) const {
+		LanguageGuess out;
+		out.bytesScanned = scanned;
+		int best = leader();
+		if (score_[best] < MIN_SCORE) {
+			return out;
+		}
+		float total = 0.0f;
+		for (float score : score_) {
+			total += score;
+		}
+		out.language = SLOT_LANGUAGE[best];
+		out.confidence = (score_[best] / total) * std::min(1.0f, score_[best] / FULL_EVIDENCE);
+		return out;
+	}
+
+private:
+	float score_[SLOTS];
+};
+
+}  // namespace
+
+LanguageDetector::LanguageDetector(size_t prefixBytes) : prefixBytes_(std::max<size_t>(prefixBytes, 1)) {
+}
+
+/*
+ * Guess the language of code
+ * Words are looked up in a weight table; a few operators, line endings and
+ * comment styles add evidence as well. Strings and comments are skipped.
+ * @param code: code to look at (only the first prefixBytes are read)
+ * @param fileName: name whose extension counts as evidence (may be empty)
+ * @return: language, confidence and bytes read
+ */
+LanguageGuess LanguageDetector::detect(std::string_view code, std::string_view fileName) const {
+	const ExtensionHint* hint = fileName.empty() ? nullptr : findExtension(fileName);
+	Scorer scorer(hint != nullptr ? &hint->prior : nullptr);
+	const std::unordered_map<std::string_view, Weights>& words = wordWeights();
+
+	const char* begin = code.data();
+	const char* end = begin + std::min(code.size(), prefixBytes_);
+	const char* p = begin;
+
+	std::string_view firstWord;  // first word of the current line
+	char last = 0;               // last non-blank byte of the current line
+	bool lineStart = true;
+
+	auto skipPast = [&](char close) {
+		// to the closing byte on the same line, honoring backslash escapes
+		while (p < end && *p != close && *p != '\n') {
+			p += (*p == '\\' && p + 1 < end) ? 2 : 1;
+		}
+		if (p < end && *p == close) {
+			++p;
+		}
+	};
+	auto skipLine = [&]() {
+		while (p < end && *p != '\n') {
+			++p;
+		}
+	};
+
+	while (p < end) {
+		unsigned char c = static_cast<unsigned char>(*p);
+
+		if (c == '\n') {
+			if (last == ':') {
+				scorer.add(PY, 1.0f);
+			}
+			else if (last == ';' || last == '{') {
+				scorer.addCFamily(0.3f);
+			}
+			if (scorer.settled()) {
+				return scorer.guess(static_cast<size_t>(p + 1 - begin));
+			}
+			firstWord = std::string_view();
+			last = 0;
+			lineStart = true;
+			++p;
+			continue;
+		}
+		if (c == ' ' || c == '\t' || c == '\r') {
+			++p;
+			continue;
+		}
+
+		bool atLineStart = lineStart;
+		lineStart = false;
+		last = static_cast<char>(c);
+
+		if (isWordStart(c)) {
+			const char* start = p;
+			while (p < end && isWordByte(static_cast<unsigned char>(*p))) {
+				++p;
+			}
+			std::string_view word(start, static_cast<size_t>(p - start));
+			last = word.back();
+
+			// "from x import y" is Python, "import x from 'y'" is JavaScript
+			if (word == "import" && firstWord == "from") {
+				scorer.add(PY, 3.0f);
+			}
+			else if (word == "from" && firstWord == "import") {
+				scorer.add(JS, 3.0f);
+			}
+			else {
+				auto found = words.find(word);
+				if (found != words.end()) {
+					scorer.add(found->second);
+				}
+			}
+			if (firstWord.empty()) {
+				firstWord = word;
+			}
+			continue;
+		}
+		if (std::isdigit(c)) {
+			while (p < end && (isWordByte(static_cast<unsigned char>(*p)) || *p == '.')) {
+				++p;
+			}
+			continue;
+		}
+
+		char next = p + 1 < end ? p[1] : 0;
+		char after = p + 2 < end ? p[2] : 0;
+		switch (c) {
+		case '"':
+		case '\'':
+			if (next == c && after == c) {
+				// triple-quoted string: Python; skip to its end
+				scorer.add(PY, 2.0f);
+				const char quote[3] = {static_cast<char>(c), static_cast<char>(c), static_cast<char>(c)};
+				const char* close = std::search(p + 3, end, quote, quote + 3);
+				p = close == end ? end : close + 3;
+			}
+			else {
+				++p;
+				skipPast(static_cast<char>(c));
+			}
+			last = static_cast<char>(c);
+			break;
+		case '`':
+			scorer.add(JS, 1.0f);
+			++p;
+			skipPast('`');
+			break;
+		case '#':
+			if (atLineStart && isWordStart(static_cast<unsigned char>(next))) {
+				// preprocessor directive: its word is scored next
+				++p;
+			}
+			else {
+				scorer.add(PY, 0.5f);
+				skipLine();
+			}
+			break;
+		case '/':
+			if (next == '/') {
+				scorer.addCFamily(0.3f);
+				skipLine();
+			}
+			else if (next == '*') {
+				scorer.addCFamily(0.3f);
+				const char star[2] = {'*', '/'};
+				const char* close = std::search(p + 2, end, star, star + 2);
+				p = close == end ? end : close + 2;
+			}
+			else {
+				++p;
+			}
+			break;
+		case ':':
+			if (next == ':') {
+				scorer.add(CPP, 3.0f);
+				p += 2;
+			}
+			else {
+				++p;
+			}
+			break;
+		case '=':
+			if (next == '>') {
+				scorer.add(JS, 2.0f);
+				p += 2;
+			}
+			else if (next == '=' && after == '=') {
+				scorer.add(JS, 2.0f);
+				p += 3;
+			}
+			else {
+				++p;
+			}
+			break;
+		case '!':
+			if (next == '=' && after == '=') {
+				scorer.add(JS, 2.0f);
+				p += 3;
+			}
+			else {
+				++p;
+			}
+			break;
+		case '-':
+			if (next == '>') {
+				scorer.add(C, 0.7f);
+				scorer.add(CPP, 0.7f);
+				scorer.add(PY, 0.3f);
+				p += 2;
+			}
+			else {
+				++p;
+			}
+			break;
+		default:
+			++p;
+			break;
+		}
+	}
+
+	// a last line without a newline still counts
+	if (last == ':') {
+		scorer.add(PY, 1.0f);
+	}
+	else if (last == ';' || last == '{') {
+		scorer.addCFamily(0.3f);
+	}
+	return scorer.guess(static_cast<size_t>(p - begin));
+}
+
+Language LanguageDetector::extensionHint(std::string_view fileName) {
+	const ExtensionHint* hint = findExtension(fileName);
+	if (hint == nullptr) {
+		return Language::Unknown;
+	}
+	for (int i = 0; i < SLOTS; ++i) {
+		if (hint->prior.w[i] >= 6.0f) {
+			return SLOT_LANGUAGE[i];
+		}
+	}
+	return Language::Unknown;
+}
+
+uint32_t LanguageDetector::extensionId(std::string_view fileName) {
+	const ExtensionHint* hint = findExtension(fileName);
+	return hint == nullptr ? 0 : static_cast<uint32_t>(hint - EXTENSIONS) + 1;
+}
+
+}  // namespace code_educator
@@ -0,0 +1,614 @@
+#include "Lexer.hpp"
+#include "ByteScan.hpp"
+#include "CoreStats.hpp"
+#include <cstring>
+
+namespace code_educator {
+
+Language languageFromName(const std::string& name) {
+	if (name == "python") {
+		return Language::Python;
+	}
+	else if (name == "c") {
+		return Language::C;
+	}
+	else if (name == "cpp") {
+		return Language::Cpp;
+	}
+	else if (name == "javascript") {
+		return Language::JavaScript;
+	}
+	return Language::Unknown;
+}
+
+const char* languageName(Language language) {
+	switch (language) {
+		case Language::Python: return "python";
+		case Language::C: return "c";
+		case Language::Cpp: return "cpp";
+		case Language::JavaScript: return "javascript";
+		default: return "unknown";
+	}
+}
+
+Keyword classifyWord(const char* text, size_t length) {
+	auto is = [&](const char* word) { return std::memcmp(word, text, length) == 0; };
+	switch (length) {
+		case 2:
+			if (is("if")) return Keyword::If;
+			if (is("do")) return Keyword::Do;
+			if (is("or")) return Keyword::Or;
+			break;
+		case 3:
+			if (is("for")) return Keyword::For;
+			if (is("try")) return Keyword::Try;
+			if (is("new")) return Keyword::New;
+			if (is("and")) return Keyword::And;
+			if (is("def")) return Keyword::Def;
+			if (is("let")) return Keyword::Let;
+			if (is("var")) return Keyword::Var;
+			if (is("std")) return Keyword::Std;
+			break;
+		case 4:
+			if (is("elif")) return Keyword::Elif;
+			if (is("else")) return Keyword::Else;
+			if (is("case")) return Keyword::Case;
+			if (is("goto")) return Keyword::Goto;
+			if (is("from")) return Keyword::From;
+			if (is("eval")) return Keyword::Eval;
+			if (is("free")) return Keyword::Free;
+			break;
+		case 5:
+			if (is("while")) return Keyword::While;
+			if (is("catch")) return Keyword::Catch;
+			if (is("throw")) return Keyword::Throw;
+			if (is("class")) return Keyword::Class;
+			if (is("const")) return Keyword::Const;
+			if (is("async")) return Keyword::Async;
+			if (is("final")) return Keyword::Final;
+			if (is("using")) return Keyword::Using;
+			break;
+		case 6:
+			if (is("switch")) return Keyword::Switch;
+			if (is("except")) return Keyword::Except;
+			if (is("return")) return Keyword::Return;
+			if (is("delete")) return Keyword::Delete;
+			if (is("sizeof")) return Keyword::Sizeof;
+			if (is("struct")) return Keyword::Struct;
+			if (is("import")) return Keyword::Import;
+			if (is("global")) return Keyword::Global;
+			if (is("malloc")) return Keyword::Malloc;
+			if (is("strcpy")) return Keyword::Strcpy;
+			break;
+		case 7:
+			if (is("require")) return Keyword::Require;
+			break;
+		case 8:
+			if (is("function")) return Keyword::Function;
+			if (is("noexcept")) return Keyword::Noexcept;
+			if (is("override")) return Keyword::Override;
+			break;
+		case 9:
+			if (is("namespace")) return Keyword::Namespace;
+			break;
+		default:
+			break;
+	}
+	return Keyword::None;
+}
+
+namespace {
+
+const ByteSet blockCommentStops{'*', '\n'};
+const ByteSet directiveStops{'/', '\n'};
+
+inline bool isIdentStart(unsigned char c) {
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '$';
+}
+
+inline bool isIdentChar(unsigned char c) {
+	return isIdentStart(c) || (c >= '0' && c <= '9');
+}
+
+inline bool isDigit(unsigned char c) {
+	return c >= '0' && c <= '9';
+}
+
+// length of the operator starting at p (1 for anything not in the table)
+size_t punctLength(const char* p, const char* end) {
+	if (end - p < 2) {
+		return 1;
+	}
+	char c = p[0];
+	char n = p[1];
+	bool three = end - p >= 3;
+	switch (c) {
+		case '=':
+			if (n == '=') return (three && p[2] == '=') ? 3 : 2;
+			return n == '>' ? 2 : 1;
+		case '!':
+			if (n == '=') return (three && p[2] == '=') ? 3 : 2;
+			return 1;
+		case '<':
+		case '>':
+			if (n == c) return (three && p[2] == '=') ? 3 : 2;
+			return n == '=' ? 2 : 1;
+		case '*':
+			if (n == '*') return (three && p[2] == '=') ? 3 : 2;
+			return n == '=' ? 2 : 1;
+		case '.':
+			return (n == '.' && three && p[2] == '.') ? 3 : 1;
+		case '&':
+		case '|':
+		case '+':
+			return (n == c || n == '=') ? 2 : 1;
+		case '-':
+			return (n == '-' || n == '=' || n == '>') ? 2 : 1;
+		case ':':
+			return n == ':' ? 2 : 1;
+		case '?':
+			return (n == '?' || n == '.') ? 2 : 1;
+		case '/':
+			return (n == '/' || n == '=') ? 2 : 1;
+		case '%':
+		case '^':
+			return n == '=' ? 2 : 1;
+		default:
+			return 1;
+	}
+}
+
+// JavaScript keywords after which a '/' begins a regex literal
+bool keywordExpectsOperand(const char* p, size_t n) {
+	auto is = [&](const char* w, size_t len) { return n == len && std::memcmp(w, p, len) == 0; };
+	switch (p[0]) {
+		case 'r': return is("return", 6);
+		case 't': return is("typeof", 6) || is("throw", 5);
+		case 'c': return is("case", 4);
+		case 'd': return is("do", 2) || is("delete", 6);
+		case 'e': return is("else", 4);
+		case 'i': return is("in", 2) || is("instanceof", 10);
+		case 'o': return is("of", 2);
+		case 'n': return is("new", 3);
+		case 'v': return is("void", 4);
+		case 'y': return is("yield", 5);
+		case 'a': return is("await", 5);
+		default: return false;
+	}
+}
+
+}  // namespace
+
+Lexer::Lexer(Language language)
+	: language_(language),
+	  hashComments_(language == Language::Python),
+	  slashComments_(language != Language::Python),
+	  tripleQuotes_(language == Language::Python),
+	  templates_(language == Language::JavaScript),
+	  regexLiterals_(language == Language::JavaScript),
+	  directives_(language == Language::C || language == Language::Cpp) {
+}
+
+/*
+ * Tokenize the whole buffer
+ * @param code: code to tokenize
+ * @return: tokens and per-line information
+ */
+TokenStream Lexer::tokenize(std::string_view code) const {
+	TokenStream stream;
+	tokenize(code, stream);
+	return stream;
+}
+
+/*
+ * Tokenize the whole buffer into an existing stream
+ * @param code: code to tokenize
+ * @param out: receives the tokens and per-line information (previous
+ *             contents are dropped, capacity is kept)
+ */
+void Lexer::tokenize(std::string_view code, TokenStream& out) const {
+	StageTimer timer(Stage::Lex, code.size());
+	out.language = language_;
+	out.tokens.clear();
+	out.lines.clear();
+	out.tokens.reserve(code.size() / 4 + 16);
+	out.lines.reserve(code.size() / 24 + 2);
+
+	LexState state;
+	scan(code.data(), code.size(), 0, state, out);
+	finish(state, out);
+}
+
+void Lexer::finish(LexState& state, TokenStream& out) const {
+	if (!state.atLineStart || state.leading > 0) {
+		uint8_t flags = state.lineFlags;
+		if (!(flags & LINE_NONBLANK)) {
+			flags &= LINE_CONTINUED;
+		}
+		out.lines.push_back(LineInfo{state.lineOffset, state.indent, state.leading, flags});
+	}
+}
+
+/*
+ * Single forward pass over the buffer. Code is split into tokens, while
+ * strings, comments and directives are scanned up to their terminator and
+ * emitted once per line they touch.
+ */
+void Lexer::scan(const char* data, size_t size, size_t base, LexState& state, TokenStream& out) const {
+	const char* p = data;
+	const char* end = data + size;
+	const char* pieceStart = p;  // start of the current string/comment piece
+
+	auto offsetOf = [&](const char* q) { return base + static_cast<size_t>(q - data); };
+
+	auto emit = [&](TokenType type, const char* from, const char* to) {
+		Keyword keyword = type == TokenType::Identifier ? classifyWord(from, static_cast<size_t>(to - from)) : Keyword::None;
+		out.tokens.push_back(Token{offsetOf(from), static_cast<uint32_t>(to - from), state.line, type, keyword});
+	};
+
+	// emit the part of a multi-line token that lies on the current line
+	auto emitPiece = [&](const char* to) {
+		const char* trimmed = to;
+		if (trimmed > pieceStart && trimmed[-1] == '\r') {
+			--trimmed;
+		}
+		if (trimmed <= pieceStart) {
+			return;
+		}
+		TokenType type = TokenType::String;
+		uint8_t flag = LINE_HAS_CODE;
+		if (state.mode == LexMode::LineComment || state.mode == LexMode::BlockComment) {
+			type = TokenType::Comment;
+			flag = LINE_HAS_COMMENT;
+		}
+		else if (state.mode == LexMode::Directive) {
+			type = TokenType::Directive;
+		}
+		else if (state.docstring) {
+			flag = LINE_HAS_COMMENT;
+		}
+		emit(type, pieceStart, trimmed);
+		state.lineFlags |= flag;
+	};
+
+	// p points at '\n'
+	auto newline = [&]() {
+		uint8_t flags = state.lineFlags;
+		if (!(flags & LINE_NONBLANK)) {
+			flags &= LINE_CONTINUED;
+		}
+		out.lines.push_back(LineInfo{state.lineOffset, state.indent, state.leading, flags});
+		++p;
+		state.line++;
+		state.lineOffset = offsetOf(p);
+		state.indent = 0;
+		state.leading = 0;
+		state.atLineStart = true;
+		state.lineFlags = state.mode == LexMode::Code ? 0 : LINE_CONTINUED;
+		pieceStart = p;
+	};
+
+	while (p < end) {
+		unsigned char c = static_cast<unsigned char>(*p);
+
+		// leading whitespace of a line
+		if (state.atLineStart) {
+			if (c == ' ') {
+				state.indent++;
+				state.leading++;
+				++p;
+				continue;
+			}
+			if (c == '\t') {
+				state.indent += 4;
+				state.leading++;
+				++p;
+				continue;
+			}
+			if (c == '\r' || c == '\f' || c == '\v') {
+				++p;
+				continue;
+			}
+			if (c != '\n') {
+				state.atLineStart = false;
+				state.lineFlags |= LINE_NONBLANK;
+				pieceStart = p;
+			}
+		}
+
+		switch (state.mode) {
+		case LexMode::LineComment:
+		{
+			const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+			if (!nl) {
+				p = end;
+				break;
+			}
+			p = static_cast<const char*>(nl);
+			emitPiece(p);
+			state.mode = LexMode::Code;
+			newline();
+			break;
+		}
+
+		case LexMode::BlockComment:
+		{
+			// jump from one '*' or newline to the next
+			while ((p = findFirstOf(p, end, blockCommentStops)) < end && *p == '*' && !(p + 1 < end && p[1] == '/')) {
+				++p;
+			}
+			if (p == end) {
+				break;
+			}
+			if (*p == '\n') {
+				emitPiece(p);
+				newline();
+			}
+			else {
+				p += 2;
+				emitPiece(p);
+				state.mode = LexMode::Code;
+			}
+			break;
+		}
+
+		case LexMode::Directive:
+		{
+			while (p < end) {
+				const char* stop = findFirstOf(p, end, directiveStops);
+				// a backslash continues the line when it is the last non-blank byte
+				const char* last = stop;
+				while (last > p && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r')) {
+					--last;
+				}
+				if (last > p) {
+					state.escapedNewline = (last[-1] == '\\');
+				}
+				p = stop;
+				if (p == end || *p == '\n' || (p + 1 < end && (p[1] == '/' || p[1] == '*'))) {
+					break;
+				}
+				state.escapedNewline = false;  // a lone '/'
+				++p;
+			}
+			if (p == end) {
+				break;
+			}
+			if (*p == '\n') {
+				emitPiece(p);
+				if (!state.escapedNewline) {
+					state.mode = LexMode::Code;
+				}
+				state.escapedNewline = false;
+				newline();
+			}
+			else {
+				emitPiece(p);
+				state.escapedNewline = false;
+				state.mode = LexMode::Code;
+			}
+			break;
+		}
+
+		case LexMode::String:
+		case LexMode::TripleString:
+		case LexMode::Template:
+		case LexMode::Regex:
+		{
+			bool closed = false;
+			ByteSet stops{'\\', '\n', state.quote};
+			while (p < end) {
+				if (state.mode != LexMode::Regex) {
+					// skip the plain part of the literal
+					p = findFirstOf(p, end, stops);
+					if (p == end) {
+						break;
+					}
+				}
+				char ch = *p;
+				if (ch == '\\') {
+					if (p + 1 < end && p[1] == '\n') {
+						state.escapedNewline = true;
+						++p;
+						break;
+					}
+					p += (p + 1 < end) ? 2 : 1;
+					continue;
+				}
+				if (ch == '\n') {
+					break;
+				}
+				if (state.mode == LexMode::Regex) {
+					if (ch == '[') {
+						state.regexClass = true;
+					}
+					else if (ch == ']') {
+						state.regexClass = false;
+					}
+					else if (ch == '/' && !state.regexClass) {
+						++p;
+						while (p < end && isIdentChar(static_cast<unsigned char>(*p))) {
+							++p;  // flags
+						}
+						closed = true;
+						break;
+					}
+					++p;
+					continue;
+				}
+				if (ch == state.quote) {
+					if (state.mode == LexMode::TripleString) {
+						if (p + 2 < end && p[1] == ch && p[2] == ch) {
+							p += 3;
+							closed = true;
+							break;
+						}
+						++p;
+						continue;
+					}
+					++p;
+					closed = true;
+					break;
+				}
+				++p;
+			}
+			if (closed) {
+				emitPiece(p);
+				state.mode = LexMode::Code;
+				state.docstring = false;
+				state.regexClass = false;
+				state.expectOperand = false;
+				break;
+			}
+			if (p == end) {
+				break;
+			}
+			// newline inside the literal
+			emitPiece(p);
+			bool multiline = state.mode == LexMode::TripleString || state.mode == LexMode::Template;
+			if (!multiline && !state.escapedNewline) {
+				state.mode = LexMode::Code;  // unterminated literal
+				state.docstring = false;
+				state.regexClass = false;
+			}
+			state.escapedNewline = false;
+			newline();
+			break;
+		}
+
+		case LexMode::Code:
+		{
+			if (c == '\n') {
+				newline();
+				break;
+			}
+			if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v') {
+				++p;
+				break;
+			}
+
+			const char* start = p;
+			bool firstOnLine = !(state.lineFlags & (LINE_HAS_CODE | LINE_HAS_COMMENT));
+			bool prefixed = false;
+
+			if (isIdentStart(c)) {
+				while (p < end && isIdentChar(static_cast<unsigned char>(*p))) {
+					++p;
+				}
+				// Python string prefixes (r"", b'', f"""...""")
+				if (tripleQuotes_ && p < end && (*p == '"' || *p == '\'') && p - start <= 2) {
+					bool prefix = true;
+					for (const char* q = start; q < p; ++q) {
+						if (!std::strchr("rRbBuUfF", *q)) {
+							prefix = false;
+						}
+					}
+					if (prefix) {
+						prefixed = true;
+						c = static_cast<unsigned char>(*p);
+					}
+				}
+				if (!prefixed) {
+					emit(TokenType::Identifier, start, p);
+					state.lineFlags |= LINE_HAS_CODE;
+					state.expectOperand = regexLiterals_ && keywordExpectsOperand(start, static_cast<size_t>(p - start));
+					break;
+				}
+			}
+
+			if (isDigit(c) || (c == '.' && p + 1 < end && isDigit(static_cast<unsigned char>(p[1])))) {
+				++p;
+				while (p < end) {
+					unsigned char d = static_cast<unsigned char>(*p);
+					if (isIdentChar(d) || d == '.' || (d == '\'' && directives_)) {
+						++p;
+					}
+					else if ((d == '+' || d == '-') && (p[-1] == 'e' || p[-1] == 'E') &&
+							 !(start[0] == '0' && p - start > 1 && (start[1] == 'x' || start[1] == 'X'))) {
+						++p;
+					}
+					else {
+						break;
+					}
+				}
+				emit(TokenType::Number, start, p);
+				state.lineFlags |= LINE_HAS_CODE;
+				state.expectOperand = false;
+				break;
+			}
+
+			if (c == '#') {
+				if (hashComments_) {
+					pieceStart = p;
+					state.mode = LexMode::LineComment;
+					++p;
+					break;
+				}
+				if (directives_ && firstOnLine) {
+					pieceStart = p;
+					state.mode = LexMode::Directive;
+					state.escapedNewline = false;
+					++p;
+					break;
+				}
+			}
+
+			if (c == '/' && slashComments_ && p + 1 < end) {
+				if (p[1] == '/') {
+					pieceStart = p;
+					state.mode = LexMode::LineComment;
+					p += 2;
+					break;
+				}
+				if (p[1] == '*') {
+					pieceStart = p;
+					state.mode = LexMode::BlockComment;
+					p += 2;
+					break;
+				}
+			}
+
+			if (c == '/' && regexLiterals_ && state.expectOperand) {
+				pieceStart = p;
+				state.mode = LexMode::Regex;
+				state.regexClass = false;
+				++p;
+				break;
+			}
+
+			if (prefixed || c == '"' || c == '\'' || (c == '`' && templates_)) {
+				pieceStart = start;
+				state.quote = static_cast<char>(c);
+				if (c == '`') {
+					state.mode = LexMode::Template;
+					++p;
+				}
+				else if (tripleQuotes_ && p + 2 < end && p[1] == static_cast<char>(c) && p[2] == static_cast<char>(c)) {
+					state.mode = LexMode::TripleString;
+					state.docstring = firstOnLine;
+					p += 3;
+				}
+				else {
+					state.mode = LexMode::String;
+					++p;
+				}
+				break;
+			}
+
+			p += punctLength(p, end);
+			emit(TokenType::Punct, start, p);
+			state.lineFlags |= LINE_HAS_CODE;
+			state.expectOperand = !(c == ')' || c == ']' || c == '}' ||
+				(p - start == 2 && (start[0] == '+' || start[0] == '-') && start[0] == start[1]));
+			break;
+		}
+		}
+	}
+
+	// buffer ended inside a string/comment/directive: flush what we have
+	if (state.mode != LexMode::Code && pieceStart < end) {
+		emitPiece(end);
+	}
+}
+
+}  // namespace code_educator
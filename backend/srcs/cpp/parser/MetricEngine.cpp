@@ -0,0 +1,216 @@
+#include "MetricEngine.hpp"
+#include <algorithm>
+
+namespace code_educator {
+
+MetricEngine::MetricEngine(Language language) : language_(language) {
+}
+
+/*
+ * Consume the next piece of a token stream
+ * Lines and tokens are walked together in line order, so each token and each
+ * line is visited exactly once.
+ * @param base: buffer the token offsets point into
+ * @param stream: tokens and lines produced by the Lexer
+ */
+void MetricEngine::consume(const char* base, const TokenStream& stream) {
+	const std::vector<Token>& tokens = stream.tokens;
+	size_t t = 0;
+
+	for (const LineInfo& line : stream.lines) {
+		int parenAtStart = lineStarted_ ? lineStartParen_ : carry_.parenDepth;
+		while (t < tokens.size() && tokens[t].line == lineNo_) {
+			consumeToken(base, tokens[t++]);
+		}
+		endLine(line, parenAtStart);
+		lineNo_++;
+		lineStarted_ = false;
+	}
+
+	// tokens of a line that is not finished yet
+	if (t < tokens.size() && !lineStarted_) {
+		lineStarted_ = true;
+		lineStartParen_ = carry_.parenDepth;
+	}
+	for (; t < tokens.size(); ++t) {
+		consumeToken(base, tokens[t]);
+	}
+}
+
+/*
+ * Consume one complete line
+ * Used when lines are visited out of stream order; restore() the carry of
+ * the line first.
+ * @param base: buffer the token offsets point into
+ * @param line: line information
+ * @param tokens: tokens of the line
+ * @param count: number of tokens
+ */
+void MetricEngine::consumeLine(const char* base, const LineInfo& line, const Token* tokens, size_t count) {
+	int parenAtStart = carry_.parenDepth;
+	for (size_t i = 0; i < count; ++i) {
+		consumeToken(base, tokens[i]);
+	}
+	endLine(line, parenAtStart);
+}
+
+void MetricEngine::resetCounters() {
+	counters_.lineCount = 0;
+	counters_.commentCount = 0;
+	counters_.nestingLength = 0;
+	counters_.cyclomaticComplexity = 1;
+	counters_.tokenFrequency.clear();
+	counters_.facts = 0;
+}
+
+void MetricEngine::consumeToken(const char* base, const Token& token) {
+	const char* text = base + token.offset;
+
+	switch (token.type) {
+	case TokenType::Identifier:
+	{
+		if (countTokens_) {
+			counters_.tokenFrequency.add(std::string_view(text, token.length));
+		}
+
+		switch (token.keyword) {
+			case Keyword::If: case Keyword::Elif: case Keyword::For: case Keyword::While:
+			case Keyword::Case: case Keyword::Switch: case Keyword::Catch:
+				counters_.cyclomaticComplexity++;
+				break;
+			case Keyword::Except:
+				counters_.cyclomaticComplexity++;
+				counters_.facts |= FACT_EXCEPT;
+				break;
+			case Keyword::And: case Keyword::Or:
+				if (language_ == Language::Python) {
+					counters_.cyclomaticComplexity++;
+				}
+				break;
+			case Keyword::Goto:
+				if (language_ == Language::C || language_ == Language::Cpp) {
+					counters_.cyclomaticComplexity++;
+				}
+				break;
+			case Keyword::Global:
+				counters_.facts |= FACT_GLOBAL;
+				break;
+			case Keyword::Std:
+				if (carry_.prev == Keyword::Namespace && carry_.prev2 == Keyword::Using) {
+					counters_.facts |= FACT_USING_NAMESPACE_STD;
+				}
+				break;
+			case Keyword::New: counters_.facts |= FACT_NEW; break;
+			case Keyword::Delete: counters_.facts |= FACT_DELETE; break;
+			case Keyword::Var: counters_.facts |= FACT_VAR; break;
+			case Keyword::Malloc: counters_.facts |= FACT_MALLOC; break;
+			case Keyword::Free: counters_.facts |= FACT_FREE; break;
+			case Keyword::Strcpy: counters_.facts |= FACT_STRCPY; break;
+			default: break;
+		}
+		carry_.prev2 = carry_.prev;
+		carry_.prev = token.keyword;
+		carry_.lastWasBackslash = false;
+		return;
+	}
+
+	case TokenType::Punct:
+	{
+		char c = text[0];
+		if (token.length == 1) {
+			switch (c) {
+				case '{':
+					if (language_ != Language::Python) {
+						carry_.depth++;
+						counters_.nestingLength = std::max(counters_.nestingLength, carry_.depth);
+					}
+					else {
+						carry_.parenDepth++;
+					}
+					break;
+				case '}':
+					if (language_ != Language::Python) {
+						carry_.depth = std::max(carry_.depth - 1, 0);
+					}
+					else {
+						carry_.parenDepth = std::max(carry_.parenDepth - 1, 0);
+					}
+					break;
+				case '(':
+				case '[':
+					carry_.parenDepth++;
+					if (c == '(' && carry_.prev == Keyword::Eval) {
+						counters_.facts |= FACT_EVAL_CALL;
+					}
+					break;
+				case ')':
+				case ']':
+					carry_.parenDepth = std::max(carry_.parenDepth - 1, 0);
+					break;
+				case '?':
+					counters_.cyclomaticComplexity++;
+					break;
+				case ':':
+					if (carry_.prev == Keyword::Except) {
+						counters_.facts |= FACT_BARE_EXCEPT;
+					}
+					break;
+				default:
+					break;
+			}
+		}
+		else if (token.length == 2) {
+			char n = text[1];
+			if ((c == '&' && n == '&') || (c == '|' && n == '|')) {
+				counters_.cyclomaticComplexity++;
+			}
+			else if ((c == '=' || c == '!') && n == '=') {
+				counters_.facts |= FACT_LOOSE_EQUALITY;
+			}
+		}
+		carry_.prev2 = carry_.prev;
+		carry_.prev = Keyword::None;
+		carry_.lastWasBackslash = (token.length == 1 && c == '\\');
+		return;
+	}
+
+	case TokenType::Comment:
+		return;
+
+	default:
+		carry_.prev2 = carry_.prev;
+		carry_.prev = Keyword::None;
+		carry_.lastWasBackslash = false;
+		return;
+	}
+}
+
+void MetricEngine::endLine(const LineInfo& line, int parenAtStart) {
+	if (line.flags & LINE_NONBLANK) {
+		counters_.lineCount++;
+	}
+	if (line.flags & LINE_HAS_COMMENT) {
+		counters_.commentCount++;
+	}
+
+	if (language_ == Language::Python) {
+		bool continuation = carry_.lineContinues;
+		carry_.lineContinues = carry_.lastWasBackslash;
+		carry_.lastWasBackslash = false;
+
+		// only lines that start a statement open or close a block
+		if (!(line.flags & LINE_HAS_CODE) || (line.flags & LINE_CONTINUED) ||
+			parenAtStart > 0 || continuation) {
+			return;
+		}
+		while (!carry_.indents.empty() && line.indent < carry_.indents.back()) {
+			carry_.indents.pop_back();
+		}
+		if (line.indent > (carry_.indents.empty() ? 0 : carry_.indents.back())) {
+			carry_.indents.push_back(line.indent);
+		}
+		counters_.nestingLength = std::max(counters_.nestingLength, static_cast<int>(carry_.indents.size()));
+	}
+}
+
+}  // namespace code_educator
@@ -0,0 +1,270 @@
+#include "ResultJson.hpp"
+#include <charconv>
+#include <cstring>
+
+namespace code_educator {
+
+namespace {
+
+const char HEX[] = "0123456789abcdef";
+
+inline bool continuation(unsigned char byte) {
+	return (byte & 0xC0) == 0x80;
+}
+
+// length of the valid UTF-8 sequence starting at p (lead byte >= 0x80), or 0
+size_t utf8Sequence(const unsigned char* p, const unsigned char* end) {
+	unsigned char lead = p[0];
+	size_t left = static_cast<size_t>(end - p);
+	if (lead >= 0xC2 && lead <= 0xDF) {
+		return left >= 2 && continuation(p[1]) ? 2 : 0;
+	}
+	if (lead >= 0xE0 && lead <= 0xEF) {
+		if (left < 3 || !continuation(p[1]) || !continuation(p[2])) {
+			return 0;
+		}
+		// no overlong forms, no surrogates
+		if ((lead == 0xE0 && p[1] < 0xA0) || (lead == 0xED && p[1] > 0x9F)) {
+			return 0;
+		}
+		return 3;
+	}
+	if (lead >= 0xF0 && lead <= 0xF4) {
+		if (left < 4 || !continuation(p[1]) || !continuation(p[2]) || !continuation(p[3])) {
+			return 0;
+		}
+		if ((lead == 0xF0 && p[1] < 0x90) || (lead == 0xF4 && p[1] > 0x8F)) {
+			return 0;
+		}
+		return 4;
+	}
+	return 0;
+}
+
+}  // namespace
+
+void JsonWriter::separate() {
+	if (afterKey_) {
+		afterKey_ = false;
+		return;
+	}
+	uint64_t bit = uint64_t(1) << (depth_ & 63);
+	if (nonEmpty_ & bit) {
+		out_ += ',';
+	}
+	nonEmpty_ |= bit;
+}
+
+void JsonWriter::open(char bracket) {
+	separate();
+	out_ += bracket;
+	depth_++;
+	nonEmpty_ &= ~(uint64_t(1) << (depth_ & 63));
+}
+
+void JsonWriter::close(char bracket) {
+	depth_--;
+	out_ += bracket;
+}
+
+void JsonWriter::beginObject() {
+	open('{');
+}
+
+void JsonWriter::endObject() {
+	close('}');
+}
+
+void JsonWriter::beginArray() {
+	open('[');
+}
+
+void JsonWriter::endArray() {
+	close(']');
+}
+
+void JsonWriter::key(std::string_view name) {
+	separate();
+	string(name);
+	out_ += ':';
+	afterKey_ = true;
+}
+
+void JsonWriter::value(std::string_view text) {
+	separate();
+	string(text);
+}
+
+void JsonWriter::value(int64_t number) {
+	separate();
+	char buffer[24];
+	auto done = std::to_chars(buffer, buffer + sizeof(buffer), number);
+	out_.append(buffer, done.ptr);
+}
+
+void JsonWriter::value(size_t number) {
+	separate();
+	char buffer[24];
+	auto done = std::to_chars(buffer, buffer + sizeof(buffer), number);
+	out_.append(buffer, done.ptr);
+}
+
+/*
+ * Write a number in its shortest round-trip form
+ * Integral values keep a ".0" like Python's json module writes them.
+ */
+void JsonWriter::value(double number) {
+	separate();
+	if (number != number || number - number != 0) {
+		out_ += "null";  // NaN and infinities have no JSON form
+		return;
+	}
+	char buffer[32];
+	auto done = std::to_chars(buffer, buffer + sizeof(buffer), number);
+	out_.append(buffer, done.ptr);
+	if (std::memchr(buffer, '.', done.ptr - buffer) == nullptr && std::memchr(buffer, 'e', done.ptr - buffer) == nullptr) {
+		out_ += ".0";
+	}
+}
+
+void JsonWriter::value(bool flag) {
+	separate();
+	out_ += flag ? "true" : "false";
+}
+
+void JsonWriter::null() {
+	separate();
+	out_ += "null";
+}
+
+/*
+ * Write a quoted, escaped string
+ * Runs of bytes that need no escaping are copied in one append.
+ */
+void JsonWriter::string(std::string_view text) {
+	out_ += '"';
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(text.data());
+	const unsigned char* end = p + text.size();
+	const unsigned char* run = p;
+	while (p < end) {
+		unsigned char byte = *p;
+		if (byte >= 0x20 && byte != '"' && byte != '\\' && byte < 0x80) {
+			++p;
+			continue;
+		}
+		if (byte >= 0x80) {
+			size_t length = utf8Sequence(p, end);
+			if (length != 0) {
+				p += length;
+				continue;
+			}
+		}
+
+		out_.append(reinterpret_cast<const char*>(run), static_cast<size_t>(p - run));
+		switch (byte) {
+			case '"': out_ += "\\\""; break;
+			case '\\': out_ += "\\\\"; break;
+			case '\n': out_ += "\\n"; break;
+			case '\r': out_ += "\\r"; break;
+			case '\t': out_ += "\\t"; break;
+			case '\b': out_ += "\\b"; break;
+			case '\f': out_ += "\\f"; break;
+			default:
+				if (byte < 0x20) {
+					char escape[6] = {'\\', 'u', '0', '0', HEX[byte >> 4], HEX[byte & 15]};
+					out_.append(escape, sizeof(escape));
+				}
+				else {
+					out_ += "\xEF\xBF\xBD";  // U+FFFD for a byte of invalid UTF-8
+				}
+				break;
+		}
+		run = ++p;
+	}
+	out_.append(reinterpret_cast<const char*>(run), static_cast<size_t>(p - run));
+	out_ += '"';
+}
+
+namespace {
+
+void writeStrings(JsonWriter& json, std::string_view name, const std::vector<std::string>& items) {
+	json.key(name);
+	json.beginArray();
+	for (const std::string& item : items) {
+		json.value(item);
+	}
+	json.endArray();
+}
+
+}  // namespace
+
+/*
+ * Write a report as the /analyze response object
+ * @param report: report to write
+ * @param out: buffer the JSON is appended to
+ * @param options: optional fields to include
+ */
+void writeReportJson(const AnalysisReport& report, std::string& out, const ReportJsonOptions& options) {
+	const CodeStructure& structure = report.structure;
+	const AnalysisResult& result = report.result;
+	JsonWriter json(out);
+
+	json.beginObject();
+	json.key("language");
+	json.value(structure.language);
+	json.key("complexity");
+	json.value(structure.complexity);
+	writeStrings(json, "imports", structure.imports);
+	writeStrings(json, "functions", structure.functions);
+	writeStrings(json, "classes", structure.classes);
+
+	json.key("line_count");
+	json.value(result.lineCount);
+	json.key("comment_count");
+	json.value(result.commentCount);
+	json.key("comment_ratio");
+	json.value(result.commentRatio);
+	json.key("nesting_depth");
+	json.value(result.nestingLength);
+	json.key("cyclomatic_complexity");
+	json.value(result.cyclomaticComplexity);
+	writeStrings(json, "potential_issues", result.potentialIssues);
+	writeStrings(json, "suggestions", result.suggestions);
+	json.key("quality_score");
+	json.value(report.qualityScore);
+
+	json.key("metadata");
+	json.beginObject();
+	for (const auto& item : result.metadata) {
+		json.key(item.first);
+		json.value(item.second);
+	}
+	json.endObject();
+
+	json.key("truncated");
+	json.value(result.truncated);
+	json.key("truncated_by");
+	if (result.truncated) {
+		json.value(result.truncatedBy);
+	}
+	else {
+		json.null();
+	}
+
+	if (options.tokenFrequency) {
+		json.key("token_frequency");
+		json.beginObject();
+		for (const auto& item : result.tokenFrequency) {
+			json.key(item.first);
+			json.value(item.second);
+		}
+		json.endObject();
+	}
+	if (options.cached) {
+		json.key("cached");
+		json.value(report.cached);
+	}
+	json.endObject();
+}
+
+}  // namespace code_educator
@@ -0,0 +1,531 @@
+#include "ResultSnapshot.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace code_educator {
+
+namespace {
+
+const char SNAPSHOT_MAGIC[4] = {'C', 'E', 'R', 'S'};
+
+enum SnapshotFlag : uint32_t {
+	HAS_STRUCTURE = 1 << 0,
+	HAS_RESULT = 1 << 1,
+	TRUNCATED = 1 << 2
+};
+
+// header field offsets
+const size_t AT_FORMAT = 4;
+const size_t AT_VERSION = 8;
+const size_t AT_FLAGS = 12;
+const size_t AT_COMPLEXITY = 16;
+const size_t AT_QUALITY = 20;
+const size_t AT_LINES = 24;
+const size_t AT_COMMENTS = 28;
+const size_t AT_NESTING = 32;
+const size_t AT_CYCLOMATIC = 36;
+const size_t AT_RATIO = 40;          // IEEE 754 bits, u64
+const size_t AT_BYTES = 48;          // u64
+const size_t AT_LANGUAGE = 56;       // string index
+const size_t AT_TRUNCATED_BY = 60;   // string index
+const size_t AT_STRING_COUNT = 64;
+const size_t AT_STRING_TABLE = 68;
+const size_t AT_SECTIONS = 72;       // u32 per section
+const size_t SECTIONS = 8;
+const size_t AT_TOTAL = AT_SECTIONS + SECTIONS * 4;
+const size_t HEADER_BYTES = AT_TOTAL + 4;
+
+enum Section : size_t {
+	IMPORTS,
+	FUNCTIONS,
+	CLASSES,
+	STRUCTURE_METADATA,
+	POTENTIAL_ISSUES,
+	SUGGESTIONS,
+	METADATA,
+	TOKENS
+};
+
+std::runtime_error invalid(const char* what) {
+	return std::runtime_error(std::string("invalid result snapshot: ") + what);
+}
+
+void putU32(std::string& out, size_t at, uint32_t value) {
+	for (int i = 0; i < 4; ++i) {
+		out[at + i] = static_cast<char>(value >> (i * 8));
+	}
+}
+
+void putU64(std::string& out, size_t at, uint64_t value) {
+	for (int i = 0; i < 8; ++i) {
+		out[at + i] = static_cast<char>(value >> (i * 8));
+	}
+}
+
+void appendU32(std::string& out, uint32_t value) {
+	for (int i = 0; i < 4; ++i) {
+		out.push_back(static_cast<char>(value >> (i * 8)));
+	}
+}
+
+void appendVarint(std::string& out, uint64_t value) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+uint64_t readU64(std::string_view data, size_t at) {
+	uint64_t value = 0;
+	for (int i = 7; i >= 0; --i) {
+		value = (value << 8) | static_cast<unsigned char>(data[at + i]);
+	}
+	return value;
+}
+
+// bounds-checked varint for validation; false past the end or when too long
+bool checkedVarint(std::string_view data, size_t& at, uint64_t& value) {
+	value = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (at >= data.size()) {
+			return false;
+		}
+		unsigned char byte = static_cast<unsigned char>(data[at++]);
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Collects the strings and sections of one snapshot, then lays them out.
+class SnapshotWriter {
+public:
+	SnapshotWriter() {
+		intern(std::string_view());
+	}
+
+	uint32_t intern(std::string_view text) {
+		auto found = index_.find(text);
+		if (found != index_.end()) {
+			return found->second;
+		}
+		uint32_t id = static_cast<uint32_t>(strings_.size());
+		strings_.push_back(text);
+		index_.emplace(text, id);
+		return id;
+	}
+
+	void list(Section section, const std::vector<std::string>& items) {
+		begin(section);
+		appendVarint(sections_, items.size());
+		for (const std::string& item : items) {
+			appendVarint(sections_, intern(item));
+		}
+	}
+
+	template <typename Map>
+	void map(Section section, const Map& items) {
+		begin(section);
+		appendVarint(sections_, items.size());
+		for (const auto& item : items) {
+			appendVarint(sections_, intern(item.first));
+			appendVarint(sections_, intern(item.second));
+		}
+	}
+
+	void tokens(const std::map<std::string, int>& counts) {
+		begin(TOKENS);
+		appendVarint(sections_, counts.size());
+		for (const auto& item : counts) {
+			int64_t count = item.second;
+			appendVarint(sections_, intern(item.first));
+			appendVarint(sections_, (static_cast<uint64_t>(count) << 1) ^ static_cast<uint64_t>(count >> 63));
+		}
+	}
+
+	/*
+	 * Lay out the snapshot: header, string offsets, string bytes, sections
+	 * @param header: header with the scalar fields set
+	 * @return: the snapshot
+	 */
+	std::string finish(std::string header) {
+		// sections never written are empty lists
+		for (size_t s = 0; s < SECTIONS; ++s) {
+			if (sectionAt_[s] == NONE) {
+				begin(static_cast<Section>(s));
+				appendVarint(sections_, 0);
+			}
+		}
+
+		size_t bytes = 0;
+		for (std::string_view text : strings_) {
+			bytes += text.size();
+		}
+		uint64_t tableAt = HEADER_BYTES;
+		uint64_t stringsAt = tableAt + (strings_.size() + 1) * 4;
+		uint64_t sectionsAt = stringsAt + bytes;
+		uint64_t total = sectionsAt + sections_.size();
+		if (total > UINT32_MAX) {
+			throw std::runtime_error("result snapshot larger than 4 GiB");
+		}
+
+		std::string out = std::move(header);
+		out.reserve(static_cast<size_t>(total));
+		putU32(out, AT_STRING_COUNT, static_cast<uint32_t>(strings_.size()));
+		putU32(out, AT_STRING_TABLE, static_cast<uint32_t>(tableAt));
+		for (size_t s = 0; s < SECTIONS; ++s) {
+			putU32(out, AT_SECTIONS + s * 4, static_cast<uint32_t>(sectionsAt + sectionAt_[s]));
+		}
+		putU32(out, AT_TOTAL, static_cast<uint32_t>(total));
+
+		uint64_t at = stringsAt;
+		for (std::string_view text : strings_) {
+			appendU32(out, static_cast<uint32_t>(at));
+			at += text.size();
+		}
+		appendU32(out, static_cast<uint32_t>(at));
+		for (std::string_view text : strings_) {
+			out.append(text.data(), text.size());
+		}
+		out += sections_;
+		return out;
+	}
+
+private:
+	static constexpr size_t NONE = SIZE_MAX;
+
+	void begin(Section section) {
+		sectionAt_[section] = sections_.size();
+	}
+
+	std::vector<std::string_view> strings_;
+	std::unordered_map<std::string_view, uint32_t> index_;
+	std::string sections_;
+	size_t sectionAt_[SECTIONS] = {NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE};
+};
+
+// header with nothing but the magic, format and analyzer version set
+std::string emptyHeader() {
+	std::string header(HEADER_BYTES, '\0');
+	std::memcpy(&header[0], SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+	putU32(header, AT_FORMAT, SNAPSHOT_FORMAT);
+	putU32(header, AT_VERSION, ANALYZER_VERSION);
+	return header;
+}
+
+void addStructure(SnapshotWriter& writer, std::string& header, const CodeStructure& structure) {
+	putU32(header, AT_COMPLEXITY, static_cast<uint32_t>(structure.complexity));
+	putU32(header, AT_LANGUAGE, writer.intern(structure.language));
+	writer.list(IMPORTS, structure.imports);
+	writer.list(FUNCTIONS, structure.functions);
+	writer.list(CLASSES, structure.classes);
+	// an unordered map: sorted so equal structures give equal bytes
+	std::map<std::string_view, std::string_view> metadata(structure.metadata.begin(), structure.metadata.end());
+	writer.map(STRUCTURE_METADATA, metadata);
+}
+
+uint32_t addResult(SnapshotWriter& writer, std::string& header, const AnalysisResult& result) {
+	putU32(header, AT_LINES, static_cast<uint32_t>(result.lineCount));
+	putU32(header, AT_COMMENTS, static_cast<uint32_t>(result.commentCount));
+	putU32(header, AT_NESTING, static_cast<uint32_t>(result.nestingLength));
+	putU32(header, AT_CYCLOMATIC, static_cast<uint32_t>(result.cyclomaticComplexity));
+	uint64_t ratio;
+	std::memcpy(&ratio, &result.commentRatio, sizeof(ratio));
+	putU64(header, AT_RATIO, ratio);
+	putU64(header, AT_BYTES, result.bytesAnalyzed);
+	putU32(header, AT_TRUNCATED_BY, writer.intern(result.truncatedBy));
+	writer.list(POTENTIAL_ISSUES, result.potentialIssues);
+	writer.list(SUGGESTIONS, result.suggestions);
+	writer.map(METADATA, result.metadata);
+	writer.tokens(result.tokenFrequency);
+	return HAS_RESULT | (result.truncated ? uint32_t(TRUNCATED) : 0u);
+}
+
+}  // namespace
+
+std::string writeSnapshot(const AnalysisReport& report) {
+	SnapshotWriter writer;
+	std::string header = emptyHeader();
+	addStructure(writer, header, report.structure);
+	uint32_t flags = HAS_STRUCTURE | addResult(writer, header, report.result);
+	putU32(header, AT_FLAGS, flags);
+	putU32(header, AT_QUALITY, static_cast<uint32_t>(report.qualityScore));
+	return writer.finish(std::move(header));
+}
+
+std::string writeSnapshot(const CodeStructure& structure) {
+	SnapshotWriter writer;
+	std::string header = emptyHeader();
+	addStructure(writer, header, structure);
+	putU32(header, AT_FLAGS, HAS_STRUCTURE);
+	return writer.finish(std::move(header));
+}
+
+std::string writeSnapshot(const AnalysisResult& result) {
+	SnapshotWriter writer;
+	std::string header = emptyHeader();
+	putU32(header, AT_FLAGS, addResult(writer, header, result));
+	return writer.finish(std::move(header));
+}
+
+std::string_view SnapshotView::Strings::iterator::operator*() const {
+	size_t at = at_;
+	return view_->string(static_cast<uint32_t>(view_->varint(at)));
+}
+
+SnapshotView::Strings::iterator& SnapshotView::Strings::iterator::operator++() {
+	view_->varint(at_);
+	left_--;
+	return *this;
+}
+
+std::vector<std::string> SnapshotView::Strings::toVector() const {
+	std::vector<std::string> out;
+	out.reserve(count_);
+	for (std::string_view text : *this) {
+		out.emplace_back(text);
+	}
+	return out;
+}
+
+SnapshotView::SnapshotView(std::string_view data) : data_(data) {
+	validate();
+	stringCount_ = u32(AT_STRING_COUNT);
+}
+
+/*
+ * Check the whole snapshot once
+ * Every offset, varint and string index is checked here, so the accessors
+ * can read without bounds checks.
+ */
+void SnapshotView::validate() const {
+	if (data_.size() < HEADER_BYTES || std::memcmp(data_.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+		throw invalid("bad magic");
+	}
+	uint32_t format = u32(AT_FORMAT);
+	if (format != SNAPSHOT_FORMAT) {
+		throw std::runtime_error("invalid result snapshot: unsupported format " + std::to_string(format));
+	}
+	if (u32(AT_TOTAL) != data_.size()) {
+		throw invalid("size mismatch");
+	}
+
+	uint64_t strings = u32(AT_STRING_COUNT);
+	uint64_t tableAt = u32(AT_STRING_TABLE);
+	if (strings == 0 || tableAt < HEADER_BYTES || tableAt + (strings + 1) * 4 > data_.size()) {
+		throw invalid("bad string table");
+	}
+	uint64_t previous = tableAt + (strings + 1) * 4;
+	for (uint64_t i = 0; i <= strings; ++i) {
+		uint64_t offset = u32(static_cast<size_t>(tableAt + i * 4));
+		if (offset < previous || offset > data_.size()) {
+			throw invalid("bad string offset");
+		}
+		previous = offset;
+	}
+	if (u32(AT_LANGUAGE) >= strings || u32(AT_TRUNCATED_BY) >= strings) {
+		throw invalid("bad string index");
+	}
+
+	for (size_t s = 0; s < SECTIONS; ++s) {
+		size_t at = u32(AT_SECTIONS + s * 4);
+		uint64_t count;
+		if (at < previous || !checkedVarint(data_, at, count) || count > data_.size()) {
+			throw invalid("bad section");
+		}
+		size_t perItem = (s == STRUCTURE_METADATA || s == METADATA || s == TOKENS) ? 2 : 1;
+		for (uint64_t i = 0; i < count * perItem; ++i) {
+			uint64_t value;
+			if (!checkedVarint(data_, at, value)) {
+				throw invalid("truncated section");
+			}
+			bool isCount = s == TOKENS && (i & 1);
+			if (!isCount && value >= strings) {
+				throw invalid("bad string index");
+			}
+		}
+	}
+}
+
+uint32_t SnapshotView::u32(size_t at) const {
+	uint32_t value = 0;
+	for (int i = 3; i >= 0; --i) {
+		value = (value << 8) | static_cast<unsigned char>(data_[at + i]);
+	}
+	return value;
+}
+
+uint64_t SnapshotView::varint(size_t& at) const {
+	uint64_t value = 0;
+	for (int shift = 0;; shift += 7) {
+		unsigned char byte = static_cast<unsigned char>(data_[at++]);
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) {
+			return value;
+		}
+	}
+}
+
+std::string_view SnapshotView::string(uint32_t index) const {
+	size_t tableAt = u32(AT_STRING_TABLE);
+	size_t begin = u32(tableAt + index * 4);
+	size_t end = u32(tableAt + (index + 1) * 4);
+	return data_.substr(begin, end - begin);
+}
+
+size_t SnapshotView::sectionStart(size_t section) const {
+	return u32(AT_SECTIONS + section * 4);
+}
+
+SnapshotView::Strings SnapshotView::list(size_t section, size_t perItem) const {
+	size_t at = sectionStart(section);
+	size_t count = static_cast<size_t>(varint(at));
+	return Strings(this, at, count * perItem);
+}
+
+bool SnapshotView::hasStructure() const {
+	return (u32(AT_FLAGS) & HAS_STRUCTURE) != 0;
+}
+
+bool SnapshotView::hasResult() const {
+	return (u32(AT_FLAGS) & HAS_RESULT) != 0;
+}
+
+uint32_t SnapshotView::analyzerVersion() const {
+	return u32(AT_VERSION);
+}
+
+std::string_view SnapshotView::language() const {
+	return string(u32(AT_LANGUAGE));
+}
+
+int SnapshotView::complexity() const {
+	return static_cast<int>(u32(AT_COMPLEXITY));
+}
+
+SnapshotView::Strings SnapshotView::imports() const {
+	return list(IMPORTS);
+}
+
+SnapshotView::Strings SnapshotView::functions() const {
+	return list(FUNCTIONS);
+}
+
+SnapshotView::Strings SnapshotView::classes() const {
+	return list(CLASSES);
+}
+
+SnapshotView::Strings SnapshotView::structureMetadata() const {
+	return list(STRUCTURE_METADATA, 2);
+}
+
+int SnapshotView::lineCount() const {
+	return static_cast<int>(u32(AT_LINES));
+}
+
+int SnapshotView::commentCount() const {
+	return static_cast<int>(u32(AT_COMMENTS));
+}
+
+double SnapshotView::commentRatio() const {
+	uint64_t bits = readU64(data_, AT_RATIO);
+	double ratio;
+	std::memcpy(&ratio, &bits, sizeof(ratio));
+	return ratio;
+}
+
+int SnapshotView::nestingLength() const {
+	return static_cast<int>(u32(AT_NESTING));
+}
+
+int SnapshotView::cyclomaticComplexity() const {
+	return static_cast<int>(u32(AT_CYCLOMATIC));
+}
+
+SnapshotView::Strings SnapshotView::potentialIssues() const {
+	return list(POTENTIAL_ISSUES);
+}
+
+SnapshotView::Strings SnapshotView::suggestions() const {
+	return list(SUGGESTIONS);
+}
+
+SnapshotView::Strings SnapshotView::metadata() const {
+	return list(METADATA, 2);
+}
+
+bool SnapshotView::truncated() const {
+	return (u32(AT_FLAGS) & TRUNCATED) != 0;
+}
+
+std::string_view SnapshotView::truncatedBy() const {
+	return string(u32(AT_TRUNCATED_BY));
+}
+
+uint64_t SnapshotView::bytesAnalyzed() const {
+	return readU64(data_, AT_BYTES);
+}
+
+int SnapshotView::qualityScore() const {
+	return static_cast<int>(u32(AT_QUALITY));
+}
+
+size_t SnapshotView::tokenCount() const {
+	size_t at = sectionStart(TOKEN_SECTION);
+	return static_cast<size_t>(varint(at));
+}
+
+CodeStructure SnapshotView::structure() const {
+	CodeStructure structure;
+	structure.language = std::string(language());
+	structure.complexity = complexity();
+	structure.imports = imports().toVector();
+	structure.functions = functions().toVector();
+	structure.classes = classes().toVector();
+	Strings pairs = structureMetadata();
+	for (auto it = pairs.begin(); it != pairs.end(); ++it) {
+		std::string key(*it);
+		++it;
+		structure.metadata[key] = std::string(*it);
+	}
+	return structure;
+}
+
+AnalysisResult SnapshotView::result() const {
+	AnalysisResult result;
+	result.lineCount = lineCount();
+	result.commentCount = commentCount();
+	result.commentRatio = commentRatio();
+	result.nestingLength = nestingLength();
+	result.cyclomaticComplexity = cyclomaticComplexity();
+	forEachToken([&](std::string_view key, int count) {
+		result.tokenFrequency.emplace_hint(result.tokenFrequency.end(), std::string(key), count);
+	});
+	result.potentialIssues = potentialIssues().toVector();
+	result.suggestions = suggestions().toVector();
+	result.truncated = truncated();
+	result.truncatedBy = std::string(truncatedBy());
+	result.bytesAnalyzed = static_cast<size_t>(bytesAnalyzed());
+	Strings pairs = metadata();
+	for (auto it = pairs.begin(); it != pairs.end(); ++it) {
+		std::string key(*it);
+		++it;
+		result.metadata.emplace_hint(result.metadata.end(), std::move(key), std::string(*it));
+	}
+	return result;
+}
+
+AnalysisReport SnapshotView::report() const {
+	AnalysisReport report;
+	report.structure = structure();
+	report.result = result();
+	report.qualityScore = qualityScore();
+	return report;
+}
+
+}  // namespace code_educator
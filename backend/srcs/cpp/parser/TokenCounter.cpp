@@ -0,0 +1,268 @@
+#include "TokenCounter.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace code_educator {
+
+namespace {
+
+// Short-string hash: whole 8-byte words, then the tail, each step mixed with
+// a multiply and a shift (identifiers are mostly shorter than 16 bytes).
+uint32_t hashKey(const char* p, size_t n) {
+	uint64_t h = 0x9e3779b97f4a7c15ULL ^ n;
+	while (n >= 8) {
+		uint64_t word;
+		std::memcpy(&word, p, 8);
+		h = (h ^ word) * 0xbf58476d1ce4e5b9ULL;
+		h ^= h >> 29;
+		p += 8;
+		n -= 8;
+	}
+	uint64_t tail = 0;
+	for (size_t i = 0; i < n; ++i) {
+		tail |= static_cast<uint64_t>(static_cast<unsigned char>(p[i])) << (i * 8);
+	}
+	h = (h ^ tail) * 0x94d049bb133111ebULL;
+	h ^= h >> 32;
+	return static_cast<uint32_t>(h);
+}
+
+constexpr size_t INITIAL_SLOTS = 64;
+
+}  // namespace
+
+StringArena::StringArena(size_t blockBytes) : blockBytes_(blockBytes) {
+}
+
+StringArena::StringArena(StringArena&& other) noexcept
+	: blocks_(std::move(other.blocks_)), blockBytes_(other.blockBytes_),
+	  cursor_(other.cursor_), left_(other.left_), capacity_(other.capacity_), firstBytes_(other.firstBytes_) {
+	other.clear();
+}
+
+StringArena& StringArena::operator=(StringArena&& other) noexcept {
+	if (this != &other) {
+		blocks_ = std::move(other.blocks_);
+		blockBytes_ = other.blockBytes_;
+		cursor_ = other.cursor_;
+		left_ = other.left_;
+		capacity_ = other.capacity_;
+		firstBytes_ = other.firstBytes_;
+		other.clear();
+	}
+	return *this;
+}
+
+/*
+ * Copy a string into the arena
+ * @param text: string to store
+ * @return: view of the stored copy
+ */
+std::string_view StringArena::store(std::string_view text) {
+	if (text.size() > left_) {
+		// strings larger than a block get a block of their own
+		size_t size = std::max(blockBytes_, text.size());
+		if (blocks_.empty()) {
+			firstBytes_ = size;
+		}
+		blocks_.emplace_back(new char[size]);
+		cursor_ = blocks_.back().get();
+		left_ = size;
+		capacity_ += size;
+	}
+	char* stored = cursor_;
+	if (!text.empty()) {
+		std::memcpy(stored, text.data(), text.size());
+	}
+	cursor_ += text.size();
+	left_ -= text.size();
+	return std::string_view(stored, text.size());
+}
+
+void StringArena::clear() {
+	blocks_.clear();
+	cursor_ = nullptr;
+	left_ = 0;
+	capacity_ = 0;
+	firstBytes_ = 0;
+}
+
+void StringArena::reset() {
+	if (blocks_.empty()) {
+		return;
+	}
+	blocks_.resize(1);
+	cursor_ = blocks_.front().get();
+	left_ = firstBytes_;
+	capacity_ = firstBytes_;
+}
+
+TokenCounter::TokenCounter(const TokenCounter& other) {
+	*this = other;
+}
+
+TokenCounter::TokenCounter(TokenCounter&& other) noexcept
+	: slots_(std::move(other.slots_)), used_(other.used_), live_(other.live_), arena_(std::move(other.arena_)) {
+	other.clear();
+}
+
+TokenCounter& TokenCounter::operator=(TokenCounter&& other) noexcept {
+	if (this != &other) {
+		slots_ = std::move(other.slots_);
+		used_ = other.used_;
+		live_ = other.live_;
+		arena_ = std::move(other.arena_);
+		other.clear();
+	}
+	return *this;
+}
+
+TokenCounter& TokenCounter::operator=(const TokenCounter& other) {
+	if (this != &other) {
+		// keys are re-interned into this counter's own arena
+		clear();
+		for (const Slot& slot : other.slots_) {
+			if (slot.data != nullptr && slot.count != 0) {
+				add(std::string_view(slot.data, slot.length), slot.count);
+			}
+		}
+	}
+	return *this;
+}
+
+/*
+ * Add to the count of a key
+ * @param key: identifier (copied into the arena when first seen)
+ * @param delta: amount to add
+ */
+void TokenCounter::add(std::string_view key, int delta) {
+	if ((used_ + 1) * 4 > slots_.size() * 3) {
+		grow();
+	}
+	uint32_t hash = hashKey(key.data(), key.size());
+	Slot& slot = findSlot(key, hash);
+	if (slot.data == nullptr) {
+		std::string_view stored = arena_.store(key);
+		slot.data = stored.empty() ? "" : stored.data();
+		slot.length = static_cast<uint32_t>(key.size());
+		slot.hash = hash;
+		used_++;
+	}
+	bool wasLive = slot.count != 0;
+	slot.count += delta;
+	bool isLive = slot.count != 0;
+	if (wasLive != isLive) {
+		live_ += isLive ? 1 : static_cast<size_t>(-1);
+	}
+}
+
+int TokenCounter::count(std::string_view key) const {
+	if (slots_.empty()) {
+		return 0;
+	}
+	uint32_t hash = hashKey(key.data(), key.size());
+	size_t mask = slots_.size() - 1;
+	for (size_t i = hash & mask;; i = (i + 1) & mask) {
+		const Slot& slot = slots_[i];
+		if (slot.data == nullptr) {
+			return 0;
+		}
+		if (slot.hash == hash && slot.length == key.size() && std::memcmp(slot.data, key.data(), key.size()) == 0) {
+			return slot.count;
+		}
+	}
+}
+
+// slot holding key, or the empty slot where it belongs
+TokenCounter::Slot& TokenCounter::findSlot(std::string_view key, uint32_t hash) {
+	size_t mask = slots_.size() - 1;
+	for (size_t i = hash & mask;; i = (i + 1) & mask) {
+		Slot& slot = slots_[i];
+		if (slot.data == nullptr ||
+			(slot.hash == hash && slot.length == key.size() && std::memcmp(slot.data, key.data(), key.size()) == 0)) {
+			return slot;
+		}
+	}
+}
+
+// double the table (zero counts are dropped on the way)
+void TokenCounter::grow() {
+	std::vector<Slot> old;
+	old.swap(slots_);
+	slots_.assign(std::max(INITIAL_SLOTS, old.size() * 2), Slot());
+	size_t mask = slots_.size() - 1;
+	used_ = 0;
+	for (const Slot& slot : old) {
+		if (slot.data == nullptr || slot.count == 0) {
+			continue;
+		}
+		size_t i = slot.hash & mask;
+		while (slots_[i].data != nullptr) {
+			i = (i + 1) & mask;
+		}
+		slots_[i] = slot;
+		used_++;
+	}
+}
+
+void TokenCounter::clear() {
+	slots_.clear();
+	used_ = 0;
+	live_ = 0;
+	arena_.clear();
+}
+
+void TokenCounter::reset() {
+	std::fill(slots_.begin(), slots_.end(), Slot());
+	used_ = 0;
+	live_ = 0;
+	arena_.reset();
+}
+
+std::vector<TokenCounter::Entry> TokenCounter::entries() const {
+	std::vector<Entry> out;
+	out.reserve(live_);
+	for (const Slot& slot : slots_) {
+		if (slot.data != nullptr && slot.count != 0) {
+			out.push_back(Entry{std::string_view(slot.data, slot.length), slot.count});
+		}
+	}
+	return out;
+}
+
+/*
+ * Most frequent keys
+ * @param k: number of keys to return (0: all of them)
+ * @return: entries sorted by count (descending), then key
+ */
+std::vector<TokenCounter::Entry> TokenCounter::top(size_t k) const {
+	std::vector<Entry> out = entries();
+	auto higher = [](const Entry& a, const Entry& b) {
+		return a.count != b.count ? a.count > b.count : a.key < b.key;
+	};
+	if (k == 0 || k >= out.size()) {
+		std::sort(out.begin(), out.end(), higher);
+		return out;
+	}
+	std::partial_sort(out.begin(), out.begin() + k, out.end(), higher);
+	out.resize(k);
+	return out;
+}
+
+void TokenCounter::exportTo(std::map<std::string, int>& out, size_t k) const {
+	if (k == 0) {
+		for (const Entry& entry : entries()) {
+			out.emplace(std::string(entry.key), entry.count);
+		}
+		return;
+	}
+	for (const Entry& entry : top(k)) {
+		out.emplace(std::string(entry.key), entry.count);
+	}
+}
+
+size_t TokenCounter::memoryUsage() const {
+	return sizeof(*this) + slots_.capacity() * sizeof(Slot) + arena_.capacity();
+}
+
+}  // namespace code_educator
@@ -0,0 +1,512 @@
+#include "TokenSketch.hpp"
+#include "ContentHash.hpp"
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace code_educator {
+
+namespace {
+
+const char SKETCH_MAGIC[4] = {'C', 'E', 'T', 'S'};
+const uint32_t SKETCH_FORMAT = 1;
+
+// bounds accepted when reading a sketch back
+const uint64_t MAX_CELLS = uint64_t(1) << 28;
+const uint64_t MAX_TOP_CAPACITY = uint64_t(1) << 20;
+
+uint64_t mix64(uint64_t x) {
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+uint64_t tokenHash(std::string_view token) {
+	return hashContent(token).low;
+}
+
+size_t roundUpPow2(size_t n) {
+	size_t p = 1;
+	while (p < n) {
+		p <<= 1;
+	}
+	return p;
+}
+
+bool higher(const SpaceSaving::Entry& a, const SpaceSaving::Entry& b) {
+	return a.count != b.count ? a.count > b.count : a.key < b.key;
+}
+
+// little-endian writer and bounds-checked reader for the binary form
+class Writer {
+public:
+	explicit Writer(std::string& out) : out_(out) {}
+
+	void bytes(const void* data, size_t size) {
+		out_.append(static_cast<const char*>(data), size);
+	}
+	void u32(uint32_t value) {
+		for (int i = 0; i < 4; ++i) {
+			out_.push_back(static_cast<char>(value >> (i * 8)));
+		}
+	}
+	void u64(uint64_t value) {
+		for (int i = 0; i < 8; ++i) {
+			out_.push_back(static_cast<char>(value >> (i * 8)));
+		}
+	}
+
+private:
+	std::string& out_;
+};
+
+class Reader {
+public:
+	explicit Reader(std::string_view data) : data_(data) {}
+
+	std::string_view bytes(size_t size) {
+		need(size);
+		std::string_view out = data_.substr(at_, size);
+		at_ += size;
+		return out;
+	}
+	uint32_t u32() {
+		std::string_view raw = bytes(4);
+		uint32_t value = 0;
+		for (int i = 3; i >= 0; --i) {
+			value = (value << 8) | static_cast<unsigned char>(raw[i]);
+		}
+		return value;
+	}
+	uint64_t u64() {
+		std::string_view raw = bytes(8);
+		uint64_t value = 0;
+		for (int i = 7; i >= 0; --i) {
+			value = (value << 8) | static_cast<unsigned char>(raw[i]);
+		}
+		return value;
+	}
+	bool done() const { return at_ == data_.size(); }
+
+private:
+	void need(size_t size) const {
+		if (data_.size() - at_ < size) {
+			throw std::runtime_error("invalid token sketch: truncated data");
+		}
+	}
+
+	std::string_view data_;
+	size_t at_ = 0;
+};
+
+}  // namespace
+
+CountMinSketch::CountMinSketch(size_t width, size_t depth)
+	: width_(roundUpPow2(std::max<size_t>(width, 1))), depth_(depth) {
+	if (depth_ == 0) {
+		throw std::invalid_argument("count-min sketch needs at least one row");
+	}
+	cells_.assign(width_ * depth_, 0);
+}
+
+// counter of a key in a row: the key hash remixed with the row number
+size_t CountMinSketch::cell(uint64_t hash, size_t row) const {
+	return row * width_ + static_cast<size_t>(mix64(hash + row * 0x9e3779b97f4a7c15ULL) & (width_ - 1));
+}
+
+void CountMinSketch::add(uint64_t hash, uint64_t delta) {
+	for (size_t row = 0; row < depth_; ++row) {
+		cells_[cell(hash, row)] += delta;
+	}
+	total_ += delta;
+}
+
+uint64_t CountMinSketch::estimate(uint64_t hash) const {
+	uint64_t best = UINT64_MAX;
+	for (size_t row = 0; row < depth_; ++row) {
+		best = std::min(best, cells_[cell(hash, row)]);
+	}
+	return best;
+}
+
+void CountMinSketch::merge(const CountMinSketch& other) {
+	if (other.width_ != width_ || other.depth_ != depth_) {
+		throw std::invalid_argument("count-min sketches of different shapes cannot be merged");
+	}
+	for (size_t i = 0; i < cells_.size(); ++i) {
+		cells_[i] += other.cells_[i];
+	}
+	total_ += other.total_;
+}
+
+void CountMinSketch::clear() {
+	std::fill(cells_.begin(), cells_.end(), 0);
+	total_ = 0;
+}
+
+SpaceSaving::SpaceSaving(size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {
+}
+
+// the index holds views into entries_, so copies build their own
+SpaceSaving::SpaceSaving(const SpaceSaving& other)
+	: capacity_(other.capacity_), entries_(other.entries_) {
+	rebuild();
+}
+
+SpaceSaving& SpaceSaving::operator=(const SpaceSaving& other) {
+	if (this != &other) {
+		capacity_ = other.capacity_;
+		entries_ = other.entries_;
+		rebuild();
+	}
+	return *this;
+}
+
+void SpaceSaving::add(std::string_view key, uint64_t delta) {
+	add(key, delta, UINT64_MAX);
+}
+
+/*
+ * Count occurrences of a key
+ * @param key: key seen
+ * @param delta: number of occurrences
+ * @param bound: upper bound of the key's count, delta included
+ */
+void SpaceSaving::add(std::string_view key, uint64_t delta, uint64_t bound) {
+	auto found = index_.find(key);
+	if (found != index_.end()) {
+		entries_[found->second].count += delta;
+		siftDown(position_[found->second]);
+		return;
+	}
+
+	if (!full()) {
+		if (entries_.empty()) {
+			// views into entries_ must survive every push_back
+			entries_.reserve(capacity_);
+		}
+		uint32_t slot = static_cast<uint32_t>(entries_.size());
+		entries_.push_back(Entry{std::string(key), delta, 0});
+		position_.push_back(static_cast<uint32_t>(heap_.size()));
+		heap_.push_back(slot);
+		index_.emplace(entries_[slot].key, slot);
+		siftUp(position_[slot]);
+		return;
+	}
+
+	// replace the smallest counter: the newcomer may have been counted there
+	uint32_t slot = heap_[0];
+	Entry& entry = entries_[slot];
+	uint64_t floor = entry.count;
+	if (bound <= floor) {
+		return;
+	}
+	index_.erase(entry.key);
+	entry.key.assign(key.data(), key.size());
+	entry.count = std::min(floor + delta, bound);
+	entry.error = entry.count - delta;
+	index_.emplace(entry.key, slot);
+	siftDown(0);
+}
+
+const SpaceSaving::Entry* SpaceSaving::find(std::string_view key) const {
+	auto found = index_.find(key);
+	return found == index_.end() ? nullptr : &entries_[found->second];
+}
+
+/*
+ * Merge another summary into this one
+ * A key missing from a full summary may have occurred up to its smallest
+ * count there, so that count is added to both the key's count and its error.
+ * @param other: summary to merge
+ */
+void SpaceSaving::merge(const SpaceSaving& other) {
+	uint64_t ownFloor = minCount();
+	uint64_t otherFloor = other.minCount();
+
+	std::vector<Entry> merged;
+	merged.reserve(entries_.size() + other.entries_.size());
+	for (const Entry& entry : entries_) {
+		const Entry* match = other.find(entry.key);
+		if (match != nullptr) {
+			merged.push_back(Entry{entry.key, entry.count + match->count, entry.error + match->error});
+		}
+		else {
+			merged.push_back(Entry{entry.key, entry.count + otherFloor, entry.error + otherFloor});
+		}
+	}
+	for (const Entry& entry : other.entries_) {
+		if (find(entry.key) == nullptr) {
+			merged.push_back(Entry{entry.key, entry.count + ownFloor, entry.error + ownFloor});
+		}
+	}
+	assign(std::move(merged));
+}
+
+void SpaceSaving::clear() {
+	entries_.clear();
+	heap_.clear();
+	position_.clear();
+	index_.clear();
+}
+
+std::vector<SpaceSaving::Entry> SpaceSaving::top(size_t k) const {
+	std::vector<Entry> out = entries_;
+	if (k == 0 || k >= out.size()) {
+		std::sort(out.begin(), out.end(), higher);
+		return out;
+	}
+	std::partial_sort(out.begin(), out.begin() + k, out.end(), higher);
+	out.resize(k);
+	return out;
+}
+
+void SpaceSaving::assign(std::vector<Entry> entries) {
+	if (entries.size() > capacity_) {
+		std::partial_sort(entries.begin(), entries.begin() + capacity_, entries.end(), higher);
+		entries.resize(capacity_);
+	}
+	entries_ = std::move(entries);
+	rebuild();
+}
+
+// smallest monitored count while full (0 while any counter is free)
+uint64_t SpaceSaving::minCount() const {
+	return full() && !heap_.empty() ? entries_[heap_[0]].count : 0;
+}
+
+void SpaceSaving::siftUp(size_t position) {
+	while (position > 0) {
+		size_t parent = (position - 1) / 2;
+		if (entries_[heap_[parent]].count <= entries_[heap_[position]].count) {
+			break;
+		}
+		swapHeap(parent, position);
+		position = parent;
+	}
+}
+
+void SpaceSaving::siftDown(size_t position) {
+	size_t size = heap_.size();
+	for (;;) {
+		size_t smallest = position;
+		size_t left = 2 * position + 1;
+		size_t right = left + 1;
+		if (left < size && entries_[heap_[left]].count < entries_[heap_[smallest]].count) {
+			smallest = left;
+		}
+		if (right < size && entries_[heap_[right]].count < entries_[heap_[smallest]].count) {
+			smallest = right;
+		}
+		if (smallest == position) {
+			return;
+		}
+		swapHeap(position, smallest);
+		position = smallest;
+	}
+}
+
+void SpaceSaving::swapHeap(size_t a, size_t b) {
+	std::swap(heap_[a], heap_[b]);
+	position_[heap_[a]] = static_cast<uint32_t>(a);
+	position_[heap_[b]] = static_cast<uint32_t>(b);
+}
+
+// heap and index from entries_
+void SpaceSaving::rebuild() {
+	entries_.reserve(capacity_);
+	heap_.resize(entries_.size());
+	position_.resize(entries_.size());
+	index_.clear();
+	for (uint32_t i = 0; i < entries_.size(); ++i) {
+		heap_[i] = i;
+		position_[i] = i;
+		index_.emplace(entries_[i].key, i);
+	}
+	for (size_t i = heap_.size() / 2; i-- > 0;) {
+		siftDown(i);
+	}
+}
+
+TokenSketch::TokenSketch(size_t topCapacity, size_t width, size_t depth)
+	: counts_(width, depth), heavy_(topCapacity) {
+}
+
+/*
+ * Count occurrences of a token
+ * @param token: identifier seen
+ * @param delta: number of occurrences
+ */
+void TokenSketch::add(std::string_view token, uint64_t delta) {
+	uint64_t hash = tokenHash(token);
+	counts_.add(hash, delta);
+	// the sketch bounds the newcomer's count, so rare tokens stop evicting
+	// the monitored ones
+	heavy_.add(token, delta, counts_.estimate(hash));
+}
+
+uint64_t TokenSketch::estimate(std::string_view token) const {
+	uint64_t estimate = counts_.estimate(tokenHash(token));
+	const SpaceSaving::Entry* entry = heavy_.find(token);
+	return entry != nullptr ? std::min(estimate, entry->count) : estimate;
+}
+
+/*
+ * Most frequent tokens
+ * Both structures overcount, so the smaller of the two counts is reported.
+ * @param k: number of tokens to return (0: every monitored token)
+ * @return: tokens by estimated count, highest first
+ */
+std::vector<TokenSketch::Entry> TokenSketch::top(size_t k) const {
+	std::vector<Entry> out;
+	for (const SpaceSaving::Entry& entry : heavy_.entries()) {
+		uint64_t count = std::min(entry.count, counts_.estimate(tokenHash(entry.key)));
+		out.push_back(Entry{entry.key, count, entry.count - entry.error});
+	}
+	auto byCount = [](const Entry& a, const Entry& b) {
+		return a.count != b.count ? a.count > b.count : a.key < b.key;
+	};
+	if (k == 0 || k >= out.size()) {
+		std::sort(out.begin(), out.end(), byCount);
+		return out;
+	}
+	std::partial_sort(out.begin(), out.begin() + k, out.end(), byCount);
+	out.resize(k);
+	return out;
+}
+
+void TokenSketch::merge(const TokenSketch& other) {
+	if (other.topCapacity() != topCapacity()) {
+		throw std::invalid_argument("token sketches of different shapes cannot be merged");
+	}
+	counts_.merge(other.counts_);
+	heavy_.merge(other.heavy_);
+}
+
+void TokenSketch::clear() {
+	counts_.clear();
+	heavy_.clear();
+}
+
+size_t TokenSketch::memoryUsage() const {
+	size_t bytes = sizeof(*this) + counts_.cells().size() * sizeof(uint64_t);
+	for (const SpaceSaving::Entry& entry : heavy_.entries()) {
+		bytes += sizeof(entry) + entry.key.capacity() + 32;  // index node, roughly
+	}
+	return bytes;
+}
+
+/*
+ * Binary form of the sketch
+ * Layout: magic, format, width, depth, top capacity, total, the counters row
+ * by row, then the monitored entries (key length, key, count, error).
+ * @return: serialized sketch
+ */
+std::string TokenSketch::serialize() const {
+	std::string out;
+	out.reserve(32 + counts_.cells().size() * 8 + heavy_.size() * 32);
+	Writer writer(out);
+	writer.bytes(SKETCH_MAGIC, sizeof(SKETCH_MAGIC));
+	writer.u32(SKETCH_FORMAT);
+	writer.u32(static_cast<uint32_t>(counts_.width()));
+	writer.u32(static_cast<uint32_t>(counts_.depth()));
+	writer.u32(static_cast<uint32_t>(heavy_.capacity()));
+	writer.u64(counts_.total());
+	for (uint64_t cell : counts_.cells()) {
+		writer.u64(cell);
+	}
+	writer.u32(static_cast<uint32_t>(heavy_.size()));
+	for (const SpaceSaving::Entry& entry : heavy_.entries()) {
+		writer.u32(static_cast<uint32_t>(entry.key.size()));
+		writer.bytes(entry.key.data(), entry.key.size());
+		writer.u64(entry.count);
+		writer.u64(entry.error);
+	}
+	return out;
+}
+
+/*
+ * Read a sketch back from its binary form
+ * @param data: output of serialize()
+ * @return: the sketch
+ */
+TokenSketch TokenSketch::deserialize(std::string_view data) {
+	Reader reader(data);
+	if (reader.bytes(sizeof(SKETCH_MAGIC)) != std::string_view(SKETCH_MAGIC, sizeof(SKETCH_MAGIC))) {
+		throw std::runtime_error("invalid token sketch: bad magic");
+	}
+	uint32_t format = reader.u32();
+	if (format != SKETCH_FORMAT) {
+		throw std::runtime_error("invalid token sketch: unsupported format " + std::to_string(format));
+	}
+	uint64_t width = reader.u32();
+	uint64_t depth = reader.u32();
+	uint64_t capacity = reader.u32();
+	if (width == 0 || (width & (width - 1)) != 0 || depth == 0 || width * depth > MAX_CELLS ||
+		capacity == 0 || capacity > MAX_TOP_CAPACITY) {
+		throw std::runtime_error("invalid token sketch: bad shape");
+	}
+
+	TokenSketch sketch(capacity, width, depth);
+	sketch.counts_.setTotal(reader.u64());
+	for (uint64_t& cell : sketch.counts_.cells()) {
+		cell = reader.u64();
+	}
+
+	uint32_t count = reader.u32();
+	if (count > capacity) {
+		throw std::runtime_error("invalid token sketch: too many entries");
+	}
+	std::vector<SpaceSaving::Entry> entries(count);
+	for (SpaceSaving::Entry& entry : entries) {
+		entry.key = std::string(reader.bytes(reader.u32()));
+		entry.count = reader.u64();
+		entry.error = reader.u64();
+		if (entry.error > entry.count) {
+			throw std::runtime_error("invalid token sketch: bad entry");
+		}
+	}
+	if (!reader.done()) {
+		throw std::runtime_error("invalid token sketch: trailing data");
+	}
+	sketch.heavy_.assign(std::move(entries));
+	return sketch;
+}
+
+/*
+ * Write the sketch to a file
+ * The data goes to a temporary file first, renamed over path once complete.
+ * @param path: destination file
+ */
+void TokenSketch::save(const std::string& path) const {
+	std::string data = serialize();
+	std::string temporary = path + ".tmp";
+	std::FILE* file = std::fopen(temporary.c_str(), "wb");
+	if (file == nullptr) {
+		throw std::runtime_error("cannot write '" + path + "': " + std::strerror(errno));
+	}
+	bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+	int error = errno;
+	if (std::fclose(file) != 0 && written) {
+		written = false;
+		error = errno;
+	}
+	if (!written || std::rename(temporary.c_str(), path.c_str()) != 0) {
+		error = written ? errno : error;
+		std::remove(temporary.c_str());
+		throw std::runtime_error("cannot write '" + path + "': " + std::strerror(error));
+	}
+}
+
+TokenSketch TokenSketch::load(const std::string& path) {
+	MappedFile file(path);
+	return deserialize(file.view());
+}
+
+}  // namespace code_educator
@@ -0,0 +1,46 @@
+#include "AnalysisBudget.hpp"
+
+namespace code_educator {
+
+const char* budgetStopName(BudgetStop stop) {
+	switch (stop) {
+		case BudgetStop::Deadline:
+			return "deadline";
+		case BudgetStop::Memory:
+			return "memory";
+		case BudgetStop::Cancelled:
+			return "cancelled";
+		default:
+			return "";
+	}
+}
+
+BudgetTracker::BudgetTracker(const AnalysisBudget& budget) : budget_(budget) {
+	if (budget.timeLimitNs != 0) {
+		deadline_ = std::chrono::steady_clock::now() + std::chrono::nanoseconds(budget.timeLimitNs);
+	}
+}
+
+/*
+ * Check the budget
+ * Cheapest check first: the cancel flag, then memory, then the clock.
+ * @param memoryBytes: bytes the call holds now
+ * @return: true if the call must stop
+ */
+bool BudgetTracker::exhausted(size_t memoryBytes) {
+	if (stop_ != BudgetStop::None) {
+		return true;
+	}
+	if (budget_.cancel && budget_.cancel->cancelled()) {
+		stop_ = BudgetStop::Cancelled;
+	}
+	else if (budget_.memoryLimitBytes != 0 && memoryBytes > budget_.memoryLimitBytes) {
+		stop_ = BudgetStop::Memory;
+	}
+	else if (budget_.timeLimitNs != 0 && std::chrono::steady_clock::now() >= deadline_) {
+		stop_ = BudgetStop::Deadline;
+	}
+	return stop_ != BudgetStop::None;
+}
+
+}  // namespace code_educator
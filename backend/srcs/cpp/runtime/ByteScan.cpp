@@ -0,0 +1,143 @@
+#include "ByteScan.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CODE_EDUCATOR_X86 1
+#endif
+
+namespace code_educator {
+
+namespace {
+
+using FindFn = const char* (*)(const char*, const char*, const ByteSet&);
+
+const char* findScalar(const char* p, const char* end, const ByteSet& set) {
+	for (; p < end; ++p) {
+		if (set.contains(*p)) {
+			return p;
+		}
+	}
+	return end;
+}
+
+#ifdef CODE_EDUCATOR_X86
+
+// the set padded to four bytes by repeating its first byte
+struct Needles {
+	char b[4];
+	explicit Needles(const ByteSet& set) {
+		for (int i = 0; i < 4; ++i) {
+			b[i] = set.bytes[i < set.size ? i : 0];
+		}
+	}
+};
+
+inline unsigned ctz(unsigned mask) {
+	return static_cast<unsigned>(__builtin_ctz(mask));
+}
+
+// compiled for SSE2 even where the baseline is older (i386 without -msse2)
+// and only picked when the CPU reports it
+__attribute__((target("sse2")))
+const char* findSse2(const char* p, const char* end, const ByteSet& set) {
+	Needles n(set);
+	const __m128i n0 = _mm_set1_epi8(n.b[0]);
+	const __m128i n1 = _mm_set1_epi8(n.b[1]);
+	const __m128i n2 = _mm_set1_epi8(n.b[2]);
+	const __m128i n3 = _mm_set1_epi8(n.b[3]);
+
+	while (end - p >= 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		__m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, n0), _mm_cmpeq_epi8(v, n1)),
+			_mm_or_si128(_mm_cmpeq_epi8(v, n2), _mm_cmpeq_epi8(v, n3)));
+		unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hit));
+		if (mask) {
+			return p + ctz(mask);
+		}
+		p += 16;
+	}
+	return findScalar(p, end, set);
+}
+
+// the needles are compared in four registers: one per byte of the set
+__attribute__((target("avx2")))
+inline unsigned matchAvx2(const char* at, __m256i n0, __m256i n1, __m256i n2, __m256i n3) {
+	__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(at));
+	__m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, n0), _mm256_cmpeq_epi8(v, n1)),
+		_mm256_or_si256(_mm256_cmpeq_epi8(v, n2), _mm256_cmpeq_epi8(v, n3)));
+	return static_cast<unsigned>(_mm256_movemask_epi8(hit));
+}
+
+__attribute__((target("avx2")))
+const char* findAvx2(const char* p, const char* end, const ByteSet& set) {
+	Needles n(set);
+	const __m256i n0 = _mm256_set1_epi8(n.b[0]);
+	const __m256i n1 = _mm256_set1_epi8(n.b[1]);
+	const __m256i n2 = _mm256_set1_epi8(n.b[2]);
+	const __m256i n3 = _mm256_set1_epi8(n.b[3]);
+
+	// two vectors per step: one branch per 64 bytes of plain text
+	while (end - p >= 64) {
+		unsigned low = matchAvx2(p, n0, n1, n2, n3);
+		unsigned high = matchAvx2(p + 32, n0, n1, n2, n3);
+		if (low | high) {
+			return low ? p + ctz(low) : p + 32 + ctz(high);
+		}
+		p += 64;
+	}
+	if (end - p >= 32) {
+		unsigned mask = matchAvx2(p, n0, n1, n2, n3);
+		if (mask) {
+			return p + ctz(mask);
+		}
+		p += 32;
+	}
+	return findSse2(p, end, set);
+}
+
+#endif
+
+struct Kernel {
+	FindFn find;
+	const char* name;
+};
+
+Kernel pickKernel() {
+#ifdef CODE_EDUCATOR_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return Kernel{findAvx2, "avx2"};
+	}
+	if (__builtin_cpu_supports("sse2")) {
+		return Kernel{findSse2, "sse2"};  // part of every x86-64 CPU
+	}
+	return Kernel{findScalar, "scalar"};
+#else
+	return Kernel{findScalar, "scalar"};
+#endif
+}
+
+const Kernel kernel = pickKernel();
+
+}  // namespace
+
+/*
+ * Find the first byte of a set
+ * @param p: start of the span
+ * @param end: end of the span
+ * @param set: bytes to look for
+ * @return: first match, or end
+ */
+const char* findFirstOf(const char* p, const char* end, const ByteSet& set) {
+	// not worth a vector load
+	if (end - p < 16) {
+		return findScalar(p, end, set);
+	}
+	return kernel.find(p, end, set);
+}
+
+const char* byteScanKernel() {
+	return kernel.name;
+}
+
+}  // namespace code_educator
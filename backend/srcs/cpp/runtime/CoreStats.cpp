@@ -0,0 +1,215 @@
+#include "CoreStats.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+namespace code_educator {
+
+namespace {
+
+const size_t STAGES = static_cast<size_t>(Stage::COUNT);
+const size_t COUNTERS = static_cast<size_t>(Counter::COUNT);
+
+const char* const STAGE_NAMES[STAGES] = {
+	"detect_language", "lex", "parse", "structure", "metrics", "token_table", "issues",
+	"suggestions", "quality_gate", "analyze", "report", "binding"
+};
+
+const char* const COUNTER_NAMES[COUNTERS] = {
+	"bytes_analyzed", "cache_hits", "cache_misses", "shared_cache_hits", "disk_cache_hits"
+};
+
+std::atomic<bool> enabled{true};
+
+struct StageCells {
+	std::atomic<uint64_t> count{0};
+	std::atomic<uint64_t> totalNs{0};
+	std::atomic<uint64_t> bytes{0};
+	std::atomic<uint64_t> buckets[HISTOGRAM_BUCKETS] = {};
+};
+
+// One thread's slots. Only the owner writes them (plain load + store, no
+// locked instruction); snapshots read them concurrently.
+struct Shard {
+	StageCells stages[STAGES];
+	std::atomic<uint64_t> counters[COUNTERS] = {};
+};
+
+inline void bump(std::atomic<uint64_t>& slot, uint64_t amount) {
+	slot.store(slot.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+void addShard(CoreStats& out, const Shard& shard) {
+	for (size_t s = 0; s < STAGES; ++s) {
+		const StageCells& cells = shard.stages[s];
+		StageStats& stats = out.stages[s];
+		stats.count += cells.count.load(std::memory_order_relaxed);
+		stats.totalNs += cells.totalNs.load(std::memory_order_relaxed);
+		stats.bytes += cells.bytes.load(std::memory_order_relaxed);
+		for (size_t b = 0; b < HISTOGRAM_BUCKETS; ++b) {
+			stats.buckets[b] += cells.buckets[b].load(std::memory_order_relaxed);
+		}
+	}
+	for (size_t c = 0; c < COUNTERS; ++c) {
+		out.counters[c] += shard.counters[c].load(std::memory_order_relaxed);
+	}
+}
+
+// snapshot minus the baseline taken at the last reset
+void subtract(CoreStats& out, const CoreStats& baseline) {
+	for (size_t s = 0; s < STAGES; ++s) {
+		StageStats& stats = out.stages[s];
+		const StageStats& base = baseline.stages[s];
+		stats.count -= std::min(stats.count, base.count);
+		stats.totalNs -= std::min(stats.totalNs, base.totalNs);
+		stats.bytes -= std::min(stats.bytes, base.bytes);
+		for (size_t b = 0; b < HISTOGRAM_BUCKETS; ++b) {
+			stats.buckets[b] -= std::min(stats.buckets[b], base.buckets[b]);
+		}
+	}
+	for (size_t c = 0; c < COUNTERS; ++c) {
+		out.counters[c] -= std::min(out.counters[c], baseline.counters[c]);
+	}
+}
+
+struct Registry {
+	std::mutex mutex;
+	std::vector<Shard*> live;
+	CoreStats retired;   // totals of the threads that exited
+	CoreStats baseline;  // totals at the last reset
+
+	CoreStats total() {
+		CoreStats out;
+		for (size_t s = 0; s < STAGES; ++s) {
+			out.stages[s] = retired.stages[s];
+		}
+		std::copy(retired.counters, retired.counters + COUNTERS, out.counters);
+		for (const Shard* shard : live) {
+			addShard(out, *shard);
+		}
+		return out;
+	}
+};
+
+// never destroyed: threads may exit after static destructors have run
+Registry& registry() {
+	static Registry* instance = new Registry();
+	return *instance;
+}
+
+// registers the thread's shard on first use and folds it into the retired
+// totals when the thread exits
+class ShardHolder {
+public:
+	ShardHolder() {
+		Registry& r = registry();
+		std::lock_guard<std::mutex> lock(r.mutex);
+		r.live.push_back(&shard_);
+	}
+	~ShardHolder() {
+		Registry& r = registry();
+		std::lock_guard<std::mutex> lock(r.mutex);
+		r.live.erase(std::find(r.live.begin(), r.live.end(), &shard_));
+		addShard(r.retired, shard_);
+	}
+
+	Shard& shard() { return shard_; }
+
+private:
+	Shard shard_;
+};
+
+Shard& localShard() {
+	thread_local ShardHolder holder;
+	return holder.shard();
+}
+
+}  // namespace
+
+const char* stageName(Stage stage) {
+	size_t index = static_cast<size_t>(stage);
+	return index < STAGES ? STAGE_NAMES[index] : "unknown";
+}
+
+const char* counterName(Counter counter) {
+	size_t index = static_cast<size_t>(counter);
+	return index < COUNTERS ? COUNTER_NAMES[index] : "unknown";
+}
+
+size_t histogramBucket(uint64_t ns) {
+	if (ns < 4) {
+		return static_cast<size_t>(ns);
+	}
+	size_t power = 63 - static_cast<size_t>(__builtin_clzll(ns));  // 2 or more
+	size_t sub = static_cast<size_t>(ns >> (power - 2)) & 3;
+	return std::min((power - 1) * 4 + sub, HISTOGRAM_BUCKETS - 1);
+}
+
+uint64_t histogramUpperBound(size_t index) {
+	if (index < 4) {
+		return index + 1;
+	}
+	size_t power = index / 4 + 1;
+	uint64_t sub = index % 4;
+	return (4 + sub + 1) << (power - 2);
+}
+
+/*
+ * Latency at a quantile
+ * @param q: quantile, 0 to 1
+ * @return: upper bound of the bucket the quantile falls in (0 when empty)
+ */
+uint64_t StageStats::quantileNs(double q) const {
+	if (count == 0) {
+		return 0;
+	}
+	uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count));
+	rank = std::min<uint64_t>(std::max<uint64_t>(rank, 1), count);
+	uint64_t seen = 0;
+	for (size_t b = 0; b < HISTOGRAM_BUCKETS; ++b) {
+		seen += buckets[b];
+		if (seen >= rank) {
+			return histogramUpperBound(b);
+		}
+	}
+	return histogramUpperBound(HISTOGRAM_BUCKETS - 1);
+}
+
+CoreStats coreStats() {
+	Registry& r = registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	CoreStats out = r.total();
+	subtract(out, r.baseline);
+	out.enabled = coreStatsEnabled();
+	return out;
+}
+
+void resetCoreStats() {
+	Registry& r = registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	r.baseline = r.total();
+}
+
+void setCoreStatsEnabled(bool on) {
+	enabled.store(on, std::memory_order_relaxed);
+}
+
+bool coreStatsEnabled() {
+	return enabled.load(std::memory_order_relaxed);
+}
+
+void recordStage(Stage stage, uint64_t ns, uint64_t bytes) {
+	StageCells& cells = localShard().stages[static_cast<size_t>(stage)];
+	bump(cells.count, 1);
+	bump(cells.totalNs, ns);
+	bump(cells.bytes, bytes);
+	bump(cells.buckets[histogramBucket(ns)], 1);
+}
+
+void addCounter(Counter counter, uint64_t amount) {
+	if (coreStatsEnabled()) {
+		bump(localShard().counters[static_cast<size_t>(counter)], amount);
+	}
+}
+
+}  // namespace code_educator
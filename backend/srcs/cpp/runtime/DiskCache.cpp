@@ -0,0 +1,663 @@
+#include "DiskCache.hpp"
+#include "Analyzer.hpp"
+#include "ResultSnapshot.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace code_educator {
+
+namespace {
+
+// Index and record headers are stored in native byte order: a cache
+// directory belongs to one machine.
+const char INDEX_MAGIC[4] = {'C', 'E', 'D', 'X'};
+const char RECORD_MAGIC[4] = {'C', 'E', 'R', 'C'};
+const uint32_t INDEX_FORMAT = 1;
+
+const uint32_t INITIAL_SLOTS = 4096;
+// the index is grown (doubled) past this load, keeping probe runs short
+const uint32_t MAX_LOAD_PERCENT = 50;
+// buffered writes while copying records into a new log
+const size_t COPY_BUFFER_BYTES = 1024 * 1024;
+
+struct IndexHeader {
+	char magic[4];
+	uint32_t format;
+	uint32_t slotCount;   // a power of two
+	uint32_t generation;  // the log this index points into
+	uint32_t stale;       // set once a newer index has been renamed over this one
+	uint32_t entries;
+	uint64_t logBytes;    // committed end of the log; anything past it is an unfinished append
+	uint64_t clock;       // access clock, ticks on every hit and insert
+	uint8_t reserved[24];
+};
+static_assert(sizeof(IndexHeader) == 64, "index header layout");
+
+// A slot is free while length is 0. length is written last (and read
+// first), so a slot never shows a key before its offset.
+struct IndexSlot {
+	uint64_t low;
+	uint64_t high;
+	uint64_t offset;
+	uint32_t version;
+	uint32_t length;      // payload bytes
+	uint64_t touched;     // clock of the last hit, for compaction
+};
+static_assert(sizeof(IndexSlot) == 40, "index slot layout");
+
+struct RecordHeader {
+	char magic[4];
+	uint32_t length;
+	uint64_t low;
+	uint64_t high;
+	uint32_t version;
+	uint32_t checksum;    // of the payload
+};
+static_assert(sizeof(RecordHeader) == 32, "record header layout");
+
+// fields shared with other processes are accessed atomically through the mapping
+template <typename T>
+T loadShared(const T& field) {
+	return __atomic_load_n(&field, __ATOMIC_ACQUIRE);
+}
+
+template <typename T>
+void storeShared(T& field, T value) {
+	__atomic_store_n(&field, value, __ATOMIC_RELEASE);
+}
+
+uint32_t checksum(std::string_view payload) {
+	return static_cast<uint32_t>(hashContent(payload).low);
+}
+
+size_t indexBytes(uint32_t slotCount) {
+	return sizeof(IndexHeader) + static_cast<size_t>(slotCount) * sizeof(IndexSlot);
+}
+
+std::runtime_error fileError(const char* what, const std::string& path, int error) {
+	return std::runtime_error(std::string(what) + " '" + path + "': " + std::strerror(error));
+}
+
+bool readAll(int fd, void* data, size_t size, uint64_t offset) {
+	char* out = static_cast<char*>(data);
+	while (size > 0) {
+		ssize_t done = ::pread(fd, out, size, static_cast<off_t>(offset));
+		if (done < 0 && errno == EINTR) {
+			continue;
+		}
+		if (done <= 0) {
+			return false;
+		}
+		out += done;
+		size -= static_cast<size_t>(done);
+		offset += static_cast<uint64_t>(done);
+	}
+	return true;
+}
+
+bool writeAll(int fd, const void* data, size_t size, uint64_t offset) {
+	const char* in = static_cast<const char*>(data);
+	while (size > 0) {
+		ssize_t done = ::pwrite(fd, in, size, static_cast<off_t>(offset));
+		if (done < 0 && errno == EINTR) {
+			continue;
+		}
+		if (done <= 0) {
+			return false;
+		}
+		in += done;
+		size -= static_cast<size_t>(done);
+		offset += static_cast<uint64_t>(done);
+	}
+	return true;
+}
+
+bool sameKey(const IndexSlot& slot, const CacheKey& key) {
+	return slot.low == key.hash.low && slot.high == key.hash.high && slot.version == key.version;
+}
+
+// holds the directory's writer lock (excludes other processes only)
+class FileLock {
+public:
+	explicit FileLock(int fd) : fd_(fd) {
+		while (::flock(fd_, LOCK_EX) != 0 && errno == EINTR) {
+		}
+	}
+	~FileLock() { ::flock(fd_, LOCK_UN); }
+
+	FileLock(const FileLock&) = delete;
+	FileLock& operator=(const FileLock&) = delete;
+
+private:
+	int fd_;
+};
+
+}  // namespace
+
+// one generation of the cache as seen by this process: the mapped index and
+// the log it points into
+struct DiskCache::Mapping {
+	void* data = nullptr;
+	size_t bytes = 0;
+	int logFd = -1;
+
+	~Mapping() {
+		if (data != nullptr) {
+			::munmap(data, bytes);
+		}
+		if (logFd >= 0) {
+			::close(logFd);
+		}
+	}
+
+	IndexHeader& header() const { return *static_cast<IndexHeader*>(data); }
+	IndexSlot* slots() const {
+		return reinterpret_cast<IndexSlot*>(static_cast<char*>(data) + sizeof(IndexHeader));
+	}
+	uint32_t mask() const { return header().slotCount - 1; }
+	bool stale() const { return loadShared(header().stale) != 0; }
+
+	// the slot holding key, or the free slot where it would go (nullptr if full)
+	IndexSlot* probe(const CacheKey& key) const {
+		IndexSlot* table = slots();
+		uint32_t at = static_cast<uint32_t>(key.hash.low) & mask();
+		for (uint32_t step = 0; step <= mask(); ++step) {
+			IndexSlot& slot = table[at];
+			if (loadShared(slot.length) == 0 || sameKey(slot, key)) {
+				return &slot;
+			}
+			at = (at + 1) & mask();
+		}
+		return nullptr;
+	}
+
+	// the payload of the record a slot points to, if it is intact
+	bool readRecord(const IndexSlot& slot, uint32_t length, std::string& payload) const {
+		uint64_t offset = loadShared(slot.offset);
+		if (offset + sizeof(RecordHeader) + length > loadShared(header().logBytes)) {
+			return false;
+		}
+		RecordHeader record;
+		if (!readAll(logFd, &record, sizeof(record), offset)) {
+			return false;
+		}
+		if (std::memcmp(record.magic, RECORD_MAGIC, sizeof(RECORD_MAGIC)) != 0 || record.length != length ||
+			record.low != slot.low || record.high != slot.high || record.version != slot.version) {
+			return false;
+		}
+		payload.resize(length);
+		if (!readAll(logFd, &payload[0], length, offset + sizeof(RecordHeader))) {
+			return false;
+		}
+		return checksum(payload) == record.checksum;
+	}
+};
+
+namespace {
+
+std::string logPath(const std::string& directory, uint32_t generation) {
+	return directory + "/log." + std::to_string(generation);
+}
+
+// Write a complete index to index.tmp and rename it over the live one, so
+// every process sees either the old index or the new one, never a mix.
+void publishIndex(const std::string& directory, const std::vector<char>& image, bool sync) {
+	std::string temp = directory + "/index.tmp";
+	int fd = ::open(temp.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		throw fileError("cannot create", temp, errno);
+	}
+	bool written = writeAll(fd, image.data(), image.size(), 0) && (!sync || ::fsync(fd) == 0);
+	int error = errno;
+	::close(fd);
+	if (!written) {
+		throw fileError("cannot write", temp, error);
+	}
+	if (::rename(temp.c_str(), (directory + "/index").c_str()) != 0) {
+		throw fileError("cannot replace index in", directory, errno);
+	}
+}
+
+std::vector<char> emptyIndex(uint32_t slotCount, uint32_t generation, uint64_t clock) {
+	std::vector<char> image(indexBytes(slotCount), 0);
+	IndexHeader& header = *reinterpret_cast<IndexHeader*>(image.data());
+	std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+	header.format = INDEX_FORMAT;
+	header.slotCount = slotCount;
+	header.generation = generation;
+	header.clock = clock;
+	return image;
+}
+
+}  // namespace
+
+/*
+ * Open (or create) a cache directory
+ * Only the index is mapped; records are read from the log on lookup.
+ * @param directory: cache directory, created if missing
+ * @param options: size budget and durability
+ */
+DiskCache::DiskCache(const std::string& directory, const DiskCacheOptions& options)
+	: directory_(directory), options_(options) {
+	if (::mkdir(directory_.c_str(), 0755) != 0 && errno != EEXIST) {
+		throw fileError("cannot create", directory_, errno);
+	}
+	std::string lockPath = directory_ + "/lock";
+	lockFd_ = ::open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (lockFd_ < 0) {
+		throw fileError("cannot open", lockPath, errno);
+	}
+
+	try {
+		FileLock lock(lockFd_);
+		mapping_ = openMapping();
+		if (!mapping_) {
+			// first use, or an index this version cannot read: start empty
+			int fd = ::open(logPath(directory_, 1).c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+			if (fd < 0) {
+				throw fileError("cannot create", logPath(directory_, 1), errno);
+			}
+			::close(fd);
+			publishIndex(directory_, emptyIndex(INITIAL_SLOTS, 1, 0), options_.sync);
+			mapping_ = openMapping();
+			if (!mapping_) {
+				throw std::runtime_error("cannot open cache index in '" + directory_ + "'");
+			}
+		}
+
+		// logs left behind by a compaction that did not finish
+		if (DIR* dir = ::opendir(directory_.c_str())) {
+			std::string live = "log." + std::to_string(mapping_->header().generation);
+			while (struct dirent* entry = ::readdir(dir)) {
+				if (std::strncmp(entry->d_name, "log.", 4) == 0 && live != entry->d_name) {
+					::unlink((directory_ + "/" + entry->d_name).c_str());
+				}
+			}
+			::closedir(dir);
+		}
+	}
+	catch (...) {
+		mapping_.reset();
+		::close(lockFd_);
+		throw;
+	}
+}
+
+DiskCache::~DiskCache() {
+	mapping_.reset();
+	if (lockFd_ >= 0) {
+		::close(lockFd_);
+	}
+}
+
+/*
+ * Map the current index and open its log
+ * Retries when a compaction in another process swaps them in between.
+ * @return: the mapping, or nullptr if there is no readable index
+ */
+std::shared_ptr<DiskCache::Mapping> DiskCache::openMapping() const {
+	std::string indexPath = directory_ + "/index";
+	for (int attempt = 0; attempt < 8; ++attempt) {
+		int fd = ::open(indexPath.c_str(), O_RDWR | O_CLOEXEC);
+		if (fd < 0) {
+			if (errno == ENOENT) {
+				return nullptr;
+			}
+			throw fileError("cannot open", indexPath, errno);
+		}
+
+		struct stat info;
+		if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(IndexHeader)) {
+			::close(fd);
+			return nullptr;
+		}
+		auto mapping = std::make_shared<Mapping>();
+		mapping->bytes = static_cast<size_t>(info.st_size);
+		mapping->data = ::mmap(nullptr, mapping->bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		// the mapping stays valid after the descriptor is closed
+		::close(fd);
+		if (mapping->data == MAP_FAILED) {
+			mapping->data = nullptr;
+			throw fileError("cannot map", indexPath, errno);
+		}
+
+		const IndexHeader& header = mapping->header();
+		uint32_t slotCount = header.slotCount;
+		if (std::memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 || header.format != INDEX_FORMAT ||
+			slotCount == 0 || (slotCount & (slotCount - 1)) != 0 || indexBytes(slotCount) != mapping->bytes) {
+			return nullptr;
+		}
+
+		mapping->logFd = ::open(logPath(directory_, header.generation).c_str(), O_RDWR | O_CLOEXEC);
+		if (mapping->logFd >= 0) {
+			return mapping;
+		}
+		if (errno != ENOENT) {
+			throw fileError("cannot open", logPath(directory_, header.generation), errno);
+		}
+		// compacted away since the index was opened: the new index is in place
+	}
+	throw std::runtime_error("cache index in '" + directory_ + "' keeps changing");
+}
+
+std::shared_ptr<DiskCache::Mapping> DiskCache::current() {
+	{
+		std::shared_lock<std::shared_mutex> lock(mappingMutex_);
+		if (!mapping_->stale()) {
+			return mapping_;
+		}
+	}
+	reopen();
+	std::shared_lock<std::shared_mutex> lock(mappingMutex_);
+	return mapping_;
+}
+
+void DiskCache::reopen() {
+	std::unique_lock<std::shared_mutex> lock(mappingMutex_);
+	if (!mapping_->stale()) {
+		return;
+	}
+	try {
+		std::shared_ptr<Mapping> fresh = openMapping();
+		if (fresh) {
+			mapping_ = std::move(fresh);
+		}
+	}
+	catch (const std::exception&) {
+		// keep reading the old generation; its log stays open
+		errors_.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+/*
+ * Look up a persisted report
+ * @param key: content hash and analyzer version
+ * @return: the report, or nullptr on a miss
+ */
+std::shared_ptr<AnalysisReport> DiskCache::find(const CacheKey& key) {
+	std::shared_ptr<Mapping> mapping = current();
+	IndexSlot* slot = mapping->probe(key);
+	uint32_t length = slot != nullptr ? loadShared(slot->length) : 0;
+	if (length == 0 || !sameKey(*slot, key)) {
+		misses_.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	std::string payload;
+	std::shared_ptr<AnalysisReport> report;
+	if (mapping->readRecord(*slot, length, payload)) {
+		try {
+			SnapshotView view(payload);
+			if (view.hasStructure() && view.hasResult()) {
+				report = std::make_shared<AnalysisReport>(view.report());
+			}
+		}
+		catch (const std::exception&) {
+		}
+	}
+	if (!report) {
+		errors_.fetch_add(1, std::memory_order_relaxed);
+		misses_.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	uint64_t now = __atomic_add_fetch(&mapping->header().clock, 1, __ATOMIC_RELAXED);
+	__atomic_store_n(&slot->touched, now, __ATOMIC_RELAXED);
+	hits_.fetch_add(1, std::memory_order_relaxed);
+	return report;
+}
+
+/*
+ * Persist a report
+ * Grows the index or compacts the log first when needed.
+ * @param key: content hash and analyzer version
+ * @param report: report to store
+ * @return: whether the report is now in the cache
+ */
+bool DiskCache::insert(const CacheKey& key, const AnalysisReport& report) {
+	std::string payload = writeSnapshot(report);
+	size_t recordBytes = sizeof(RecordHeader) + payload.size();
+	if (recordBytes > options_.maxBytes / 2) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> guard(writerMutex_);
+	FileLock lock(lockFd_);
+	try {
+		std::shared_ptr<Mapping> mapping = current();
+		IndexSlot* slot = mapping->probe(key);
+		if (slot != nullptr) {
+			uint32_t length = loadShared(slot->length);
+			std::string existing;
+			if (length != 0 && mapping->readRecord(*slot, length, existing)) {
+				return true;  // stored by another thread or process
+			}
+		}
+
+		const IndexHeader& header = mapping->header();
+		if ((static_cast<uint64_t>(header.entries) + 1) * 100 > static_cast<uint64_t>(header.slotCount) * MAX_LOAD_PERCENT) {
+			rebuild(*mapping, header.slotCount * 2, SIZE_MAX);
+			mapping = current();
+		}
+		if (loadShared(mapping->header().logBytes) + recordBytes > options_.maxBytes) {
+			rebuild(*mapping, mapping->header().slotCount, options_.maxBytes / 2);
+			mapping = current();
+		}
+		if (!append(*mapping, key, payload)) {
+			errors_.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+	}
+	catch (const std::exception&) {
+		errors_.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	insertions_.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+/*
+ * Append a record and publish it in the index (writer lock held)
+ * The log end is committed before the slot, so a crash at any point leaves
+ * at worst an unreferenced tail that the next append overwrites.
+ */
+bool DiskCache::append(Mapping& mapping, const CacheKey& key, const std::string& payload) {
+	IndexHeader& header = mapping.header();
+	IndexSlot* slot = mapping.probe(key);
+	if (slot == nullptr) {
+		return false;
+	}
+
+	RecordHeader record;
+	std::memcpy(record.magic, RECORD_MAGIC, sizeof(RECORD_MAGIC));
+	record.length = static_cast<uint32_t>(payload.size());
+	record.low = key.hash.low;
+	record.high = key.hash.high;
+	record.version = key.version;
+	record.checksum = checksum(payload);
+
+	uint64_t offset = header.logBytes;
+	if (!writeAll(mapping.logFd, &record, sizeof(record), offset) ||
+		!writeAll(mapping.logFd, payload.data(), payload.size(), offset + sizeof(record))) {
+		return false;
+	}
+	if (options_.sync && ::fdatasync(mapping.logFd) != 0) {
+		return false;
+	}
+	storeShared(header.logBytes, offset + sizeof(record) + payload.size());
+
+	// a slot of the same key whose record was lost is repointed in place;
+	// a reader that sees the new offset with the old length misses
+	bool reused = loadShared(slot->length) != 0;
+	if (!reused) {
+		slot->low = key.hash.low;
+		slot->high = key.hash.high;
+		slot->version = key.version;
+	}
+	storeShared(slot->offset, offset);
+	slot->touched = __atomic_add_fetch(&header.clock, 1, __ATOMIC_RELAXED);
+	storeShared(slot->length, record.length);
+	if (!reused) {
+		storeShared(header.entries, header.entries + 1);
+	}
+	if (options_.sync) {
+		::msync(mapping.data, mapping.bytes, MS_ASYNC);
+	}
+	return true;
+}
+
+/*
+ * Replace the index (writer lock held)
+ * With keepBytes = SIZE_MAX the log is kept and only the table is resized.
+ * Otherwise the most recently used records that fit in keepBytes are copied
+ * to the next log generation and the old log is removed.
+ * @param mapping: current generation
+ * @param slotCount: size of the new table (a power of two)
+ * @param keepBytes: record bytes to keep
+ */
+void DiskCache::rebuild(Mapping& mapping, size_t slotCount, size_t keepBytes) {
+	const IndexHeader& header = mapping.header();
+	std::vector<IndexSlot> live;
+	live.reserve(header.entries);
+	for (uint32_t i = 0; i < header.slotCount; ++i) {
+		const IndexSlot& slot = mapping.slots()[i];
+		if (loadShared(slot.length) != 0) {
+			live.push_back(slot);
+		}
+	}
+
+	bool compacting = keepBytes != SIZE_MAX;
+	uint32_t generation = compacting ? header.generation + 1 : header.generation;
+	while (live.size() * 100 > slotCount * MAX_LOAD_PERCENT) {
+		slotCount *= 2;
+	}
+	std::vector<char> image = emptyIndex(static_cast<uint32_t>(slotCount), generation, header.clock);
+	IndexHeader& fresh = *reinterpret_cast<IndexHeader*>(image.data());
+	IndexSlot* table = reinterpret_cast<IndexSlot*>(image.data() + sizeof(IndexHeader));
+	auto place = [&](const IndexSlot& slot) {
+		uint32_t at = static_cast<uint32_t>(slot.low) & static_cast<uint32_t>(slotCount - 1);
+		while (table[at].length != 0) {
+			at = (at + 1) & static_cast<uint32_t>(slotCount - 1);
+		}
+		table[at] = slot;
+		fresh.entries++;
+	};
+
+	std::string newLog = logPath(directory_, generation);
+	if (!compacting) {
+		fresh.logBytes = header.logBytes;
+		for (const IndexSlot& slot : live) {
+			place(slot);
+		}
+	}
+	else {
+		std::sort(live.begin(), live.end(), [](const IndexSlot& a, const IndexSlot& b) { return a.touched > b.touched; });
+		int fd = ::open(newLog.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (fd < 0) {
+			throw fileError("cannot create", newLog, errno);
+		}
+		std::string buffer;
+		std::string payload;
+		uint64_t written = 0;
+		bool ok = true;
+		for (const IndexSlot& slot : live) {
+			size_t recordBytes = sizeof(RecordHeader) + slot.length;
+			if (written + buffer.size() + recordBytes > keepBytes) {
+				continue;
+			}
+			if (!mapping.readRecord(slot, slot.length, payload)) {
+				continue;  // lost or damaged: dropped
+			}
+			IndexSlot moved = slot;
+			moved.offset = written + buffer.size();
+			RecordHeader record;
+			std::memcpy(record.magic, RECORD_MAGIC, sizeof(RECORD_MAGIC));
+			record.length = slot.length;
+			record.low = slot.low;
+			record.high = slot.high;
+			record.version = slot.version;
+			record.checksum = checksum(payload);
+			buffer.append(reinterpret_cast<const char*>(&record), sizeof(record));
+			buffer += payload;
+			place(moved);
+			if (buffer.size() >= COPY_BUFFER_BYTES) {
+				ok = ok && writeAll(fd, buffer.data(), buffer.size(), written);
+				written += buffer.size();
+				buffer.clear();
+			}
+		}
+		ok = ok && writeAll(fd, buffer.data(), buffer.size(), written);
+		written += buffer.size();
+		ok = ok && (!options_.sync || ::fsync(fd) == 0);
+		int error = errno;
+		::close(fd);
+		if (!ok) {
+			::unlink(newLog.c_str());
+			throw fileError("cannot write", newLog, error);
+		}
+		fresh.logBytes = written;
+		if (keepBytes > 0) {
+			compactions_.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	publishIndex(directory_, image, options_.sync);
+	storeShared(mapping.header().stale, uint32_t(1));
+	if (compacting) {
+		// processes still reading it keep it open until they reopen
+		::unlink(logPath(directory_, header.generation).c_str());
+	}
+	reopen();
+}
+
+/*
+ * Compact the log now, keeping the most recently used records
+ */
+void DiskCache::compact() {
+	std::lock_guard<std::mutex> guard(writerMutex_);
+	FileLock lock(lockFd_);
+	std::shared_ptr<Mapping> mapping = current();
+	rebuild(*mapping, mapping->header().slotCount, options_.maxBytes / 2);
+}
+
+/*
+ * Drop every record, starting a new empty generation
+ */
+void DiskCache::clear() {
+	std::lock_guard<std::mutex> guard(writerMutex_);
+	FileLock lock(lockFd_);
+	std::shared_ptr<Mapping> mapping = current();
+	rebuild(*mapping, INITIAL_SLOTS, 0);
+}
+
+/*
+ * Counters of this process and the shared size of the cache
+ * @return: hits, misses, insertions, compactions, errors and current size
+ */
+DiskCacheStats DiskCache::stats() const {
+	DiskCacheStats stats;
+	stats.hits = hits_.load(std::memory_order_relaxed);
+	stats.misses = misses_.load(std::memory_order_relaxed);
+	stats.insertions = insertions_.load(std::memory_order_relaxed);
+	stats.compactions = compactions_.load(std::memory_order_relaxed);
+	stats.errors = errors_.load(std::memory_order_relaxed);
+	stats.capacityBytes = options_.maxBytes;
+
+	std::shared_lock<std::shared_mutex> lock(mappingMutex_);
+	const IndexHeader& header = mapping_->header();
+	stats.entries = loadShared(header.entries);
+	stats.logBytes = static_cast<size_t>(loadShared(header.logBytes));
+	stats.generation = header.generation;
+	return stats;
+}
+
+}  // namespace code_educator
@@ -0,0 +1,90 @@
+#include "MappedFile.hpp"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace code_educator {
+
+namespace {
+
+std::runtime_error fileError(const char* what, const std::string& path, int error) {
+	return std::runtime_error(std::string(what) + " '" + path + "': " + std::strerror(error));
+}
+
+}  // namespace
+
+/*
+ * Map a file read-only
+ * Large files are advised for sequential access, since analysis reads them
+ * front to back exactly once.
+ * @param path: file to map
+ */
+MappedFile::MappedFile(const std::string& path) {
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		throw fileError("cannot open", path, errno);
+	}
+
+	struct stat info;
+	if (::fstat(fd, &info) != 0) {
+		int error = errno;
+		::close(fd);
+		throw fileError("cannot stat", path, error);
+	}
+	if (!S_ISREG(info.st_mode)) {
+		::close(fd);
+		throw std::runtime_error("not a regular file '" + path + "'");
+	}
+
+	size_ = static_cast<size_t>(info.st_size);
+	if (size_ > 0) {
+		data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data_ == MAP_FAILED) {
+			int error = errno;
+			data_ = nullptr;
+			size_ = 0;
+			::close(fd);
+			throw fileError("cannot map", path, error);
+		}
+		if (size_ >= SEQUENTIAL_THRESHOLD) {
+			::madvise(data_, size_, MADV_SEQUENTIAL);
+		}
+	}
+	// the mapping stays valid after the descriptor is closed
+	::close(fd);
+}
+
+MappedFile::~MappedFile() {
+	release();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	: data_(other.data_), size_(other.size_) {
+	other.data_ = nullptr;
+	other.size_ = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	if (this != &other) {
+		release();
+		data_ = other.data_;
+		size_ = other.size_;
+		other.data_ = nullptr;
+		other.size_ = 0;
+	}
+	return *this;
+}
+
+void MappedFile::release() {
+	if (data_ != nullptr) {
+		::munmap(data_, size_);
+		data_ = nullptr;
+		size_ = 0;
+	}
+}
+
+}  // namespace code_educator
@@ -0,0 +1,176 @@
+#include "ResultCache.hpp"
+#include "Analyzer.hpp"
+
+namespace code_educator {
+
+namespace {
+
+// per-node overhead of the standard containers (pointers, hash, allocator)
+const size_t NODE_OVERHEAD = 48;
+
+size_t stringSize(const std::string& text) {
+	// short strings live inside the object
+	return text.capacity() > 15 ? text.capacity() + 1 : 0;
+}
+
+size_t stringsSize(const std::vector<std::string>& items) {
+	size_t bytes = items.capacity() * sizeof(std::string);
+	for (const auto& item : items) {
+		bytes += stringSize(item);
+	}
+	return bytes;
+}
+
+template <typename Map>
+size_t mapSize(const Map& items) {
+	size_t bytes = 0;
+	for (const auto& item : items) {
+		bytes += NODE_OVERHEAD + sizeof(item) + stringSize(item.first);
+	}
+	return bytes;
+}
+
+}  // namespace
+
+/*
+ * Estimate the memory held by a report
+ * @param report: report to measure
+ * @return: approximate size in bytes
+ */
+size_t approximateSize(const AnalysisReport& report) {
+	size_t bytes = sizeof(AnalysisReport);
+
+	const CodeStructure& structure = report.structure;
+	bytes += stringSize(structure.language);
+	bytes += stringsSize(structure.imports);
+	bytes += stringsSize(structure.functions);
+	bytes += stringsSize(structure.classes);
+	bytes += mapSize(structure.metadata);
+	for (const auto& item : structure.metadata) {
+		bytes += stringSize(item.second);
+	}
+
+	const AnalysisResult& result = report.result;
+	bytes += mapSize(result.tokenFrequency);
+	bytes += stringsSize(result.potentialIssues);
+	bytes += stringsSize(result.suggestions);
+	bytes += mapSize(result.metadata);
+	for (const auto& item : result.metadata) {
+		bytes += stringSize(item.second);
+	}
+	return bytes;
+}
+
+ResultCache::ResultCache(size_t maxBytes, size_t shards)
+	: maxBytes_(maxBytes) {
+	if (shards == 0) {
+		shards = 1;
+	}
+	shardBytes_ = maxBytes / shards;
+	shards_.reserve(shards);
+	for (size_t i = 0; i < shards; ++i) {
+		shards_.emplace_back(new Shard());
+	}
+}
+
+ResultCache::Shard& ResultCache::shardFor(const CacheKey& key) {
+	// the low bits pick the bucket inside the shard, use the high ones here
+	return *shards_[(key.hash.high >> 32) % shards_.size()];
+}
+
+/*
+ * Look up a cached report
+ * @param key: content hash and analyzer version
+ * @return: cached report, or nullptr on a miss
+ */
+std::shared_ptr<const AnalysisReport> ResultCache::find(const CacheKey& key) {
+	Shard& shard = shardFor(key);
+	{
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		auto it = shard.index.find(key);
+		if (it != shard.index.end()) {
+			shard.order.splice(shard.order.begin(), shard.order, it->second);
+			hits_.fetch_add(1, std::memory_order_relaxed);
+			return it->second->report;
+		}
+	}
+	misses_.fetch_add(1, std::memory_order_relaxed);
+	return nullptr;
+}
+
+/*
+ * Store a report, evicting least recently used entries to stay in budget
+ * Reports larger than a shard's budget are not cached.
+ * @param key: content hash and analyzer version
+ * @param report: report to cache
+ */
+void ResultCache::insert(const CacheKey& key, std::shared_ptr<const AnalysisReport> report) {
+	if (!report) {
+		return;
+	}
+	size_t bytes = approximateSize(*report) + sizeof(Entry) + NODE_OVERHEAD * 2;
+	if (bytes > shardBytes_) {
+		return;
+	}
+
+	Shard& shard = shardFor(key);
+	std::vector<std::shared_ptr<const AnalysisReport>> evicted;  // freed after unlocking
+	std::lock_guard<std::mutex> lock(shard.mutex);
+
+	auto it = shard.index.find(key);
+	if (it != shard.index.end()) {
+		// another thread computed the same input first
+		shard.order.splice(shard.order.begin(), shard.order, it->second);
+		return;
+	}
+
+	shard.order.push_front(Entry{key, std::move(report), bytes});
+	shard.index.emplace(key, shard.order.begin());
+	shard.bytes += bytes;
+	insertions_.fetch_add(1, std::memory_order_relaxed);
+
+	while (shard.bytes > shardBytes_) {
+		Entry& last = shard.order.back();
+		shard.bytes -= last.bytes;
+		shard.index.erase(last.key);
+		evicted.push_back(std::move(last.report));
+		shard.order.pop_back();
+		evictions_.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+/*
+ * Drop every cached report (counters are kept)
+ */
+void ResultCache::clear() {
+	for (auto& shard : shards_) {
+		std::list<Entry> dropped;
+		{
+			std::lock_guard<std::mutex> lock(shard->mutex);
+			dropped.swap(shard->order);
+			shard->index.clear();
+			shard->bytes = 0;
+		}
+	}
+}
+
+/*
+ * Snapshot of the cache counters
+ * @return: hits, misses, insertions, evictions and current size
+ */
+CacheStats ResultCache::stats() const {
+	CacheStats stats;
+	stats.hits = hits_.load(std::memory_order_relaxed);
+	stats.misses = misses_.load(std::memory_order_relaxed);
+	stats.insertions = insertions_.load(std::memory_order_relaxed);
+	stats.evictions = evictions_.load(std::memory_order_relaxed);
+	stats.capacityBytes = maxBytes_;
+	for (const auto& shard : shards_) {
+		std::lock_guard<std::mutex> lock(shard->mutex);
+		stats.entries += shard->index.size();
+		stats.bytes += shard->bytes;
+	}
+	return stats;
+}
+
+}  // namespace code_educator
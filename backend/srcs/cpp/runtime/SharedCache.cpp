@@ -0,0 +1,367 @@
+#include "SharedCache.hpp"
+#include "Analyzer.hpp"
+#include "ResultSnapshot.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace code_educator {
+
+namespace {
+
+const char SEGMENT_MAGIC[4] = {'C', 'E', 'S', 'C'};
+const uint32_t SEGMENT_FORMAT = 1;
+
+// slots a key may occupy, starting at its bucket
+const size_t PROBE_SLOTS = 8;
+const size_t MIN_SLOTS = 64;
+const size_t ARENA_BYTES_PER_SLOT = 2048;
+// reports larger than this share of the arena are not published
+const size_t MAX_REPORT_SHARE = 4;
+// how long a process attaching waits for the creator to set the segment up
+const int ATTACH_WAIT_MS = 2000;
+
+template <typename T>
+T loadShared(const T& field, int order = __ATOMIC_RELAXED) {
+	return __atomic_load_n(&field, order);
+}
+
+template <typename T>
+void storeShared(T& field, T value, int order = __ATOMIC_RELAXED) {
+	__atomic_store_n(&field, value, order);
+}
+
+uint32_t checksum(std::string_view payload) {
+	return static_cast<uint32_t>(hashContent(payload).low);
+}
+
+std::runtime_error segmentError(const char* what, const std::string& name, int error) {
+	return std::runtime_error(std::string(what) + " shared cache '" + name + "': " + std::strerror(error));
+}
+
+size_t roundUpPowerOfTwo(size_t value) {
+	size_t power = 1;
+	while (power < value) {
+		power <<= 1;
+	}
+	return power;
+}
+
+// Native byte order and layout: only processes of one build attach to a
+// segment (the format number guards against older ones).
+struct SegmentHeader {
+	char magic[4];
+	uint32_t format;
+	uint32_t ready;           // set by the creator once the rest is filled in
+	uint32_t slotCount;       // a power of two
+	uint64_t arenaBytes;
+	uint64_t writePos;        // bytes ever reserved in the arena; position % arenaBytes is the offset
+	uint64_t published;       // inserts by every process
+	uint8_t reserved[24];
+};
+static_assert(sizeof(SegmentHeader) == 64, "segment header layout");
+
+// Free while length is 0. seq is odd while a writer owns the slot.
+struct SegmentSlot {
+	uint32_t seq;
+	uint32_t length;
+	uint64_t low;
+	uint64_t high;
+	uint32_t version;
+	uint32_t checksum;
+	uint64_t position;        // arena position of the report
+};
+static_assert(sizeof(SegmentSlot) == 40, "segment slot layout");
+
+SegmentHeader& headerOf(void* data) {
+	return *static_cast<SegmentHeader*>(data);
+}
+
+SegmentSlot* slotsOf(void* data) {
+	return reinterpret_cast<SegmentSlot*>(static_cast<char*>(data) + sizeof(SegmentHeader));
+}
+
+char* arenaOf(void* data, size_t slotCount) {
+	return static_cast<char*>(data) + sizeof(SegmentHeader) + slotCount * sizeof(SegmentSlot);
+}
+
+}  // namespace
+
+/*
+ * Attach to a shared memory segment, creating it if needed
+ * @param name: segment name ("/" is prepended if missing)
+ * @param arenaBytes: arena size when this process creates the segment
+ * @param slots: slot count when this process creates it (0 = from arenaBytes)
+ */
+SharedCache::SharedCache(const std::string& name, size_t arenaBytes, size_t slots)
+	: name_(!name.empty() && name[0] == '/' ? name : "/" + name) {
+	int fd = ::shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+	bool creator = fd >= 0;
+	if (!creator) {
+		if (errno != EEXIST) {
+			throw segmentError("cannot create", name_, errno);
+		}
+		fd = ::shm_open(name_.c_str(), O_RDWR | O_CLOEXEC, 0600);
+		if (fd < 0) {
+			throw segmentError("cannot open", name_, errno);
+		}
+	}
+
+	size_t bytes = 0;
+	if (creator) {
+		arenaBytes = std::max<size_t>(arenaBytes, MIN_SLOTS * ARENA_BYTES_PER_SLOT);
+		slots = roundUpPowerOfTwo(std::max(slots != 0 ? slots : arenaBytes / ARENA_BYTES_PER_SLOT, MIN_SLOTS));
+		bytes = sizeof(SegmentHeader) + slots * sizeof(SegmentSlot) + arenaBytes;
+		if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+			int error = errno;
+			::close(fd);
+			::shm_unlink(name_.c_str());
+			throw segmentError("cannot size", name_, error);
+		}
+		// reserve the pages now: a segment larger than the shared memory
+		// file system (64 MB /dev/shm in a default Docker container) would
+		// otherwise map fine and raise SIGBUS once the ring reaches its end
+		int error = ::posix_fallocate(fd, 0, static_cast<off_t>(bytes));
+		if (error != 0) {
+			::close(fd);
+			::shm_unlink(name_.c_str());
+			throw segmentError("cannot reserve", name_, error);
+		}
+	}
+	else {
+		// the creator may not have sized it yet
+		for (int waited = 0; ; ++waited) {
+			struct stat info;
+			if (::fstat(fd, &info) != 0) {
+				int error = errno;
+				::close(fd);
+				throw segmentError("cannot stat", name_, error);
+			}
+			bytes = static_cast<size_t>(info.st_size);
+			if (bytes >= sizeof(SegmentHeader) || waited >= ATTACH_WAIT_MS) {
+				break;
+			}
+			::usleep(1000);
+		}
+	}
+
+	if (bytes >= sizeof(SegmentHeader)) {
+		data_ = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	int error = errno;
+	::close(fd);
+	if (bytes < sizeof(SegmentHeader)) {
+		throw std::runtime_error("shared cache '" + name_ + "' was never set up");
+	}
+	if (data_ == MAP_FAILED) {
+		data_ = nullptr;
+		throw segmentError("cannot map", name_, error);
+	}
+	bytes_ = bytes;
+
+	SegmentHeader& shared = headerOf(data_);
+	if (creator) {
+		std::memcpy(shared.magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+		shared.format = SEGMENT_FORMAT;
+		shared.slotCount = static_cast<uint32_t>(slots);
+		shared.arenaBytes = arenaBytes;
+		storeShared(shared.ready, uint32_t(1), __ATOMIC_RELEASE);
+	}
+	else {
+		for (int waited = 0; loadShared(shared.ready, __ATOMIC_ACQUIRE) == 0; ++waited) {
+			if (waited >= ATTACH_WAIT_MS) {
+				::munmap(data_, bytes_);
+				throw std::runtime_error("shared cache '" + name_ + "' was never set up");
+			}
+			::usleep(1000);
+		}
+	}
+
+	slotCount_ = shared.slotCount;
+	arenaBytes_ = static_cast<size_t>(shared.arenaBytes);
+	if (std::memcmp(shared.magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0 || shared.format != SEGMENT_FORMAT ||
+		slotCount_ == 0 || (slotCount_ & (slotCount_ - 1)) != 0 || arenaBytes_ == 0 ||
+		sizeof(SegmentHeader) + slotCount_ * sizeof(SegmentSlot) + arenaBytes_ != bytes_) {
+		::munmap(data_, bytes_);
+		throw std::runtime_error("shared cache '" + name_ + "' has an incompatible layout");
+	}
+}
+
+SharedCache::~SharedCache() {
+	if (data_ != nullptr) {
+		::munmap(data_, bytes_);
+	}
+}
+
+size_t SharedCache::bucket(const CacheKey& key) const {
+	return static_cast<size_t>(key.hash.low) & (slotCount_ - 1);
+}
+
+namespace {
+
+// a consistent copy of a slot, taken under its seqlock
+bool readSlot(const SegmentSlot& slot, SegmentSlot& copy) {
+	uint32_t before = loadShared(slot.seq, __ATOMIC_ACQUIRE);
+	if (before & 1) {
+		return false;
+	}
+	copy.length = loadShared(slot.length);
+	copy.low = loadShared(slot.low);
+	copy.high = loadShared(slot.high);
+	copy.version = loadShared(slot.version);
+	copy.checksum = loadShared(slot.checksum);
+	copy.position = loadShared(slot.position);
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	copy.seq = before;
+	return loadShared(slot.seq) == before;
+}
+
+bool holds(const SegmentSlot& slot, const CacheKey& key) {
+	return slot.length != 0 && slot.low == key.hash.low && slot.high == key.hash.high && slot.version == key.version;
+}
+
+}  // namespace
+
+/*
+ * Look up a report published by any attached process
+ * @param key: content hash and analyzer version
+ * @return: the report, or nullptr on a miss
+ */
+std::shared_ptr<AnalysisReport> SharedCache::find(const CacheKey& key) {
+	SegmentHeader& shared = headerOf(data_);
+	size_t mask = slotCount_ - 1;
+	size_t first = bucket(key);
+	for (size_t step = 0; step < PROBE_SLOTS && step <= mask; ++step) {
+		const SegmentSlot& slot = slotsOf(data_)[(first + step) & mask];
+		SegmentSlot copy;
+		// a slot being written is skipped: it may hold another key by now
+		if (!readSlot(slot, copy) || !holds(copy, key)) {
+			continue;
+		}
+
+		std::string payload(copy.length, '\0');
+		std::memcpy(&payload[0], arenaOf(data_, slotCount_) + copy.position % arenaBytes_, copy.length);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		// lapped by the ring while copying (or before): the bytes are another report's
+		if (loadShared(shared.writePos) > copy.position + arenaBytes_ || checksum(payload) != copy.checksum) {
+			break;
+		}
+		try {
+			SnapshotView view(payload);
+			if (view.hasStructure() && view.hasResult()) {
+				hits_.fetch_add(1, std::memory_order_relaxed);
+				return std::make_shared<AnalysisReport>(view.report());
+			}
+		}
+		catch (const std::exception&) {
+		}
+		break;
+	}
+	misses_.fetch_add(1, std::memory_order_relaxed);
+	return nullptr;
+}
+
+/*
+ * Publish a report
+ * Reuses the key's slot, else a free one, else the one pointing at the
+ * oldest report in the key's probe window.
+ * @param key: content hash and analyzer version
+ * @param report: report to publish
+ * @return: whether it was published
+ */
+bool SharedCache::insert(const CacheKey& key, const AnalysisReport& report) {
+	std::string payload = writeSnapshot(report);
+	if (payload.size() > arenaBytes_ / MAX_REPORT_SHARE) {
+		return false;
+	}
+	SegmentHeader& shared = headerOf(data_);
+	uint64_t length = payload.size();
+
+	// pick the slot first, so a report that is already there costs no arena space
+	size_t mask = slotCount_ - 1;
+	size_t first = bucket(key);
+	SegmentSlot* target = nullptr;
+	uint32_t targetSeq = 0;
+	int targetRank = 3;  // 0: same key, 1: free, 2: oldest
+	uint64_t oldest = UINT64_MAX;
+	for (size_t step = 0; step < PROBE_SLOTS && step <= mask; ++step) {
+		SegmentSlot& slot = slotsOf(data_)[(first + step) & mask];
+		SegmentSlot copy;
+		if (!readSlot(slot, copy)) {
+			continue;
+		}
+		int rank = holds(copy, key) ? 0 : copy.length == 0 ? 1 : 2;
+		if (rank == 0 && loadShared(shared.writePos) + length <= copy.position + arenaBytes_) {
+			return true;  // published by another process and not about to be overwritten
+		}
+		if (rank < targetRank || (rank == 2 && targetRank == 2 && copy.position < oldest)) {
+			target = &slot;
+			targetSeq = copy.seq;
+			targetRank = rank;
+			oldest = copy.position;
+		}
+	}
+	if (target == nullptr || !__atomic_compare_exchange_n(&target->seq, &targetSeq, targetSeq + 1, false,
+			__ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+		contended_.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	// reserve arena space; a report never wraps, the tail is skipped instead
+	uint64_t position = loadShared(shared.writePos);
+	uint64_t start;
+	do {
+		uint64_t offset = position % arenaBytes_;
+		start = offset + length > arenaBytes_ ? position + (arenaBytes_ - offset) : position;
+	} while (!__atomic_compare_exchange_n(&shared.writePos, &position, start + length, true,
+		__ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+	std::memcpy(arenaOf(data_, slotCount_) + start % arenaBytes_, payload.data(), payload.size());
+
+	storeShared(target->length, static_cast<uint32_t>(length));
+	storeShared(target->low, key.hash.low);
+	storeShared(target->high, key.hash.high);
+	storeShared(target->version, key.version);
+	storeShared(target->checksum, checksum(payload));
+	storeShared(target->position, start);
+	storeShared(target->seq, targetSeq + 2, __ATOMIC_RELEASE);
+
+	__atomic_add_fetch(&shared.published, 1, __ATOMIC_RELAXED);
+	insertions_.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+/*
+ * Counters of this process and the shared totals of the segment
+ * @return: hits, misses, insertions, contention and arena use
+ */
+SharedCacheStats SharedCache::stats() const {
+	SharedCacheStats stats;
+	stats.hits = hits_.load(std::memory_order_relaxed);
+	stats.misses = misses_.load(std::memory_order_relaxed);
+	stats.insertions = insertions_.load(std::memory_order_relaxed);
+	stats.contended = contended_.load(std::memory_order_relaxed);
+	stats.publishedTotal = loadShared(headerOf(data_).published);
+	stats.slots = slotCount_;
+	stats.arenaBytes = arenaBytes_;
+	stats.arenaWritten = static_cast<size_t>(loadShared(headerOf(data_).writePos));
+	return stats;
+}
+
+/*
+ * Unlink a segment by name
+ * @param name: segment name ("/" is prepended if missing)
+ * @return: whether a segment was removed
+ */
+bool SharedCache::remove(const std::string& name) {
+	std::string path = !name.empty() && name[0] == '/' ? name : "/" + name;
+	return ::shm_unlink(path.c_str()) == 0;
+}
+
+}  // namespace code_educator
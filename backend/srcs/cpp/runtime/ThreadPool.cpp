@@ -0,0 +1,181 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <exception>
+#ifdef __GLIBCXX__
+#include <cxxabi.h>
+#endif
+
+namespace code_educator {
+
+namespace {
+// pool and queue index of the worker running on this thread
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local size_t currentIndex = 0;
+}  // namespace
+
+ThreadPool::ThreadPool(size_t threads) {
+	if (threads == 0) {
+		threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+	}
+	for (size_t i = 0; i < threads; ++i) {
+		queues_.push_back(std::make_unique<Queue>());
+	}
+	for (size_t i = 0; i < threads; ++i) {
+		workers_.emplace_back([this, i]() { workerLoop(i); });
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex_);
+		stopping_ = true;
+	}
+	wake_.notify_all();
+	for (std::thread& worker : workers_) {
+		worker.join();
+	}
+}
+
+/*
+ * Queue a task
+ * Tasks submitted from a worker go to its own deque, others are spread
+ * round-robin.
+ */
+void ThreadPool::submit(std::function<void()> task) {
+	size_t index = (currentPool == this) ? currentIndex : nextQueue_++ % queues_.size();
+	{
+		std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+		queues_[index]->tasks.push_back(std::move(task));
+	}
+	pending_++;
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex_);
+	}
+	wake_.notify_one();
+}
+
+bool ThreadPool::popTask(size_t index, std::function<void()>& task) {
+	// own work first, newest first
+	{
+		Queue& own = *queues_[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty()) {
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+	// steal the oldest task of another worker
+	for (size_t n = 1; n < queues_.size(); ++n) {
+		Queue& victim = *queues_[(index + n) % queues_.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty()) {
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+	currentPool = this;
+	currentIndex = index;
+
+	std::function<void()> task;
+	while (true) {
+		if (popTask(index, task)) {
+			pending_--;
+			try {
+				task();
+#ifdef __GLIBCXX__
+			} catch (abi::__forced_unwind&) {
+				throw;  // pthread_exit()/cancellation must reach the thread start
+#endif
+			} catch (...) {
+				// a detached task has nobody to report to
+			}
+			task = nullptr;
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex_);
+		wake_.wait(lock, [this]() { return stopping_ || pending_ > 0; });
+		if (stopping_ && pending_ == 0) {
+			return;
+		}
+	}
+}
+
+/*
+ * Run fn over [0, count) on the pool and wait for it
+ * Indices are claimed from a shared counter, so fast workers simply take
+ * more of them. Helpers that start after the work is gone exit at once,
+ * which also keeps nested calls from a worker thread deadlock-free.
+ */
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn, size_t maxWorkers) {
+	if (count == 0) {
+		return;
+	}
+
+	struct State {
+		std::atomic<size_t> next{0};
+		std::atomic<size_t> active{0};
+		std::atomic<bool> failed{false};
+		std::mutex mutex;
+		std::condition_variable done;
+		std::exception_ptr error;
+	};
+	auto state = std::make_shared<State>();
+	const std::function<void(size_t)>* body = &fn;
+
+	auto run = [state, body, count]() {
+		size_t i;
+		while (!state->failed && (i = state->next++) < count) {
+			try {
+				(*body)(i);
+#ifdef __GLIBCXX__
+			} catch (abi::__forced_unwind&) {
+				throw;
+#endif
+			} catch (...) {
+				std::lock_guard<std::mutex> lock(state->mutex);
+				if (!state->error) {
+					state->error = std::current_exception();
+				}
+				state->failed = true;
+			}
+		}
+	};
+
+	size_t limit = maxWorkers == 0 ? workers_.size() + 1 : maxWorkers;
+	size_t helpers = std::min({limit, count, workers_.size() + 1}) - 1;
+	for (size_t h = 0; h < helpers; ++h) {
+		submit([state, run]() {
+			state->active++;
+			run();
+			if (--state->active == 0) {
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->done.notify_all();
+			}
+		});
+	}
+
+	run();
+
+	{
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->done.wait(lock, [&state]() { return state->active == 0; });
+		if (state->error) {
+			std::rethrow_exception(state->error);
+		}
+	}
+}
+
+ThreadPool& ThreadPool::shared() {
+	// never destroyed: workers must not be joined during interpreter shutdown
+	static ThreadPool* pool = new ThreadPool();
+	return *pool;
+}
+
+}  // namespace code_educator
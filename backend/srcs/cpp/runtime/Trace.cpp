@@ -0,0 +1,232 @@
+#include "Trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <unistd.h>
+
+namespace code_educator {
+
+namespace {
+
+std::atomic<bool> globalTracing{false};
+std::atomic<uint32_t> nextThreadId{1};
+std::atomic<uint64_t> clearedBeforeNs{0};
+
+// fields are atomics so a reader copying a slot being rewritten is not a data
+// race; the head counter tells it which slots to drop
+struct Slot {
+	std::atomic<const char*> name{""};
+	std::atomic<uint64_t> startNs{0};
+	std::atomic<uint64_t> durationNs{0};
+	std::atomic<uint64_t> bytes{0};
+	std::atomic<uint32_t> threadId{0};
+	std::atomic<uint32_t> depth{0};
+};
+
+// Single-producer ring: only the owning thread writes. Rings outlive their
+// threads and are handed to the next new thread.
+struct Ring {
+	std::atomic<uint64_t> head{0};  // spans written so far
+	Slot slots[TRACE_RING_SPANS];
+};
+
+struct Registry {
+	std::mutex mutex;
+	std::vector<Ring*> rings;  // every ring ever made
+	std::vector<Ring*> free;   // rings whose thread exited
+};
+
+// never destroyed: threads may exit after static destructors have run
+Registry& registry() {
+	static Registry* instance = new Registry();
+	return *instance;
+}
+
+struct ThreadTrace {
+	Ring* ring = nullptr;
+	uint32_t threadId = 0;
+	uint32_t depth = 0;
+	int captures = 0;  // live TraceCaptures on this thread
+
+	ThreadTrace() : threadId(nextThreadId.fetch_add(1, std::memory_order_relaxed)) {
+	}
+	~ThreadTrace() {
+		if (ring != nullptr) {
+			Registry& r = registry();
+			std::lock_guard<std::mutex> lock(r.mutex);
+			r.free.push_back(ring);
+		}
+	}
+
+	Ring& ownRing() {
+		if (ring == nullptr) {
+			Registry& r = registry();
+			std::lock_guard<std::mutex> lock(r.mutex);
+			if (!r.free.empty()) {
+				ring = r.free.back();
+				r.free.pop_back();
+			}
+			else {
+				ring = new Ring();
+				r.rings.push_back(ring);
+			}
+		}
+		return *ring;
+	}
+};
+
+ThreadTrace& threadTrace() {
+	thread_local ThreadTrace trace;
+	return trace;
+}
+
+// spans of one ring still intact after the copy
+void copyRing(const Ring& ring, uint64_t sinceNs, uint32_t threadId, std::vector<TraceSpan>& out) {
+	uint64_t head = ring.head.load(std::memory_order_acquire);
+	uint64_t first = head > TRACE_RING_SPANS ? head - TRACE_RING_SPANS : 0;
+	std::vector<TraceSpan> copied;
+	copied.reserve(static_cast<size_t>(head - first));
+	for (uint64_t i = first; i < head; ++i) {
+		const Slot& slot = ring.slots[i % TRACE_RING_SPANS];
+		TraceSpan span;
+		span.name = slot.name.load(std::memory_order_relaxed);
+		span.startNs = slot.startNs.load(std::memory_order_relaxed);
+		span.durationNs = slot.durationNs.load(std::memory_order_relaxed);
+		span.bytes = slot.bytes.load(std::memory_order_relaxed);
+		span.threadId = slot.threadId.load(std::memory_order_relaxed);
+		span.depth = slot.depth.load(std::memory_order_relaxed);
+		copied.push_back(span);
+	}
+
+	// slots the writer got to while we were copying are dropped (the one it
+	// may be writing right now included)
+	std::atomic_thread_fence(std::memory_order_acquire);
+	uint64_t after = ring.head.load(std::memory_order_relaxed);
+	uint64_t intact = after >= TRACE_RING_SPANS ? after - TRACE_RING_SPANS + 1 : 0;
+	for (uint64_t i = std::max(first, intact); i < head; ++i) {
+		const TraceSpan& span = copied[static_cast<size_t>(i - first)];
+		if (span.startNs >= sinceNs && (threadId == 0 || span.threadId == threadId)) {
+			out.push_back(span);
+		}
+	}
+}
+
+}  // namespace
+
+void setTracingEnabled(bool enabled) {
+	globalTracing.store(enabled, std::memory_order_relaxed);
+}
+
+bool tracingEnabled() {
+	return globalTracing.load(std::memory_order_relaxed);
+}
+
+bool tracingActive() {
+	return globalTracing.load(std::memory_order_relaxed) || threadTrace().captures > 0;
+}
+
+uint64_t traceClockNs() {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+uint32_t traceThreadId() {
+	return threadTrace().threadId;
+}
+
+uint32_t traceEnter() {
+	return threadTrace().depth++;
+}
+
+void traceLeave(const char* name, uint64_t startNs, uint64_t durationNs, uint64_t bytes, uint32_t depth) {
+	ThreadTrace& trace = threadTrace();
+	trace.depth = depth;
+	Ring& ring = trace.ownRing();
+	uint64_t head = ring.head.load(std::memory_order_relaxed);
+	Slot& slot = ring.slots[head % TRACE_RING_SPANS];
+	slot.name.store(name, std::memory_order_relaxed);
+	slot.startNs.store(startNs, std::memory_order_relaxed);
+	slot.durationNs.store(durationNs, std::memory_order_relaxed);
+	slot.bytes.store(bytes, std::memory_order_relaxed);
+	slot.threadId.store(trace.threadId, std::memory_order_relaxed);
+	slot.depth.store(depth, std::memory_order_relaxed);
+	ring.head.store(head + 1, std::memory_order_release);
+}
+
+/*
+ * Collect recorded spans
+ * @param sinceNs: oldest start time to keep (traceClockNs() scale)
+ * @param threadId: thread to keep, or 0 for every thread
+ * @return: spans ordered by start time
+ */
+std::vector<TraceSpan> traceSpans(uint64_t sinceNs, uint32_t threadId) {
+	std::vector<TraceSpan> out;
+	sinceNs = std::max(sinceNs, clearedBeforeNs.load(std::memory_order_relaxed));
+	{
+		Registry& r = registry();
+		std::lock_guard<std::mutex> lock(r.mutex);
+		for (const Ring* ring : r.rings) {
+			copyRing(*ring, sinceNs, threadId, out);
+		}
+	}
+	std::stable_sort(out.begin(), out.end(), [](const TraceSpan& a, const TraceSpan& b) {
+		return a.startNs < b.startNs || (a.startNs == b.startNs && a.depth < b.depth);
+	});
+	return out;
+}
+
+// spans started before this are hidden
+void clearTrace() {
+	clearedBeforeNs.store(traceClockNs(), std::memory_order_relaxed);
+}
+
+std::string traceToChromeJson(const std::vector<TraceSpan>& spans) {
+	std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	char buffer[256];
+	int pid = static_cast<int>(getpid());
+	for (size_t i = 0; i < spans.size(); ++i) {
+		const TraceSpan& span = spans[i];
+		// timestamps and durations are in microseconds
+		std::snprintf(buffer, sizeof(buffer),
+			"%s{\"name\":\"%s\",\"cat\":\"code_educator\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+			"\"pid\":%d,\"tid\":%u,\"args\":{\"bytes\":%llu,\"depth\":%u}}",
+			i > 0 ? "," : "", span.name, span.startNs / 1e3, span.durationNs / 1e3, pid, span.threadId,
+			static_cast<unsigned long long>(span.bytes), span.depth);
+		out += buffer;
+	}
+	out += "]}";
+	return out;
+}
+
+TraceCapture::TraceCapture() : startNs_(traceClockNs()), threadId_(traceThreadId()) {
+	threadTrace().captures++;
+}
+
+TraceCapture::~TraceCapture() {
+	stop();
+}
+
+void TraceCapture::stop() {
+	if (!stopped_) {
+		stopped_ = true;
+		endNs_ = traceClockNs();
+		// a capture destroyed on another thread must not touch that thread's count
+		if (traceThreadId() == threadId_) {
+			threadTrace().captures--;
+		}
+	}
+}
+
+std::vector<TraceSpan> TraceCapture::spans() const {
+	std::vector<TraceSpan> out = traceSpans(startNs_, threadId_);
+	if (stopped_) {
+		out.erase(std::remove_if(out.begin(), out.end(), [this](const TraceSpan& span) {
+			return span.startNs > endNs_;
+		}), out.end());
+	}
+	return out;
+}
+
+}  // namespace code_educator
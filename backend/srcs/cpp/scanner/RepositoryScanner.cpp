@@ -0,0 +1,335 @@
+#include "RepositoryScanner.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <dirent.h>
+#include <fnmatch.h>
+#include <sys/stat.h>
+
+namespace code_educator {
+
+namespace {
+
+// analyzed when ScanOptions::extensions is empty
+const char* const SOURCE_EXTENSIONS[] = {
+	".py", ".c", ".h", ".cpp", ".cc", ".cxx", ".hpp", ".hh", ".hxx",
+	".js", ".mjs", ".cjs", ".jsx"
+};
+
+// errors kept in the report; the rest are only counted
+const size_t MAX_ERRORS = 100;
+
+enum class FileStatus : uint8_t {
+	Analyzed,
+	Skipped,
+	Failed
+};
+
+struct FileOutcome {
+	FileStatus status = FileStatus::Failed;
+	FileSummary summary;
+	uint64_t bytes = 0;
+	int commentCount = 0;
+	std::string error;
+};
+
+struct Listing {
+	std::vector<std::string> directories;  // relative paths
+	std::vector<std::string> files;
+	std::string error;
+};
+
+// Per-language token sketches handed out to the tasks running at one time.
+// A task borrows a set for one file and gives it back, so no sketch is
+// shared between threads and only as many sets exist as tasks ran at once.
+class SketchSets {
+public:
+	using Set = std::map<std::string, TokenSketch>;
+
+	std::unique_ptr<Set> acquire() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (free_.empty()) {
+			return std::unique_ptr<Set>(new Set());
+		}
+		std::unique_ptr<Set> set = std::move(free_.back());
+		free_.pop_back();
+		return set;
+	}
+
+	void release(std::unique_ptr<Set> set) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		free_.push_back(std::move(set));
+	}
+
+	// merge of every set, one sketch per language
+	Set merged() {
+		Set out;
+		for (auto& set : free_) {
+			for (auto& item : *set) {
+				auto found = out.find(item.first);
+				if (found == out.end()) {
+					out.emplace(item.first, std::move(item.second));
+				}
+				else {
+					found->second.merge(item.second);
+				}
+			}
+		}
+		free_.clear();
+		return out;
+	}
+
+private:
+	std::mutex mutex_;
+	std::vector<std::unique_ptr<Set>> free_;
+};
+
+std::string joinPath(const std::string& parent, const std::string& name) {
+	return parent.empty() ? name : parent + "/" + name;
+}
+
+std::string extensionOf(const std::string& name) {
+	size_t dot = name.rfind('.');
+	if (dot == std::string::npos || dot == 0) {
+		return std::string();
+	}
+	return name.substr(dot);
+}
+
+}  // namespace
+
+RepositoryScanner::RepositoryScanner(const Analyzer& analyzer, ScanOptions options)
+	: analyzer_(analyzer), options_(std::move(options)) {}
+
+/*
+ * Check an entry against the ignore globs
+ * @param name: entry name
+ * @param relative: path relative to the scanned root
+ * @return: true if the entry must be left out
+ */
+bool RepositoryScanner::ignored(const std::string& name, const std::string& relative) const {
+	for (const auto& pattern : options_.ignore) {
+		if (fnmatch(pattern.c_str(), name.c_str(), 0) == 0 ||
+			fnmatch(pattern.c_str(), relative.c_str(), 0) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * Check a file name against the extension filter
+ * @param name: file name
+ * @return: true if the file should be analyzed
+ */
+bool RepositoryScanner::wanted(const std::string& name) const {
+	std::string extension = extensionOf(name);
+	if (extension.empty()) {
+		return false;
+	}
+	if (options_.extensions.empty()) {
+		for (const char* known : SOURCE_EXTENSIONS) {
+			if (extension == known) {
+				return true;
+			}
+		}
+		return false;
+	}
+	return std::find(options_.extensions.begin(), options_.extensions.end(), extension) != options_.extensions.end();
+}
+
+/*
+ * Scan a directory tree and aggregate the analysis of every matching file
+ * Directories are listed level by level in parallel, then the files are
+ * analyzed in parallel; each file is memory-mapped and analyzed in place.
+ * @param root: directory to scan
+ * @return: aggregated report
+ */
+RepositoryReport RepositoryScanner::scan(const std::string& root) const {
+	auto started = std::chrono::steady_clock::now();
+
+	struct stat info;
+	if (::stat(root.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+		throw std::runtime_error("not a directory '" + root + "'");
+	}
+
+	ThreadPool& pool = ThreadPool::shared();
+	RepositoryReport report;
+	report.root = root;
+
+	// 1. walk the tree, one parallel step per directory level
+	std::vector<std::string> files;
+	std::vector<std::string> level = {std::string()};
+	while (!level.empty()) {
+		std::vector<Listing> listings(level.size());
+		pool.parallelFor(level.size(), [&](size_t i) {
+			const std::string& relative = level[i];
+			Listing& listing = listings[i];
+			std::string path = relative.empty() ? root : root + "/" + relative;
+
+			DIR* dir = ::opendir(path.c_str());
+			if (dir == nullptr) {
+				listing.error = path + ": cannot open directory";
+				return;
+			}
+			while (struct dirent* entry = ::readdir(dir)) {
+				std::string name = entry->d_name;
+				if (name == "." || name == "..") {
+					continue;
+				}
+				std::string child = joinPath(relative, name);
+				if (ignored(name, child)) {
+					continue;
+				}
+
+				unsigned char type = entry->d_type;
+				if (type == DT_UNKNOWN || (type == DT_LNK && options_.followSymlinks)) {
+					struct stat entryInfo;
+					std::string full = path + "/" + name;
+					int rc = options_.followSymlinks ? ::stat(full.c_str(), &entryInfo) : ::lstat(full.c_str(), &entryInfo);
+					if (rc != 0) {
+						continue;
+					}
+					type = S_ISDIR(entryInfo.st_mode) ? DT_DIR : S_ISREG(entryInfo.st_mode) ? DT_REG : DT_UNKNOWN;
+				}
+
+				if (type == DT_DIR) {
+					listing.directories.push_back(std::move(child));
+				}
+				else if (type == DT_REG && wanted(name)) {
+					listing.files.push_back(std::move(child));
+				}
+			}
+			::closedir(dir);
+		}, options_.threads);
+
+		std::vector<std::string> next;
+		for (auto& listing : listings) {
+			if (!listing.error.empty()) {
+				report.filesFailed++;
+				if (report.errors.size() < MAX_ERRORS) {
+					report.errors.push_back(std::move(listing.error));
+				}
+			}
+			std::move(listing.directories.begin(), listing.directories.end(), std::back_inserter(next));
+			std::move(listing.files.begin(), listing.files.end(), std::back_inserter(files));
+		}
+		level.swap(next);
+	}
+
+	// 2. analyze every file (only what the summaries read)
+	AnalysisOptions analysisOptions;
+	analysisOptions.tokenFrequency = false;
+	analysisOptions.metrics = METRIC_LINES | METRIC_COMMENTS | METRIC_CYCLOMATIC | METRIC_ISSUES;
+	std::vector<FileOutcome> outcomes(files.size());
+	SketchSets sketches;
+	pool.parallelFor(files.size(), [&](size_t i) {
+		FileOutcome& outcome = outcomes[i];
+		outcome.summary.path = files[i];
+		try {
+			MappedFile file(root + "/" + files[i]);
+			outcome.bytes = file.size();
+			if (file.size() > options_.maxFileBytes) {
+				outcome.status = FileStatus::Skipped;
+				return;
+			}
+			// the extension weighs in on the detected language
+			AnalysisOptions fileOptions = analysisOptions;
+			fileOptions.fileName = files[i];
+			AnalysisReport analysis = analyzer_.report(file.view(), fileOptions);
+			outcome.status = FileStatus::Analyzed;
+			outcome.summary.language = analysis.structure.language;
+			outcome.summary.qualityScore = analysis.qualityScore;
+			outcome.summary.lineCount = analysis.result.lineCount;
+			outcome.summary.cyclomaticComplexity = analysis.result.cyclomaticComplexity;
+			outcome.summary.issueCount = analysis.result.potentialIssues.size();
+			outcome.commentCount = analysis.result.commentCount;
+
+			if (options_.tokenSketchCapacity > 0) {
+				std::unique_ptr<SketchSets::Set> set = sketches.acquire();
+				auto found = set->find(outcome.summary.language);
+				if (found == set->end()) {
+					found = set->emplace(outcome.summary.language, TokenSketch(options_.tokenSketchCapacity)).first;
+				}
+				analyzer_.sketchTokens(file.view(), found->second, outcome.summary.language);
+				sketches.release(std::move(set));
+			}
+		}
+		catch (const std::exception& e) {
+			outcome.status = FileStatus::Failed;
+			outcome.error = e.what();
+		}
+	}, options_.threads);
+
+	// 3. reduce
+	report.tokenSketches = sketches.merged();
+	uint64_t qualitySum = 0;
+	std::map<std::string, uint64_t> languageQuality;
+	std::vector<size_t> analyzed;
+	analyzed.reserve(outcomes.size());
+	for (size_t i = 0; i < outcomes.size(); ++i) {
+		FileOutcome& outcome = outcomes[i];
+		if (outcome.status == FileStatus::Skipped) {
+			report.filesSkipped++;
+			continue;
+		}
+		if (outcome.status == FileStatus::Failed) {
+			report.filesFailed++;
+			if (report.errors.size() < MAX_ERRORS) {
+				report.errors.push_back(outcome.summary.path + ": " + outcome.error);
+			}
+			continue;
+		}
+
+		const FileSummary& summary = outcome.summary;
+		report.filesScanned++;
+		report.bytes += outcome.bytes;
+		report.totalLines += summary.lineCount;
+		report.totalIssues += summary.issueCount;
+		qualitySum += summary.qualityScore;
+		report.qualityHistogram[std::min(summary.qualityScore / 10, 9)]++;
+
+		LanguageTotals& totals = report.languages[summary.language];
+		totals.files++;
+		totals.bytes += outcome.bytes;
+		totals.lines += summary.lineCount;
+		totals.comments += outcome.commentCount;
+		totals.issues += summary.issueCount;
+		languageQuality[summary.language] += summary.qualityScore;
+
+		analyzed.push_back(i);
+	}
+
+	if (report.filesScanned > 0) {
+		report.averageQuality = static_cast<double>(qualitySum) / report.filesScanned;
+	}
+	for (auto& item : report.languages) {
+		item.second.averageQuality = static_cast<double>(languageQuality[item.first]) / item.second.files;
+	}
+
+	// worst files: lowest score, then most issues, then path for a stable order
+	size_t worst = std::min(options_.worstCount, analyzed.size());
+	std::partial_sort(analyzed.begin(), analyzed.begin() + worst, analyzed.end(), [&](size_t a, size_t b) {
+		const FileSummary& left = outcomes[a].summary;
+		const FileSummary& right = outcomes[b].summary;
+		if (left.qualityScore != right.qualityScore) {
+			return left.qualityScore < right.qualityScore;
+		}
+		if (left.issueCount != right.issueCount) {
+			return left.issueCount > right.issueCount;
+		}
+		return left.path < right.path;
+	});
+	for (size_t i = 0; i < worst; ++i) {
+		report.worstFiles.push_back(std::move(outcomes[analyzed[i]].summary));
+	}
+
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+	return report;
+}
+
+}  // namespace code_educator
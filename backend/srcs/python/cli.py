@@ -206,27 +206,91 @@ def analyze(file_path, format, ai, model):
 @click.command()
 @click.argument('file_path', type=click.Path(exists=True))
 @click.option('--threshold', '-t', default=70, help='품질 점수 임계값 (기본: 70)')
-def quality(file_path, threshold):
-    """코드 품질 점수 확인 (CI/CD에서 사용 가능)"""
+@click.option('--details', '-d', is_flag=True, help='실패 시 문제점 목록 출력 (전체 분석 수행)')
+def quality(file_path, threshold, details):
+    """코드 품질 점수 확인 (CI/CD에서 사용 가능, 결과가 확정되면 분석 중단)"""
     try:
-        result = code_service.analyze_file(file_path, False)
-        score = result['quality_score']
-        
-        if score >= threshold:
-            click.echo(click.style(f"✅ 품질 점수: {score}/100 (통과)", fg='green'))
+        result = code_service.check_quality(threshold=threshold, file_path=file_path)
+        score = result['score']
+        # 조기 종료 시 점수는 결과를 확정한 경계값
+        shown = f"{score}/100" if result['complete'] else f"{'≥' if result['passed'] else '≤'}{score}/100"
+
+        if result['passed']:
+            click.echo(click.style(f"✅ 품질 점수: {shown} (통과)", fg='green'))
             sys.exit(0)
         else:
-            click.echo(click.style(f"❌ 품질 점수: {score}/100 (실패, 임계값: {threshold})", fg='red'))
-            if result['potential_issues']:
-                click.echo("\n문제점:")
-                for issue in result['potential_issues']:
-                    click.echo(f"  • {issue}")
+            click.echo(click.style(f"❌ 품질 점수: {shown} (실패, 임계값: {threshold}, "
+                                   f"결정 메트릭: {result['decided_by']})", fg='red'))
+            if details:
+                with open(file_path, 'r', encoding='utf-8', errors='replace') as f:
+                    issues = code_service.quality_report(f.read())['potential_issues']
+                if issues:
+                    click.echo("\n문제점:")
+                    for issue in issues:
+                        click.echo(f"  • {issue}")
             sys.exit(1)
             
     except Exception as e:
         click.echo(click.style(f"오류: {str(e)}", fg='red'))
         sys.exit(1)
 
+# 저장소 전체 분석 명령어
+@click.command()
+@click.argument('directory', type=click.Path(exists=True, file_okay=False))
+@click.option('--ext', '-e', multiple=True, help='분석할 확장자 (여러 번 지정 가능, 예: -e .py -e .cpp)')
+@click.option('--ignore', '-i', multiple=True, help='제외할 glob 패턴 (여러 번 지정 가능)')
+@click.option('--worst', '-w', default=10, help='품질이 낮은 파일 표시 개수 (기본: 10)')
+@click.option('--threads', '-j', default=0, help='사용할 스레드 수 (기본: 전체)')
+@click.option('--top-tokens', '-t', default=0, help='언어별 최다 사용 식별자 표시 개수 (근사치)')
+@click.option('--sketch-dir', type=click.Path(file_okay=False), help='토큰 통계를 누적 저장할 디렉터리 (실행 간 병합)')
+@click.option('--format', '-f', type=click.Choice(['text', 'json']), default='text', help='출력 형식')
+def repo(directory, ext, ignore, worst, threads, top_tokens, sketch_dir, format):
+    """디렉터리 전체를 병렬로 분석하고 집계"""
+    try:
+        result = code_service.analyze_repository(directory, list(ext), list(ignore), worst, threads,
+                                                 top_tokens, sketch_dir)
+
+        if format == 'json':
+            click.echo(json.dumps(result, indent=2, ensure_ascii=False))
+            return
+
+        click.echo(click.style(f"저장소 분석: {result['root']}", fg='blue'))
+        click.echo(f"파일: {result['files_scanned']}개 분석, {result['files_skipped']}개 건너뜀, "
+                   f"{result['files_failed']}개 실패 ({result['seconds']:.2f}초)")
+        click.echo(f"라인 수: {result['total_lines']}, 문제점: {result['total_issues']}, "
+                   f"평균 품질: {result['average_quality']:.1f}/100")
+
+        click.echo("\n언어별:")
+        for name, totals in sorted(result['languages'].items()):
+            click.echo(f"  • {name}: {totals['files']}개 파일, {totals['lines']}줄, "
+                       f"문제점 {totals['issues']}개, 평균 품질 {totals['average_quality']:.1f}")
+
+        click.echo("\n품질 점수 분포:")
+        histogram = result['quality_histogram']
+        peak = max(histogram) if any(histogram) else 1
+        for bucket, count in enumerate(histogram):
+            low = bucket * 10
+            high = 100 if bucket == 9 else low + 9
+            bar = '#' * (count * 40 // peak)
+            click.echo(f"  {low:3d}-{high:3d} | {bar} {count}")
+
+        if result['worst_files']:
+            click.echo("\n품질이 낮은 파일:")
+            for f in result['worst_files']:
+                click.echo(f"  {f['quality_score']:3d}/100  {f['path']} (문제점 {f['issue_count']}개)")
+
+        for name, tokens in sorted(result.get('top_tokens', {}).items()):
+            click.echo(f"\n최다 사용 식별자 ({name}):")
+            for entry in tokens:
+                click.echo(f"  {entry['count']:>10}  {entry['token']}")
+
+        for error in result['errors']:
+            click.echo(click.style(f"  오류: {error}", fg='yellow'))
+
+    except Exception as e:
+        click.echo(click.style(f"오류: {str(e)}", fg='red'))
+        sys.exit(1)
+
 # register commands
 cli.add_command(ask)
 cli.add_command(explain)
@@ -236,6 +300,7 @@ cli.add_command(models)
 cli.add_command(check)
 cli.add_command(analyze)
 cli.add_command(quality)
+cli.add_command(repo)
 
 if __name__ == '__main__':
     cli()
\ No newline at end of file
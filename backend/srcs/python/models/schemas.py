@@ -33,6 +33,7 @@ class AnalyzeRequest(BaseModel):
     language: Optional[str] = Field(None, description="프로그래밍 언어 (자동 감지 가능)")
     ai_analysis: bool = Field(default=False, description="AI 분석 포함 여부")
     model: str = Field(default="codellama", description="AI 분석용 모델")
+    top_tokens: Optional[int] = Field(None, ge=0, description="빈도 상위 N개 토큰 반환 (0: 전체, 생략 시 토큰 빈도 계산 안 함)")
 
 class AnalyzeResponse(BaseModel):
     # 기본 정보
@@ -58,12 +59,81 @@ class AnalyzeResponse(BaseModel):
     
     # 추가 정보
     metadata: Dict[str, Any] = Field(default_factory=dict, description="추가 메타데이터")
+    token_frequency: Optional[Dict[str, int]] = Field(None, description="토큰 빈도 (top_tokens 요청 시)")
     ai_analysis: Optional[str] = Field(None, description="AI 분석 결과")
     
     # 파일 정보 (파일 업로드 시)
     file_path: Optional[str] = Field(None, description="파일 경로")
     file_name: Optional[str] = Field(None, description="파일명")
 
+    # 증분 분석 세션 (세션 API 사용 시)
+    session_id: Optional[str] = Field(None, description="증분 분석 세션 ID")
+
+    # 분석 예산 초과 시 (시간/메모리/취소) 앞부분만 분석한 결과
+    truncated: bool = Field(False, description="분석 예산을 넘어 입력 일부만 분석했는지 여부")
+    truncated_by: Optional[str] = Field(None, description="중단 이유 (deadline, memory, cancelled)")
+
+    # 단계별 트레이스 (?trace=1 요청 시, Chrome / Perfetto trace JSON)
+    trace: Optional[Dict[str, Any]] = Field(None, description="Chrome trace 형식의 분석 단계 스팬")
+
+class SessionOpenRequest(BaseModel):
+    code: str = Field(default="", description="에디터 버퍼 전체 내용")
+    language: Optional[str] = Field(None, description="프로그래밍 언어 (자동 감지 가능)")
+    top_tokens: Optional[int] = Field(None, ge=0, description="빈도 상위 N개 토큰 반환 (0: 전체, 생략 시 토큰 빈도 계산 안 함)")
+
+class SessionEdit(BaseModel):
+    start: int = Field(..., description="바꿀 구간 시작 (UTF-8 바이트 오프셋)")
+    end: int = Field(..., description="바꿀 구간 끝 (UTF-8 바이트 오프셋, 미포함)")
+    text: str = Field(default="", description="새로 들어갈 텍스트")
+
+class SessionEditRequest(BaseModel):
+    edits: List[SessionEdit] = Field(..., description="순서대로 적용할 편집 목록")
+    top_tokens: Optional[int] = Field(None, ge=0, description="빈도 상위 N개 토큰 반환 (0: 전체, 생략 시 토큰 빈도 계산 안 함)")
+
+class RepoAnalyzeRequest(BaseModel):
+    path: str = Field(..., description="분석할 디렉터리 경로 (CODE_EDUCATOR_REPO_ROOT 기준)")
+    extensions: Optional[List[str]] = Field(None, description="분석할 확장자 (예: .py, .cpp)")
+    ignore: Optional[List[str]] = Field(None, description="제외할 glob 패턴")
+    worst: int = Field(default=10, description="품질이 낮은 파일 표시 개수")
+    top_tokens: int = Field(default=0, ge=0, le=1024, description="언어별 최다 사용 식별자 표시 개수 (근사치, 0: 생략)")
+
+class LanguageTotals(BaseModel):
+    files: int = Field(..., description="파일 수")
+    bytes: int = Field(..., description="총 바이트")
+    lines: int = Field(..., description="총 라인 수")
+    comments: int = Field(..., description="총 주석 수")
+    issues: int = Field(..., description="총 문제점 수")
+    average_quality: float = Field(..., description="평균 품질 점수")
+
+class FileSummary(BaseModel):
+    path: str = Field(..., description="저장소 기준 상대 경로")
+    language: str = Field(..., description="감지된 언어")
+    quality_score: int = Field(..., description="품질 점수 (0-100)")
+    line_count: int = Field(..., description="코드 라인 수")
+    cyclomatic_complexity: int = Field(..., description="순환 복잡도")
+    issue_count: int = Field(..., description="문제점 수")
+
+class TokenCount(BaseModel):
+    token: str = Field(..., description="식별자")
+    count: int = Field(..., description="추정 사용 횟수 (상한)")
+    lower_bound: int = Field(..., description="보장된 최소 사용 횟수")
+
+class RepoAnalyzeResponse(BaseModel):
+    root: str = Field(..., description="분석한 디렉터리")
+    files_scanned: int = Field(..., description="분석한 파일 수")
+    files_skipped: int = Field(..., description="크기 제한으로 건너뛴 파일 수")
+    files_failed: int = Field(..., description="읽지 못한 파일/디렉터리 수")
+    bytes: int = Field(..., description="분석한 총 바이트")
+    total_lines: int = Field(..., description="총 라인 수")
+    total_issues: int = Field(..., description="총 문제점 수")
+    average_quality: float = Field(..., description="평균 품질 점수")
+    languages: Dict[str, LanguageTotals] = Field(..., description="언어별 합계")
+    quality_histogram: List[int] = Field(..., description="품질 점수 분포 (10점 단위)")
+    worst_files: List[FileSummary] = Field(..., description="품질이 가장 낮은 파일들")
+    errors: List[str] = Field(default_factory=list, description="오류 목록 (일부)")
+    seconds: float = Field(..., description="분석 소요 시간 (초)")
+    top_tokens: Optional[Dict[str, List[TokenCount]]] = Field(None, description="언어별 최다 사용 식별자 (top_tokens 요청 시)")
+
 class ModelInfo(BaseModel):
     name: str = Field(..., description="모델명")
     size: Optional[str] = Field(None, description="모델 크기")
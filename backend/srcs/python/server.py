@@ -1,9 +1,12 @@
 # srcs/python/server.py
-from fastapi import FastAPI, HTTPException, UploadFile, File, Depends
+from fastapi import FastAPI, HTTPException, UploadFile, File, Depends, Request
 from fastapi.middleware.cors import CORSMiddleware
-from fastapi.responses import StreamingResponse
+from fastapi.responses import StreamingResponse, PlainTextResponse, Response
+from fastapi.concurrency import run_in_threadpool
 import uvicorn
+import asyncio
 import json
+import os
 import io
 from typing import Optional, List
 
@@ -12,6 +15,8 @@ from .services.code_service import CodeAnalysisService
 from .models.schemas import (
     QuestionRequest, QuestionResponse, CodeExplainRequest, CodeGenerateRequest,
     DebugRequest, AnalyzeRequest, AnalyzeResponse, ModelsResponse, HealthResponse,
+    RepoAnalyzeRequest, RepoAnalyzeResponse,
+    SessionOpenRequest, SessionEditRequest,
     ErrorResponse, ModelInfo  # Mpython 제거하고 ModelInfo 추가
 )
 
@@ -166,18 +171,54 @@ async def debug_help(
     except Exception as e:
         raise HTTPException(status_code=500, detail=str(e))
 
+# 클라이언트 연결 확인 주기 (초)
+DISCONNECT_POLL_SECONDS = 0.1
+
+async def run_until_disconnected(http_request: Request, cancel, work):
+    """
+    분석(awaitable)을 기다리고, 그 사이 클라이언트 연결이 끊기면 cancel 핸들로 C++ 분석을 중단
+    """
+    task = asyncio.ensure_future(work)
+    while not task.done():
+        await asyncio.wait({task}, timeout=DISCONNECT_POLL_SECONDS)
+        if cancel is not None and not task.done() and await http_request.is_disconnected():
+            cancel.cancel()
+            break
+    return await task
+
 # 코드 분석 관련 엔드포인트들
 @app.post("/analyze", response_model=AnalyzeResponse)
 async def analyze_code(
     request: AnalyzeRequest,
+    http_request: Request,
+    trace: bool = False,
     code_svc: CodeAnalysisService = Depends(get_code_service)
 ):
-    """코드 텍스트 분석"""
+    """코드 텍스트 분석 (?trace=1 이면 분석 단계 트레이스 포함, 연결이 끊기면 분석 중단)"""
     try:
-        result = code_svc.analyze_code(
-            request.code,
-            request.ai_analysis,
-            request.model
+        cancel = code_svc.cancel_token()
+        if code_svc.has_core and not request.ai_analysis and not trace:
+            # C++ 스레드풀에서 분석하고 코어가 작성한 JSON 바이트를 그대로 응답
+            # (이벤트 루프를 막지 않음, pydantic 재직렬화 생략)
+            body = await run_until_disconnected(
+                http_request, cancel, code_svc.analyze_code_json_async(
+                    request.code,
+                    request.top_tokens,
+                    cancel
+                )
+            )
+            return Response(content=body, media_type="application/json")
+
+        result = await run_until_disconnected(
+            http_request, cancel, run_in_threadpool(
+                code_svc.analyze_code,
+                request.code,
+                request.ai_analysis,
+                request.model,
+                request.top_tokens,
+                trace,
+                cancel
+            )
         )
         return AnalyzeResponse(**result)
     except Exception as e:
@@ -192,6 +233,13 @@ async def analyze_file(
 ):
     """파일 업로드해서 코드 분석"""
     try:
+        if code_svc.has_core and not ai_analysis:
+            # 업로드된 파일을 청크 단위로 C++ 코어에 스트리밍 (큰 파일도 메모리 사용량 일정)
+            chunks = iter(lambda: file.file.read(code_svc.STREAM_CHUNK_BYTES), b"")
+            result = await run_in_threadpool(code_svc.analyze_stream, chunks)
+            result['file_name'] = file.filename
+            return AnalyzeResponse(**result)
+
         # 파일 내용 읽기
         content = await file.read()
         
@@ -207,8 +255,8 @@ async def analyze_file(
                     detail="파일 인코딩을 감지할 수 없습니다. UTF-8 파일을 사용해주세요."
                 )
         
-        # 코드 분석
-        result = code_svc.analyze_code(code, ai_analysis, model)
+        # 코드 분석 (스레드풀에서 실행해 이벤트 루프를 막지 않음)
+        result = await run_in_threadpool(code_svc.analyze_code, code, ai_analysis, model)
         result['file_name'] = file.filename
         
         return AnalyzeResponse(**result)
@@ -217,24 +265,102 @@ async def analyze_file(
     except Exception as e:
         raise HTTPException(status_code=500, detail=str(e))
 
+# 증분 분석 세션: 전체 버퍼 대신 편집 내용만 전송
+@app.post("/analyze/session", response_model=AnalyzeResponse)
+async def open_analysis_session(
+    request: SessionOpenRequest,
+    code_svc: CodeAnalysisService = Depends(get_code_service)
+):
+    """에디터 버퍼에 대한 증분 분석 세션 시작"""
+    if not code_svc.has_core:
+        raise HTTPException(status_code=503, detail="증분 분석에는 C++ 코어 모듈이 필요합니다.")
+    try:
+        result = await run_in_threadpool(code_svc.open_session, request.code, request.language, request.top_tokens)
+        return AnalyzeResponse(**result)
+    except Exception as e:
+        raise HTTPException(status_code=500, detail=str(e))
+
+@app.post("/analyze/session/{session_id}/edit", response_model=AnalyzeResponse)
+async def edit_analysis_session(
+    session_id: str,
+    request: SessionEditRequest,
+    code_svc: CodeAnalysisService = Depends(get_code_service)
+):
+    """세션에 편집을 적용하고 갱신된 분석 결과 반환"""
+    try:
+        result = await run_in_threadpool(code_svc.edit_session, session_id, [
+            {"start": edit.start, "end": edit.end, "text": edit.text} for edit in request.edits
+        ], request.top_tokens)
+        return AnalyzeResponse(**result)
+    except KeyError:
+        raise HTTPException(status_code=404, detail=f"세션을 찾을 수 없습니다: {session_id}")
+    except IndexError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    except Exception as e:
+        raise HTTPException(status_code=500, detail=str(e))
+
+@app.delete("/analyze/session/{session_id}")
+async def close_analysis_session(
+    session_id: str,
+    code_svc: CodeAnalysisService = Depends(get_code_service)
+):
+    """세션 종료"""
+    if not code_svc.close_session(session_id):
+        raise HTTPException(status_code=404, detail=f"세션을 찾을 수 없습니다: {session_id}")
+    return {"closed": session_id}
+
+# 동시에 실행하는 저장소 분석 수 (초과 요청은 대기, 네이티브 스레드 풀을 나눠 씀)
+REPO_SCAN_SLOTS = asyncio.Semaphore(int(os.environ.get("CODE_EDUCATOR_REPO_SCANS", 2)))
+
+@app.post("/analyze/repo", response_model=RepoAnalyzeResponse)
+async def analyze_repository(
+    request: RepoAnalyzeRequest,
+    code_svc: CodeAnalysisService = Depends(get_code_service)
+):
+    """CODE_EDUCATOR_REPO_ROOT 아래 디렉터리 전체를 병렬 분석하고 집계 결과 반환"""
+    if not code_svc.has_core:
+        raise HTTPException(status_code=503, detail="저장소 분석에는 C++ 코어 모듈이 필요합니다.")
+    try:
+        path = code_svc.resolve_repository_path(request.path)
+    except PermissionError as e:
+        raise HTTPException(status_code=403, detail=str(e))
+    if not os.path.isdir(path):
+        raise HTTPException(status_code=404, detail=f"디렉터리를 찾을 수 없습니다: {request.path}")
+    try:
+        # 탐색/분석은 GIL 없이 네이티브 스레드 풀에서 실행, 이벤트 루프는 막지 않음
+        async with REPO_SCAN_SLOTS:
+            result = await run_in_threadpool(
+                code_svc.analyze_repository,
+                path,
+                request.extensions,
+                request.ignore,
+                request.worst,
+                top_tokens=request.top_tokens
+            )
+        return RepoAnalyzeResponse(**result)
+    except Exception as e:
+        raise HTTPException(status_code=500, detail=str(e))
+
 @app.get("/analyze/quality/{threshold}")
 async def check_quality(
     threshold: int,
     code: str,
+    details: bool = False,
     code_svc: CodeAnalysisService = Depends(get_code_service)
 ):
-    """코드 품질 체크 (CI/CD용)"""
+    """코드 품질 체크 (CI/CD용, 통과 여부가 확정되면 분석 중단)"""
     try:
-        result = code_svc.analyze_code(code, False)
-        score = result['quality_score']
-        
-        return {
-            "score": score,
-            "threshold": threshold,
-            "passed": score >= threshold,
-            "issues": result['potential_issues'] if score < threshold else [],
-            "suggestions": result['suggestions'] if score < threshold else []
-        }
+        result = await run_in_threadpool(code_svc.check_quality, code, threshold)
+        result["issues"] = []
+        result["suggestions"] = []
+
+        # 실패 원인 상세는 요청한 경우에만 전체 메트릭으로 계산
+        if details and not result["passed"]:
+            report = await run_in_threadpool(code_svc.quality_report, code)
+            result["issues"] = report['potential_issues']
+            result["suggestions"] = report['suggestions']
+
+        return result
     except Exception as e:
         raise HTTPException(status_code=500, detail=str(e))
 
@@ -251,10 +377,15 @@ async def get_supported_languages(
 
 @app.get("/stats")
 async def get_system_stats(
+    format: str = "json",
     ai_svc: AIService = Depends(get_ai_service),
     code_svc: CodeAnalysisService = Depends(get_code_service)
 ):
-    """시스템 통계 정보"""
+    """시스템 통계 정보 (format=prometheus: 코어 단계별 지연 히스토그램만 텍스트 형식으로)"""
+    if format == "prometheus":
+        return PlainTextResponse(code_svc.core_stats_prometheus(),
+                                 media_type="text/plain; version=0.0.4")
+
     ai_status = ai_svc.check_ai_status()
     analysis_stats = code_svc.get_analysis_stats()
     
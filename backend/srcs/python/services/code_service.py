@@ -1,6 +1,10 @@
 # srcs/python/services/code_service.py
+import json
 import os
-from typing import Dict, List, Optional, Any
+import threading
+import uuid
+from collections import OrderedDict
+from typing import Dict, Iterable, List, Optional, Any
 from ..api import OllamaAPI
 
 # C++ 모듈 가져오기
@@ -12,47 +16,85 @@ except ImportError:
 
 class CodeAnalysisService:
     """코드 분석 관련 비즈니스 로직을 처리하는 서비스"""
+
+    # 동시에 유지하는 편집 세션 수 (초과 시 가장 오래 사용되지 않은 세션 제거)
+    MAX_SESSIONS = 256
+    # 스트리밍 분석 시 한 번에 분석하는 크기
+    STREAM_CHUNK_BYTES = 1 << 20
+    # 저장소 분석 시 언어별로 추적하는 상위 토큰 수 (근사 집계, 메모리 고정)
+    TOKEN_SKETCH_CAPACITY = 1024
+    # 단계별 지연 히스토그램의 Prometheus 버킷 경계 (ns, 64ns ~ 69초, 코어 버킷 경계와 일치)
+    STAGE_BUCKET_BOUNDS_NS = [1 << p for p in range(6, 37)]
     
     def __init__(self):
         self.has_core = HAS_CORE
+        self._sessions = OrderedDict()
+        self._sessions_lock = threading.Lock()
         if self.has_core:
             self.parser = ce.CodeParser()
             self.analyzer = ce.Analyzer()
+            # 같은 코드의 재분석을 피하기 위한 C++ 결과 캐시 (콘텐츠 해시 기준)
+            cache_bytes = int(os.environ.get("CODE_EDUCATOR_CACHE_BYTES", 64 * 1024 * 1024))
+            self.cache = ce.ResultCache(cache_bytes)
+            self.analyzer.set_cache(self.cache)
+            # 워커 프로세스끼리 공유하는 공유 메모리 캐시 (CODE_EDUCATOR_SHARED_CACHE 에 세그먼트 이름 설정 시)
+            # 기본 크기는 Docker 기본 /dev/shm (64MB) 안에 들어가도록 32MB
+            self.shared_cache = None
+            shared_cache_name = os.environ.get("CODE_EDUCATOR_SHARED_CACHE")
+            if shared_cache_name:
+                shared_cache_bytes = int(os.environ.get("CODE_EDUCATOR_SHARED_CACHE_BYTES", 32 * 1024 * 1024))
+                try:
+                    self.shared_cache = ce.SharedCache(shared_cache_name, shared_cache_bytes)
+                    self.analyzer.set_shared_cache(self.shared_cache)
+                except RuntimeError as e:
+                    print(f"공유 캐시 비활성화: {e}")
+            # 재시작과 워커 프로세스 사이에 유지되는 디스크 캐시 (CODE_EDUCATOR_DISK_CACHE_DIR 설정 시)
+            self.disk_cache = None
+            disk_cache_dir = os.environ.get("CODE_EDUCATOR_DISK_CACHE_DIR")
+            if disk_cache_dir:
+                disk_cache_bytes = int(os.environ.get("CODE_EDUCATOR_DISK_CACHE_BYTES", 256 * 1024 * 1024))
+                try:
+                    self.disk_cache = ce.DiskCache(disk_cache_dir, disk_cache_bytes)
+                    self.analyzer.set_disk_cache(self.disk_cache)
+                except RuntimeError as e:
+                    print(f"디스크 캐시 비활성화: {e}")
+            # 단계별 지연 측정 (CODE_EDUCATOR_CORE_STATS=0 이면 끔)
+            ce.set_core_stats_enabled(os.environ.get("CODE_EDUCATOR_CORE_STATS", "1") != "0")
+        # 요청당 분석 예산 (초과 시 부분 결과를 truncated 로 표시해 반환, 0이면 제한 없음)
+        self.time_limit_ms = float(os.environ.get("CODE_EDUCATOR_TIME_LIMIT_MS", 10000))
+        self.memory_limit_bytes = int(os.environ.get("CODE_EDUCATOR_MEMORY_LIMIT_BYTES", 512 * 1024 * 1024))
+        # 저장소 분석을 허용하는 최상위 디렉터리 (설정하지 않으면 저장소 분석 비활성화)
+        repo_root = os.environ.get("CODE_EDUCATOR_REPO_ROOT")
+        self.repo_root = os.path.realpath(repo_root) if repo_root else None
 
     def analyze_code(self, code: str, include_ai: bool = False, 
-                    ai_model: str = "codellama") -> Dict[str, Any]:
+                    ai_model: str = "codellama", top_tokens: Optional[int] = None,
+                    trace: bool = False, cancel=None) -> Dict[str, Any]:
         """
-        코드 분석 실행
+        코드 분석 실행 (top_tokens: 빈도 상위 N개 토큰을 함께 반환, 0이면 전체,
+        trace: 이 요청의 분석 단계 스팬을 Chrome trace JSON으로 함께 반환,
+        cancel: cancel_token() 으로 만든 취소 핸들, 취소되면 부분 결과 반환)
         """
         if not self.has_core:
             return self._basic_analysis(code)
         
         try:
-            # C++ 코어 모듈로 분석
-            structure = self.parser.parse(code)
-            analysis = self.analyzer.analyze(code)
-            quality_score = self.analyzer.calculate_quality(analysis)
-            
-            result = {
-                "language": structure.language,
-                "complexity": structure.complexity,
-                "imports": list(structure.imports),
-                "functions": list(structure.functions),
-                "classes": list(structure.classes),
-                "line_count": analysis.lineCount,
-                "comment_count": analysis.commentCount,
-                "comment_ratio": analysis.commentRatio,
-                "nesting_depth": analysis.nestingLength,
-                "cyclomatic_complexity": analysis.cyclomaticComplexity,
-                "potential_issues": list(analysis.potentialIssues),
-                "suggestions": list(analysis.suggestions),
-                "quality_score": quality_score,
-                "metadata": dict(analysis.metadata)
-            }
-            
+            # C++ 코어 모듈로 분석 (파싱, 분석, 품질 점수를 한 번에, 캐시 사용)
+            if trace:
+                # 현재 스레드의 스팬만 기록되므로 동시 요청은 섞이지 않음
+                with ce.TraceCapture() as capture:
+                    report = self.analyzer.report(code, self._analysis_options(top_tokens, cancel))
+            else:
+                report = self.analyzer.report(code, self._analysis_options(top_tokens, cancel))
+            result = self._report_to_dict(report)
+            if trace:
+                result["trace"] = json.loads(capture.chrome_json())
+            if top_tokens is not None:
+                result["token_frequency"] = dict(report.result.token_frequency)
+
             # AI 분석 추가
             if include_ai:
-                ai_analysis = self._get_ai_analysis(code, structure.language, ai_model)
+                ai_analysis = self._get_ai_analysis(code, result["language"], ai_model)
                 result["ai_analysis"] = ai_analysis
                 
             return result
@@ -60,16 +102,86 @@ class CodeAnalysisService:
         except Exception as e:
             raise Exception(f"코드 분석 중 오류 발생: {str(e)}")
 
+    def analyze_code_json(self, code: str, top_tokens: Optional[int] = None, cancel=None) -> bytes:
+        """
+        analyze_code() 와 같은 응답을 C++ 코어가 바로 UTF-8 JSON 바이트로 작성
+        (결과 객체를 파이썬으로 옮기고 다시 직렬화하는 비용을 건너뜀, AI 분석/트레이스 제외)
+        """
+        try:
+            return self.analyzer.analyze_json(code, self._analysis_options(top_tokens, cancel))
+        except Exception as e:
+            raise Exception(f"코드 분석 중 오류 발생: {str(e)}")
+
+    def analyze_code_json_async(self, code: str, top_tokens: Optional[int] = None, cancel=None):
+        """
+        analyze_code_json() 을 C++ 스레드풀에서 실행하고 바로 asyncio future 를 반환
+        (이벤트 루프 스레드는 분석을 기다리지 않음, 실행 중인 루프 안에서 호출해야 함)
+        """
+        return self.analyzer.analyze_async(code, self._analysis_options(top_tokens, cancel), as_json=True)
+
+    def quality_report(self, code: str) -> Dict[str, Any]:
+        """
+        품질 점수와 그 근거만 계산 (토큰 빈도, 메타데이터 등 나머지 메트릭은 건너뜀)
+        """
+        if not self.has_core:
+            result = self._basic_analysis(code)
+        else:
+            options = ce.AnalysisOptions(token_frequency=False,
+                                         metrics=ce.Metric.QUALITY | ce.Metric.SUGGESTIONS)
+            report = self.analyzer.report(code, options)
+            result = {
+                "quality_score": report.quality_score,
+                "potential_issues": list(report.result.potential_issues),
+                "suggestions": list(report.result.suggestions)
+            }
+        return {key: result[key] for key in ("quality_score", "potential_issues", "suggestions")}
+
+    def check_quality(self, code: Optional[str] = None, threshold: int = 70,
+                      file_path: Optional[str] = None) -> Dict[str, Any]:
+        """
+        품질 게이트: 결과가 확정되는 즉시 분석을 멈추고 통과 여부만 반환
+        (score 는 complete 가 참일 때만 정확한 점수, 아니면 결과를 확정한 경계값)
+        """
+        if not self.has_core:
+            if code is None:
+                with open(file_path, 'r', encoding='utf-8') as f:
+                    code = f.read()
+            score = self.quality_report(code)["quality_score"]
+            return {"score": score, "threshold": threshold, "passed": score >= threshold,
+                    "complete": True, "decided_by": "all"}
+
+        if file_path is not None:
+            check = self.analyzer.check_quality_file(os.fspath(file_path), threshold)
+        else:
+            check = self.analyzer.check_quality(code, threshold)
+        return {
+            "score": check.score,
+            "threshold": check.threshold,
+            "passed": check.passed,
+            "complete": check.complete,
+            "decided_by": check.decided_by
+        }
+
     def analyze_file(self, file_path: str, include_ai: bool = False, 
                     ai_model: str = "codellama") -> Dict[str, Any]:
         """
         파일 분석
         """
         try:
-            with open(file_path, 'r', encoding='utf-8') as f:
-                code = f.read()
-            
-            result = self.analyze_code(code, include_ai, ai_model)
+            if self.has_core:
+                # C++ 코어가 파일을 mmap으로 직접 읽어 분석 (Python 문자열 복사 없음)
+                report = self.analyzer.analyze_file(os.fspath(file_path), self._analysis_options())
+                result = self._report_to_dict(report)
+
+                if include_ai:
+                    with open(file_path, 'r', encoding='utf-8') as f:
+                        code = f.read()
+                    result["ai_analysis"] = self._get_ai_analysis(code, result["language"], ai_model)
+            else:
+                with open(file_path, 'r', encoding='utf-8') as f:
+                    code = f.read()
+                result = self.analyze_code(code, include_ai, ai_model)
+
             result["file_path"] = file_path
             result["file_name"] = os.path.basename(file_path)
             
@@ -78,6 +190,216 @@ class CodeAnalysisService:
         except Exception as e:
             raise Exception(f"파일 분석 중 오류 발생: {str(e)}")
 
+    def analyze_stream(self, chunks: Iterable[bytes], language: Optional[str] = None) -> Dict[str, Any]:
+        """
+        바이트 청크 단위 스트리밍 분석 (입력 전체를 메모리에 올리지 않음)
+        """
+        if not self.has_core:
+            return self.analyze_code(b"".join(chunks).decode("utf-8", errors="replace"))
+
+        try:
+            report = self.analyzer.analyze_stream(chunks, language or "", self.STREAM_CHUNK_BYTES,
+                                                 self._analysis_options())
+            return self._report_to_dict(report)
+        except Exception as e:
+            raise Exception(f"스트리밍 분석 중 오류 발생: {str(e)}")
+
+    def resolve_repository_path(self, path: str) -> str:
+        """
+        요청 경로를 CODE_EDUCATOR_REPO_ROOT 기준으로 해석 (심볼릭 링크를 푼 뒤 루트를 벗어나면 PermissionError)
+        """
+        if self.repo_root is None:
+            raise PermissionError("저장소 분석이 설정되지 않았습니다 (CODE_EDUCATOR_REPO_ROOT)")
+        resolved = os.path.realpath(os.path.join(self.repo_root, path))
+        if os.path.commonpath([self.repo_root, resolved]) != self.repo_root:
+            raise PermissionError(f"허용된 루트 밖의 경로입니다: {path}")
+        return resolved
+
+    def analyze_repository(self, root: str, extensions: Optional[List[str]] = None,
+                           ignore: Optional[List[str]] = None, worst: int = 10,
+                           threads: int = 0, top_tokens: int = 0,
+                           sketch_dir: Optional[str] = None) -> Dict[str, Any]:
+        """
+        디렉터리 전체 분석 (C++ 코어에서 병렬로 탐색/분석 후 집계)
+        top_tokens: 언어별 최다 사용 식별자 수 (근사치)
+        sketch_dir: 언어별 토큰 스케치를 누적 저장할 디렉터리 (이전 실행 결과와 병합)
+        """
+        if not self.has_core:
+            raise Exception("저장소 분석에는 C++ 코어 모듈이 필요합니다.")
+
+        try:
+            options = ce.ScanOptions()
+            if extensions:
+                # ".py" 와 "py" 모두 허용
+                options.extensions = [ext if ext.startswith('.') else '.' + ext for ext in extensions]
+            if ignore:
+                options.ignore = list(options.ignore) + list(ignore)
+            options.worst_count = worst
+            options.threads = threads
+            if top_tokens > 0 or sketch_dir:
+                options.token_sketch_capacity = self.TOKEN_SKETCH_CAPACITY
+
+            scanner = ce.RepositoryScanner(self.analyzer, options)
+            report = scanner.scan(os.fspath(root))
+
+            sketches = report.token_sketches
+            if sketch_dir:
+                sketches = self._accumulate_sketches(sketch_dir, sketches)
+
+            result = {
+                "root": report.root,
+                "files_scanned": report.files_scanned,
+                "files_skipped": report.files_skipped,
+                "files_failed": report.files_failed,
+                "bytes": report.bytes,
+                "total_lines": report.total_lines,
+                "total_issues": report.total_issues,
+                "average_quality": report.average_quality,
+                "languages": {
+                    name: {
+                        "files": totals.files,
+                        "bytes": totals.bytes,
+                        "lines": totals.lines,
+                        "comments": totals.comments,
+                        "issues": totals.issues,
+                        "average_quality": totals.average_quality
+                    }
+                    for name, totals in report.languages.items()
+                },
+                "quality_histogram": list(report.quality_histogram),
+                "worst_files": [
+                    {
+                        "path": f.path,
+                        "language": f.language,
+                        "quality_score": f.quality_score,
+                        "line_count": f.line_count,
+                        "cyclomatic_complexity": f.cyclomatic_complexity,
+                        "issue_count": f.issue_count
+                    }
+                    for f in report.worst_files
+                ],
+                "errors": list(report.errors),
+                "seconds": report.seconds
+            }
+            if top_tokens > 0:
+                result["top_tokens"] = {
+                    name: [
+                        {"token": token, "count": count, "lower_bound": lower_bound}
+                        for token, count, lower_bound in sketch.top(top_tokens)
+                    ]
+                    for name, sketch in sketches.items()
+                }
+            return result
+
+        except Exception as e:
+            raise Exception(f"저장소 분석 중 오류 발생: {str(e)}")
+
+    def _accumulate_sketches(self, sketch_dir: str, sketches: Dict[str, Any]) -> Dict[str, Any]:
+        """언어별 스케치를 디렉터리에 저장된 이전 결과와 병합한 뒤 다시 저장"""
+        os.makedirs(sketch_dir, exist_ok=True)
+        merged = {}
+        names = set(sketches)
+        names.update(f[:-len(".sketch")] for f in os.listdir(sketch_dir) if f.endswith(".sketch"))
+        for name in names:
+            path = os.path.join(sketch_dir, f"{name}.sketch")
+            sketch = ce.TokenSketch.load(path) if os.path.exists(path) else ce.TokenSketch(self.TOKEN_SKETCH_CAPACITY)
+            if name in sketches:
+                sketch.merge(sketches[name])
+                sketch.save(path)
+            merged[name] = sketch
+        return merged
+
+    def open_session(self, code: str, language: Optional[str] = None,
+                     top_tokens: Optional[int] = None) -> Dict[str, Any]:
+        """
+        증분 분석 세션 시작 (에디터 버퍼 하나당 세션 하나)
+        """
+        if not self.has_core:
+            raise Exception("증분 분석에는 C++ 코어 모듈이 필요합니다.")
+
+        session = ce.AnalysisSession(self.analyzer, code, language or "")
+        session_id = uuid.uuid4().hex
+        with self._sessions_lock:
+            self._sessions[session_id] = (session, threading.Lock())
+            while len(self._sessions) > self.MAX_SESSIONS:
+                self._sessions.popitem(last=False)
+
+        result = self._session_report(session, top_tokens)
+        result["session_id"] = session_id
+        return result
+
+    def edit_session(self, session_id: str, edits: List[Dict[str, Any]],
+                     top_tokens: Optional[int] = None) -> Dict[str, Any]:
+        """
+        세션에 편집 적용 후 분석 결과 반환
+        각 편집은 {"start", "end", "text"} 이며 오프셋은 UTF-8 바이트 기준
+        토큰 빈도는 top_tokens를 지정한 경우에만 내보냄 (키 입력마다 전체 맵을 만들지 않도록)
+        """
+        with self._sessions_lock:
+            entry = self._sessions.get(session_id)
+            if entry is None:
+                raise KeyError(session_id)
+            self._sessions.move_to_end(session_id)
+
+        session, lock = entry
+        with lock:
+            for edit in edits:
+                session.edit(edit["start"], edit["end"], edit["text"])
+            result = self._session_report(session, top_tokens)
+        result["session_id"] = session_id
+        return result
+
+    def _session_report(self, session, top_tokens: Optional[int]) -> Dict[str, Any]:
+        """세션 분석 결과 (토큰 빈도는 요청한 경우에만)"""
+        report = session.report(self._analysis_options(top_tokens))
+        result = self._report_to_dict(report)
+        if top_tokens is not None:
+            result["token_frequency"] = dict(report.result.token_frequency)
+        return result
+
+    def close_session(self, session_id: str) -> bool:
+        """세션 종료"""
+        with self._sessions_lock:
+            return self._sessions.pop(session_id, None) is not None
+
+    def cancel_token(self):
+        """진행 중인 분석을 다른 스레드에서 중단하기 위한 핸들 (C++ 코어가 없으면 None)"""
+        return ce.CancelToken() if self.has_core else None
+
+    def _analysis_options(self, top_tokens: Optional[int] = None, cancel=None):
+        """토큰 빈도는 요청한 경우에만 계산 (응답에 수천 개의 식별자 카운트를 싣지 않도록)"""
+        if top_tokens is None:
+            options = ce.AnalysisOptions(token_frequency=False)
+        else:
+            options = ce.AnalysisOptions(token_frequency=True, top_tokens=max(0, top_tokens))
+        options.time_limit_ms = self.time_limit_ms
+        options.memory_limit_bytes = self.memory_limit_bytes
+        options.cancel = cancel
+        return options
+
+    def _report_to_dict(self, report) -> Dict[str, Any]:
+        """C++ AnalysisReport를 응답용 딕셔너리로 변환"""
+        structure = report.structure
+        analysis = report.result
+        return {
+            "language": structure.language,
+            "complexity": structure.complexity,
+            "imports": list(structure.imports),
+            "functions": list(structure.functions),
+            "classes": list(structure.classes),
+            "line_count": analysis.line_count,
+            "comment_count": analysis.comment_count,
+            "comment_ratio": analysis.comment_ratio,
+            "nesting_depth": analysis.nesting_depth,
+            "cyclomatic_complexity": analysis.cyclomatic_complexity,
+            "potential_issues": list(analysis.potential_issues),
+            "suggestions": list(analysis.suggestions),
+            "quality_score": report.quality_score,
+            "metadata": dict(analysis.metadata),
+            "truncated": analysis.truncated,
+            "truncated_by": analysis.truncated_by or None
+        }
+
     def _basic_analysis(self, code: str) -> Dict[str, Any]:
         """
         C++ 모듈이 없을 때 기본 분석
@@ -170,5 +492,66 @@ class CodeAnalysisService:
                 "complexity_calculation": self.has_core,
                 "quality_scoring": self.has_core,
                 "ai_analysis": True
-            }
-        }
\ No newline at end of file
+            },
+            "cache": self.cache.stats() if self.has_core else None,
+            "shared_cache": self.shared_cache.stats() if self.has_core and self.shared_cache else None,
+            "disk_cache": self.disk_cache.stats() if self.has_core and self.disk_cache else None,
+            "simd_kernel": ce.byte_scan_kernel() if self.has_core else None,
+            "core": self.get_core_stats()
+        }
+
+    def get_core_stats(self) -> Optional[Dict[str, Any]]:
+        """
+        C++ 코어의 단계별 지연 히스토그램과 카운터 (Prometheus 형태: 초 단위, 누적 버킷)
+        """
+        if not self.has_core:
+            return None
+        raw = ce.core_stats()
+        durations = []
+        stage_bytes = []
+        quantiles = {}
+        for stage, data in raw["stages"].items():
+            buckets = {}
+            for bound in self.STAGE_BUCKET_BOUNDS_NS:
+                buckets[repr(bound / 1e9)] = sum(count for upper, count in data["buckets"] if upper <= bound)
+            buckets["+Inf"] = data["count"]
+            durations.append({"labels": {"stage": stage}, "buckets": buckets,
+                              "sum": data["total_ns"] / 1e9, "count": data["count"]})
+            stage_bytes.append({"labels": {"stage": stage}, "value": data["bytes"]})
+            quantiles[stage] = {q: data[f"{q}_ns"] / 1e9 for q in ("p50", "p90", "p99")}
+        counters = raw["counters"]
+        return {
+            "enabled": raw["enabled"],
+            "metrics": {
+                "code_educator_stage_duration_seconds": {"type": "histogram", "series": durations},
+                "code_educator_stage_bytes_total": {"type": "counter", "series": stage_bytes},
+                "code_educator_bytes_analyzed_total": {"type": "counter", "series": [
+                    {"labels": {}, "value": counters["bytes_analyzed"]}]},
+                "code_educator_cache_requests_total": {"type": "counter", "series": [
+                    {"labels": {"outcome": "hit"}, "value": counters["cache_hits"]},
+                    {"labels": {"outcome": "shared_hit"}, "value": counters["shared_cache_hits"]},
+                    {"labels": {"outcome": "disk_hit"}, "value": counters["disk_cache_hits"]},
+                    {"labels": {"outcome": "miss"}, "value": counters["cache_misses"]}]}
+            },
+            "quantiles_seconds": quantiles
+        }
+
+    def core_stats_prometheus(self) -> str:
+        """get_core_stats() 를 Prometheus 텍스트 형식으로 변환"""
+        stats = self.get_core_stats()
+        if stats is None:
+            return ""
+        lines = []
+        for name, metric in stats["metrics"].items():
+            lines.append(f"# TYPE {name} {metric['type']}")
+            for series in metric["series"]:
+                labels = ",".join(f'{key}="{value}"' for key, value in series["labels"].items())
+                if metric["type"] == "histogram":
+                    for bound, count in series["buckets"].items():
+                        bucket_labels = f'{labels},le="{bound}"' if labels else f'le="{bound}"'
+                        lines.append(f"{name}_bucket{{{bucket_labels}}} {count}")
+                    lines.append(f"{name}_sum{{{labels}}} {series['sum']}")
+                    lines.append(f"{name}_count{{{labels}}} {series['count']}")
+                else:
+                    lines.append(f"{name}{{{labels}}} {series['value']}" if labels else f"{name} {series['value']}")
+        return "\n".join(lines) + "\n"
\ No newline at end of file
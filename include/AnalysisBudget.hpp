@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace code_educator {
+// Cancel flag shared between the caller and a running analysis. The analysis
+// polls it between windows of input, so a cancel takes effect within one
+// window (tens of microseconds), not instantly.
+class CancelToken {
+public:
+	void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+	bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<bool> cancelled_{false};
+};
+
+// Limits of one analysis call. A call over budget stops reading input and
+// returns what it found so far, flagged as truncated.
+struct AnalysisBudget {
+	uint64_t timeLimitNs = 0;       // wall time from the start of the call (0 = none)
+	size_t memoryLimitBytes = 0;    // token, line and token count tables (0 = none)
+	std::shared_ptr<CancelToken> cancel;
+
+	bool limited() const { return timeLimitNs != 0 || memoryLimitBytes != 0 || cancel; }
+};
+
+// why a call stopped early
+enum class BudgetStop : uint8_t {
+	None,
+	Deadline,
+	Memory,
+	Cancelled
+};
+
+const char* budgetStopName(BudgetStop stop);
+
+// Checks one call against its budget; the deadline starts at construction.
+class BudgetTracker {
+public:
+	explicit BudgetTracker(const AnalysisBudget& budget);
+
+	// true once the call must stop (and stays true); memoryBytes is what the
+	// call holds right now
+	bool exhausted(size_t memoryBytes);
+	BudgetStop stop() const { return stop_; }
+
+private:
+	const AnalysisBudget& budget_;
+	std::chrono::steady_clock::time_point deadline_;
+	BudgetStop stop_ = BudgetStop::None;
+};
+}  // namespace code_educator
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Lexer.hpp"
+#include "TokenCounter.hpp"
+#include <cstddef>
+#include <memory>
+
+namespace code_educator {
+// Working memory an analysis needs only while it runs: the token and line
+// tables (about six bytes per input byte) and the identifier count table.
+struct AnalysisScratch {
+	TokenStream stream;
+	TokenStream piece;    // one window of a windowed (budgeted) analysis
+	TokenCounter tokens;
+
+	// bytes held by the tables
+	size_t capacityBytes() const;
+};
+
+// Scratch kept per thread beyond this is released after the call, so one
+// huge input does not pin its tables to the thread for good.
+constexpr size_t SCRATCH_KEEP_BYTES = 16 * 1024 * 1024;
+// A kept count table is walked whole when counts are exported, so it is
+// kept only while small.
+constexpr size_t SCRATCH_KEEP_COUNTER_BYTES = 1024 * 1024;
+
+// Borrows the calling thread's scratch for one analysis. Tables keep their
+// capacity from one call to the next, so a thread that analyzes inputs of
+// similar size stops allocating for them (and stops mapping and faulting in
+// fresh pages for large inputs). A nested analysis on the same thread gets
+// scratch of its own.
+class ScratchLease {
+public:
+	ScratchLease();
+	~ScratchLease();
+
+	ScratchLease(const ScratchLease&) = delete;
+	ScratchLease& operator=(const ScratchLease&) = delete;
+
+	AnalysisScratch& operator*() const { return *scratch_; }
+	AnalysisScratch* operator->() const { return scratch_; }
+
+private:
+	AnalysisScratch* scratch_;
+	std::unique_ptr<AnalysisScratch> own_;  // set for a nested lease
+};
+}  // namespace code_educator
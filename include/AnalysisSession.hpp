@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Analyzer.hpp"
+#include "Lexer.hpp"
+#include "MetricEngine.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace code_educator {
+// Stateful analysis of one editor buffer. Edits re-lex only the lines they
+// touch: every line keeps the lexer state it starts with, and re-scanning
+// stops at the first line past the edit whose start state is unchanged.
+// Metrics are kept per line and re-evaluated the same way, from the metric
+// carry of the first changed line until the carry matches again.
+//
+// Imports, functions and classes are kept per line as well. An edit finds
+// them again on the re-lexed lines, on the line after them and on the lines
+// up to STRUCTURE_LOOKBACK tokens before them: no match that starts further
+// back reads that far ahead (CodeParser::LOOKAHEAD_TOKENS), so the result
+// equals a full parse.
+//
+// Every method takes the session's lock: threads may share a session, and
+// their edits are applied one at a time.
+class AnalysisSession {
+public:
+	static constexpr size_t STRUCTURE_LOOKBACK = CodeParser::LOOKAHEAD_TOKENS;
+
+	// language: "python", "cpp", "c", "javascript", or empty to detect it
+	AnalysisSession(const Analyzer& analyzer, std::string_view code, const std::string& language = "");
+
+	// replace bytes [start, end) of text() with replacement
+	// throws std::out_of_range for offsets outside the text
+	void edit(size_t start, size_t end, std::string_view replacement);
+
+	// the token frequency is exported only if options.countsTokens()
+	AnalysisResult result(const AnalysisOptions& options = AnalysisOptions()) const;
+	CodeStructure structure() const;
+	AnalysisReport report(const AnalysisOptions& options = AnalysisOptions()) const;
+
+	std::string text() const;
+	Language language() const;
+
+	// lines re-lexed by the last edit (or the initial build)
+	size_t lastRelexedLines() const;
+
+private:
+	// per-line totals of the metrics that add up over lines
+	struct LineMetrics {
+		int lines = 0;
+		int comments = 0;
+		int cyclomatic = 0;  // decision points on the line
+		int nesting = 0;     // deepest nesting reached on the line
+		uint32_t facts = 0;
+	};
+
+	// structure matches starting on a line
+	struct LineStructure {
+		std::vector<std::string> imports;
+		std::vector<std::string> functions;
+		std::vector<std::string> classes;
+		int control = 0;  // control structure complexity
+		int indent = -1;  // leading whitespace, -1 on a blank line
+	};
+
+	struct LineRecord {
+		size_t offset;       // first byte of the line
+		LexState state;      // lexer state at the line start
+		size_t firstToken;   // index of the line's first token
+		MetricCarry carry;   // metric state at the line start
+		LineMetrics metrics;
+		LineStructure structure;
+	};
+
+	void rebuild();
+	size_t relex(size_t first, size_t editStart, size_t editEnd, std::ptrdiff_t delta, const std::string& removed);
+	void remeasure(size_t first, size_t relexedEnd);
+	void restructure(size_t first, size_t end);
+	void countToken(int step);  // adjust the count of key_
+	void account(const LineMetrics& metrics, int step);
+	void account(const LineStructure& structure, int step);
+	size_t lineOf(size_t offset) const;
+	size_t lineOfToken(size_t token) const;
+
+	// with mutex_ held
+	const CodeStructure& currentStructure() const;
+	AnalysisResult currentResult(const AnalysisOptions& options) const;
+
+	const Analyzer& analyzer_;
+	Language language_;
+	bool detect_;              // language still unknown: detect again after edits
+	std::string text_;
+	TokenStream stream_;       // equal to Lexer(language_).tokenize(text_)
+	std::vector<LineRecord> records_;  // one per line start, including a final empty line
+	// running totals over every line
+	long lines_ = 0;
+	long comments_ = 0;
+	long cyclomatic_ = 0;
+	std::vector<int> nestingCounts_;  // lines per deepest nesting level
+	int factCounts_[32] = {};         // lines per CodeFact bit
+	long control_ = 0;                // control structure complexity
+	std::vector<int> indentCounts_;   // non-blank lines per leading whitespace
+	TokenCounter frequency_;
+	std::string key_;
+	size_t lastRelexed_ = 0;
+
+	mutable std::mutex mutex_;
+	mutable bool structureValid_ = false;
+	mutable CodeStructure structure_;  // the per-line matches joined
+};
+}  // namespace code_educator
@@ -1,56 +1,197 @@
 #pragma once
 
+#include "AnalysisBudget.hpp"
+#include "AnalysisScratch.hpp"
 #include "CodeParser.hpp"
+#include "MetricEngine.hpp"
+#include "ResultCache.hpp"
+#include "TokenSketch.hpp"
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <set>
 #include <unordered_map>
+#include <stdexcept>
 
 namespace code_educator {
+class DiskCache;
+class SharedCache;
+
+// Bump whenever a change alters analysis output: cached results are keyed by
+// this version and stop matching.
+constexpr uint32_t ANALYZER_VERSION = 2;
+
 struct AnalysisResult {
-	int lineCount;
-	int commentCount;
-	double commentRatio; // (comment / code)
-	int nestingLength;
-	int cyclomaticComplexity;
+	int lineCount = 0;
+	int commentCount = 0;
+	double commentRatio = 0.0; // (comment / code)
+	int nestingLength = 0;
+	int cyclomaticComplexity = 0;
 	std::map<std::string, int> tokenFrequency;
 	std::vector<std::string> potentialIssues;
 	std::vector<std::string> suggestions;
 
+	// set when an analysis budget ran out: the metrics above cover only the
+	// first bytesAnalyzed bytes
+	bool truncated = false;
+	std::string truncatedBy;    // "deadline", "memory" or "cancelled"
+	size_t bytesAnalyzed = 0;
 
 	std::map<std::string, std::string> metadata; // e.g., {"author": "John Doe", "date": "2023-10-01"}
 };
 
+// Metrics an analysis fills in. Fields of metrics that were not requested
+// are left empty (zero) and the passes behind them are skipped.
+enum MetricMask : uint32_t {
+	METRIC_LINES = 1 << 0,        // lineCount
+	METRIC_COMMENTS = 1 << 1,     // commentCount, commentRatio
+	METRIC_NESTING = 1 << 2,      // nestingLength
+	METRIC_CYCLOMATIC = 1 << 3,   // cyclomaticComplexity
+	METRIC_TOKENS = 1 << 4,       // tokenFrequency
+	METRIC_ISSUES = 1 << 5,       // potentialIssues
+	METRIC_SUGGESTIONS = 1 << 6,  // suggestions
+	METRIC_STRUCTURE = 1 << 7,    // imports, functions, classes, complexity, metadata
+	METRIC_ALL = (1 << 8) - 1,
+	// what calculateQuality() reads
+	METRIC_QUALITY = METRIC_LINES | METRIC_COMMENTS | METRIC_NESTING | METRIC_CYCLOMATIC | METRIC_ISSUES
+};
+
+// What an analysis returns beyond the core metrics. Token frequency is the
+// only per-identifier work: skipping it or keeping only the top tokens keeps
+// results small for callers that never read the full table.
+struct AnalysisOptions {
+	bool tokenFrequency = true;  // count identifiers at all
+	size_t topTokens = 0;        // keep only the most frequent identifiers (0 = all)
+	uint32_t metrics = METRIC_ALL;
+	std::string fileName;        // its extension hints the language (may be empty)
+	AnalysisBudget budget;       // time, memory and cancellation (not part of the cache key)
+
+	bool wants(uint32_t mask) const { return (metrics & mask) != 0; }
+	bool countsTokens() const { return tokenFrequency && wants(METRIC_TOKENS); }
+	// suggestions are built from the structure as well
+	bool needsStructure() const { return wants(METRIC_STRUCTURE | METRIC_SUGGESTIONS); }
+};
+
+// the inputs of the quality score, cheaper to get than a full result
+struct QualityInputs {
+	int cyclomaticComplexity = 0;
+	double commentRatio = 0.0;
+	int nestingLength = 0;
+	size_t issueCount = 0;
+};
+
+// Outcome of a quality gate. Metrics are computed cheapest first and the
+// check stops once the outcome is certain, so the score is exact only when
+// complete; otherwise it is the bound that settled the outcome (an upper
+// bound below the threshold for a failure, a lower bound for a pass).
+struct QualityCheck {
+	bool passed = false;
+	int score = 0;
+	int threshold = 0;
+	bool complete = false;      // every metric was computed
+	// what settled it: "threshold" (no metric needed), "code_length",
+	// "cyclomatic_complexity", "nesting_depth", "potential_issues",
+	// "comment_ratio", or "all" for a pass that needed every metric
+	std::string decidedBy;
+	size_t bytesAnalyzed = 0;   // input read before the outcome was certain
+};
+
+// structure, metrics and quality score of one input, computed together
+struct AnalysisReport {
+	CodeStructure structure;
+	AnalysisResult result;
+	int qualityScore = 0;
+	bool cached = false;  // served from the result cache
+};
+
 
+// Analyzer keeps no per-call state: one instance can be shared by any number
+// of threads. An attached ResultCache is shared and thread-safe as well.
 class Analyzer {
 	public:
 		// Constructor and destructor
 		Analyzer();
 		virtual ~Analyzer();
 
-		AnalysisResult analyze(const std::string& code);
-		AnalysisResult analyzeWithSturcture(const std::string& code, const CodeStructure& structure);
+		AnalysisResult analyze(std::string_view code, const AnalysisOptions& options = AnalysisOptions()) const;
+		// parse, analyze and score in one call, reusing cached reports
+		AnalysisReport report(std::string_view code, const AnalysisOptions& options = AnalysisOptions()) const;
+
+		// report() on a memory-mapped file, analyzed in place
+		AnalysisReport analyzeFile(const std::string& path, const AnalysisOptions& options = AnalysisOptions()) const;
+
+		// add the identifiers of code to an approximate token sketch (the ones
+		// tokenFrequency counts); language as in CodeStructure, empty to detect
+		void sketchTokens(std::string_view code, TokenSketch& sketch, const std::string& language = "") const;
+
+		AnalysisResult analyzeWithSturcture(std::string_view code, const CodeStructure& structure) const;
+
+		// analyze every input on the shared thread pool (threads = 0: all workers)
+		std::vector<AnalysisResult> analyzeBatch(const std::vector<std::string_view>& codes, size_t threads = 0,
+			const AnalysisOptions& options = AnalysisOptions()) const;
+
+		// build a result from counters computed elsewhere (sessions, streams)
+		AnalysisResult resultFromMetrics(size_t codeLength, const CodeStructure& structure, Language language, const MetricCounters& metrics,
+			const AnalysisOptions& options = AnalysisOptions()) const;
+
+		const CodeParser& codeParser() const { return parser; }
 
 		// Calculate the quality of the code based on various metrics
 		// 0 to 100
-		int calculateQuality(const AnalysisResult& result);
+		int calculateQuality(const AnalysisResult& result) const;
+		int calculateQuality(const QualityInputs& inputs) const;
+
+		// pass/fail against a threshold, stopping as soon as the outcome is
+		// certain; a complete check scores like report()
+		QualityCheck checkQuality(std::string_view code, int threshold, std::string_view fileName = std::string_view()) const;
+		// checkQuality() on a memory-mapped file
+		QualityCheck checkQualityFile(const std::string& path, int threshold) const;
 
-		std::vector<std::string> generateSuggestions(const std::string& code, const CodeStructure& structure);
+		// score inputs straight from metric counters (issues are counted, not written out)
+		QualityInputs qualityInputs(size_t codeLength, Language language, const MetricCounters& metrics) const;
 
-		AnalysisResult analyzePython(const std::string& code);
-		AnalysisResult analyzeJavaScript(const std::string& code);
-		AnalysisResult analyzeCpp(const std::string& code);
-		AnalysisResult analyzeC(const std::string& code);
+		std::vector<std::string> generateSuggestions(std::string_view code, const CodeStructure& structure) const;
+
+		AnalysisResult analyzePython(std::string_view code) const;
+		AnalysisResult analyzeJavaScript(std::string_view code) const;
+		AnalysisResult analyzeCpp(std::string_view code) const;
+		AnalysisResult analyzeC(std::string_view code) const;
+
+		// attach a cache for report() (nullptr disables caching)
+		// Not synchronized with running analyses: set it up before sharing.
+		void setCache(std::shared_ptr<ResultCache> cache);
+		std::shared_ptr<ResultCache> cache() const { return cache_; }
+
+		// attach a persistent cache for report(), consulted after the memory
+		// cache (nullptr disables it); same rules as setCache()
+		void setDiskCache(std::shared_ptr<DiskCache> cache);
+		std::shared_ptr<DiskCache> diskCache() const { return diskCache_; }
+
+		// attach a cache shared with other processes, consulted after the
+		// memory cache and before the disk cache (nullptr disables it)
+		void setSharedCache(std::shared_ptr<SharedCache> cache);
+		std::shared_ptr<SharedCache> sharedCache() const { return sharedCache_; }
 
 	private:
-		int countLines(const std::string& code);
-		int countComments(const std::string& code, const std::string& language);
-		int calculateNestingLength(const std::string& code, const std::string& language);
-		int calculateCyclomaticComplexity(const std::string& code, const std::string& language);
-		std::map<std::string, int> calculateTokenFrequency(const std::string& code);
-		std::vector<std::string> findPotentialIssues(const std::string& code, const std::string& language);
+		AnalysisReport computeReport(std::string_view code, const AnalysisOptions& options) const;
+		// computeReport() a window at a time, stopping when the budget runs out
+		AnalysisReport reportWithinBudget(std::string_view code, const AnalysisOptions& options) const;
+
+		// tokenize code and extract its structure when the options need it
+		CodeStructure tokenizeAndParse(std::string_view code, TokenStream& stream, const AnalysisOptions& options) const;
+
+		// every metric from one token stream, in a single pass (counting
+		// identifiers into counts when given, to reuse its table)
+		AnalysisResult analyzeTokens(std::string_view code, const CodeStructure& structure, const TokenStream& stream,
+			const AnalysisOptions& options = AnalysisOptions(), TokenCounter* counts = nullptr) const;
+		std::vector<std::string> findPotentialIssues(size_t codeLength, Language language, const MetricCounters& metrics) const;
+		std::vector<std::string> suggestionsFor(const CodeStructure& structure, const MetricCounters& metrics) const;
 
 		CodeParser parser;  // instance of CodeParser to parse the code
+		std::shared_ptr<ResultCache> cache_;
+		std::shared_ptr<DiskCache> diskCache_;
+		std::shared_ptr<SharedCache> sharedCache_;
 };
 }   // namespace code_educator
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Analyzer.hpp"
+#include "Lexer.hpp"
+#include "MetricEngine.hpp"
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace code_educator {
+// Analysis of an input fed in chunks, for files too large to hold at once.
+// Bytes are lexed a window at a time and the lexer state, metric carry and a
+// short token tail for structure lookahead are carried to the next window, so
+// the working memory stays O(chunk size + distinct identifiers) however long
+// the input. The import, function and class lists are output and grow with
+// the number of matches.
+//
+// The report equals Analyzer::report() of the concatenated input, except that
+// the language (when not given) is detected from the first window only, and
+// structure matches are looked ahead at most TAIL_TOKENS tokens across a
+// window boundary.
+//
+// A stream analyzes one input. Every method takes the stream's lock, so
+// threads may share one; each feed() is applied whole, in the order the
+// calls take the lock.
+class AnalyzerStream {
+public:
+	static constexpr size_t DEFAULT_CHUNK_BYTES = 1 << 20;
+	static constexpr size_t TAIL_TOKENS = 256;
+
+	// language: "python", "cpp", "c", "javascript", or empty to detect it
+	AnalyzerStream(const Analyzer& analyzer, const std::string& language = "", size_t chunkBytes = DEFAULT_CHUNK_BYTES,
+		const AnalysisOptions& options = AnalysisOptions());
+
+	// append the next bytes of the input
+	// throws std::logic_error after finish()
+	void feed(std::string_view chunk);
+
+	// analyze the rest of the input and return the report of all of it
+	AnalysisReport finish();
+
+	size_t bytesFed() const;
+	Language language() const;
+
+private:
+	void process(size_t end, bool last);
+
+	mutable std::mutex mutex_;
+	const Analyzer& analyzer_;
+	AnalysisOptions options_;
+	size_t chunkBytes_;
+	bool detect_;
+	bool finished_ = false;
+	Language language_ = Language::Unknown;
+	Lexer lexer_;
+	MetricEngine engine_;
+	LexState state_;
+
+	// buffer_ holds the bytes of the held tokens followed by input not yet
+	// lexed (from lexed_ on); token offsets point into it
+	std::string buffer_;
+	size_t lexed_ = 0;
+	size_t searched_ = 0; // pending bytes before this hold no cut point
+	TokenStream window_;  // held tail tokens, then the tokens of the window
+	TokenStream piece_;   // tokens and lines of the latest scan
+
+	size_t total_ = 0;    // bytes fed
+	int maxIndent_ = 0;   // deepest leading whitespace of a non-blank line
+	int control_ = 0;     // control structure complexity so far
+	CodeStructure structure_;
+};
+}  // namespace code_educator
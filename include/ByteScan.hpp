@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+namespace code_educator {
+// A small set of bytes searched for together (at most four), e.g. the bytes
+// that can end a string literal: quote, backslash and newline.
+struct ByteSet {
+	char bytes[4] = {};
+	uint8_t size = 0;
+
+	ByteSet(std::initializer_list<char> list) {
+		for (char c : list) {
+			if (size < 4) {
+				bytes[size++] = c;
+			}
+		}
+	}
+
+	bool contains(char c) const {
+		for (uint8_t i = 0; i < size; ++i) {
+			if (bytes[i] == c) {
+				return true;
+			}
+		}
+		return false;
+	}
+};
+
+// First byte of [p, end) that is in set, or end. Long spans are compared a
+// vector at a time (AVX2 or SSE2, picked once for the running CPU); spans
+// shorter than one vector are scanned byte by byte.
+// The lexer uses it only to skip the inside of string literals, comments and
+// preprocessor directives; identifiers, numbers and whitespace in code are
+// still lexed a byte at a time.
+const char* findFirstOf(const char* p, const char* end, const ByteSet& set);
+
+// kernel in use: "avx2", "sse2" or "scalar"
+const char* byteScanKernel();
+}  // namespace code_educator
@@ -1,11 +1,15 @@
 #pragma once
 
-#include <regex>
 #include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
+#include "AnalysisBudget.hpp"
+#include "LanguageDetector.hpp"
+#include "Lexer.hpp"
 
 namespace code_educator {
 // structure to hold code structure information
@@ -21,31 +25,82 @@ struct CodeStructure {
 };
 
 
+// CodeParser keeps no per-call state: one instance can be shared by any
+// number of threads.
 class CodeParser {
 public:
+	// A match reads at most this many tokens from where it starts, so one
+	// unclosed parenthesis cannot make every later candidate scan to the end
+	// of the input; longer parameter lists are not matched.
+	static constexpr size_t LOOKAHEAD_TOKENS = 256;
+
 	CodeParser();
 
 	virtual ~CodeParser();
 
-	CodeStructure parse(const std::string& code);
+	CodeStructure parse(std::string_view code) const;
+
+	// parse and keep the token stream for further analysis; the extension of
+	// fileName (may be empty) counts toward the detected language
+	CodeStructure parse(std::string_view code, TokenStream& stream, std::string_view fileName = std::string_view()) const;
+
+	// build the structure from an already tokenized buffer
+	CodeStructure parseTokens(std::string_view code, const TokenStream& stream) const;
+
+	// parseTokens() for languages with structure extraction, "unknown" otherwise
+	CodeStructure structureOf(std::string_view code, const TokenStream& stream) const;
+
+	// structureOf() a window of tokens at a time, checking the budget before
+	// each one; once it runs out the structure covers the windows done so far
+	CodeStructure structureOf(std::string_view code, const TokenStream& stream, BudgetTracker& tracker,
+		size_t memoryBytes) const;
+
+	// Structure of a long input walked window by window (AnalyzerStream).
+	// Appends the matches that start before token `limit` and returns their
+	// control structure complexity; later tokens are only read as lookahead.
+	int appendStructure(std::string_view code, const TokenStream& stream, size_t limit, CodeStructure& structure) const;
+	// the same for the matches that start at tokens [begin, end) (AnalysisSession)
+	int appendStructure(std::string_view code, const TokenStream& stream, size_t begin, size_t end,
+		CodeStructure& structure) const;
 
-	std::string detectLanguage(const std::string& code);
+	// languages with structure extraction (the others parse as "unknown")
+	static bool hasStructure(Language language);
 
-	int calculateComplexity(const std::string& code, const std::string& language);
+	// parse every input on the shared thread pool (threads = 0: all workers)
+	std::vector<CodeStructure> parseBatch(const std::vector<std::string_view>& codes, size_t threads = 0) const;
 
-	std::vector<std::string> extractImports(const std::string& code, const std::string& language);
+	// language name ("unknown" without enough evidence) from a bounded prefix
+	std::string detectLanguage(std::string_view code, std::string_view fileName = std::string_view()) const;
 
-	std::vector<std::string> extractFunctions(const std::string& code, const std::string& language);
+	// detectLanguage() with its confidence
+	LanguageGuess guessLanguage(std::string_view code, std::string_view fileName = std::string_view()) const;
 
-	std::vector<std::string> extractClasses(const std::string& code, const std::string& language);
+	const LanguageDetector& languageDetector() const { return detector_; }
+
+	int calculateComplexity(std::string_view code, const std::string& language) const;
+
+	std::vector<std::string> extractImports(std::string_view code, const std::string& language) const;
+
+	std::vector<std::string> extractFunctions(std::string_view code, const std::string& language) const;
+
+	std::vector<std::string> extractClasses(std::string_view code, const std::string& language) const;
 
 private:
-	CodeStructure parsePython(const std::string& code);
+	CodeStructure parsePython(std::string_view code) const;
+
+	CodeStructure parseCpp(std::string_view code) const;
+
+	CodeStructure parseJavaScript(std::string_view code) const;
 
-	CodeStructure parseCpp(const std::string& code);
+	CodeStructure parseC(std::string_view code) const;
 
-	CodeStructure parseJavaScript(const std::string& code);
+	int complexityOf(std::string_view code, const TokenStream& stream) const;
+	int controlComplexityOf(std::string_view code, const TokenStream& stream, size_t begin, size_t limit) const;
+	// matches starting at tokens [begin, limit)
+	std::vector<std::string> importsOf(std::string_view code, const TokenStream& stream, size_t begin, size_t limit) const;
+	std::vector<std::string> functionsOf(std::string_view code, const TokenStream& stream, size_t begin, size_t limit) const;
+	std::vector<std::string> classesOf(std::string_view code, const TokenStream& stream, size_t begin, size_t limit) const;
 
-	CodeStructure parseC(const std::string &code);
+	LanguageDetector detector_;
 };
 }  // namespace code_educator
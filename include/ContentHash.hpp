@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace code_educator {
+// 128-bit content fingerprint used to key cached results
+struct Hash128 {
+	uint64_t low = 0;
+	uint64_t high = 0;
+
+	bool operator==(const Hash128& other) const {
+		return low == other.low && high == other.high;
+	}
+	bool operator!=(const Hash128& other) const {
+		return !(*this == other);
+	}
+
+	std::string hex() const;
+};
+
+// MurmurHash3 x64 128-bit: fast, well distributed, non-cryptographic
+Hash128 hashContent(const void* data, size_t size, uint64_t seed = 0);
+
+inline Hash128 hashContent(std::string_view text, uint64_t seed = 0) {
+	return hashContent(text.data(), text.size(), seed);
+}
+
+struct Hash128Hasher {
+	size_t operator()(const Hash128& hash) const {
+		return static_cast<size_t>(hash.low ^ (hash.high * 0x9e3779b97f4a7c15ULL));
+	}
+};
+}  // namespace code_educator
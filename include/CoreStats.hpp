@@ -0,0 +1,119 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Trace.hpp"
+
+namespace code_educator {
+// stages of an analysis, each with its own latency histogram
+enum class Stage : uint8_t {
+	DetectLanguage,
+	Lex,
+	Parse,        // CodeParser::parse, end to end
+	Structure,    // imports, functions and classes from the tokens
+	Metrics,      // the fused MetricEngine pass
+	TokenTable,   // token frequency output (top-K)
+	Issues,
+	Suggestions,
+	QualityGate,  // Analyzer::checkQuality
+	Analyze,      // Analyzer::analyze, end to end
+	Report,       // Analyzer::report, end to end (cache hits included)
+	Binding,      // C++ results converted to Python objects
+	COUNT
+};
+
+enum class Counter : uint8_t {
+	BytesAnalyzed,    // input run through analyze() or a computed report()
+	CacheHits,        // report() served from the memory cache
+	CacheMisses,      // report() computed (missed every attached cache)
+	SharedCacheHits,  // report() served from the cache shared by processes
+	DiskCacheHits,    // report() served from the disk cache
+	COUNT
+};
+
+const char* stageName(Stage stage);
+const char* counterName(Counter counter);
+
+// Log-linear latency buckets: below 4 ns one bucket per nanosecond, above
+// that every power of two is split into 4 equal buckets, up to 2^41 ns.
+constexpr size_t HISTOGRAM_BUCKETS = 160;
+
+size_t histogramBucket(uint64_t ns);
+// first nanosecond value past bucket index
+uint64_t histogramUpperBound(size_t index);
+
+struct StageStats {
+	uint64_t count = 0;
+	uint64_t totalNs = 0;
+	uint64_t bytes = 0;
+	std::vector<uint64_t> buckets = std::vector<uint64_t>(HISTOGRAM_BUCKETS);
+
+	// upper bound of the bucket holding quantile q (0 to 1), 0 when empty
+	uint64_t quantileNs(double q) const;
+};
+
+struct CoreStats {
+	bool enabled = false;
+	StageStats stages[static_cast<size_t>(Stage::COUNT)];
+	uint64_t counters[static_cast<size_t>(Counter::COUNT)] = {};
+
+	const StageStats& stage(Stage s) const { return stages[static_cast<size_t>(s)]; }
+	uint64_t counter(Counter c) const { return counters[static_cast<size_t>(c)]; }
+};
+
+// Process-wide counters, kept per thread so recording never contends: each
+// thread only writes its own slots, and a snapshot sums every thread (and the
+// threads that already exited).
+CoreStats coreStats();
+// counts from now on (earlier ones are hidden from later snapshots)
+void resetCoreStats();
+void setCoreStatsEnabled(bool enabled);
+bool coreStatsEnabled();
+
+void recordStage(Stage stage, uint64_t ns, uint64_t bytes = 0);
+void addCounter(Counter counter, uint64_t amount = 1);
+
+// Records the time from construction to destruction under a stage, and a
+// trace span when tracing is on for this thread. Costs two clock reads when
+// either is on and nothing else when both are off.
+class StageTimer {
+public:
+	explicit StageTimer(Stage stage, size_t bytes = 0)
+		: stage_(stage), bytes_(bytes), stats_(coreStatsEnabled()), trace_(tracingActive()) {
+		if (trace_) {
+			depth_ = traceEnter();
+		}
+		if (stats_ || trace_) {
+			start_ = std::chrono::steady_clock::now();
+		}
+	}
+	~StageTimer() {
+		if (!stats_ && !trace_) {
+			return;
+		}
+		auto elapsed = std::chrono::steady_clock::now() - start_;
+		uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+		if (stats_) {
+			recordStage(stage_, ns, bytes_);
+		}
+		if (trace_) {
+			uint64_t startNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				start_.time_since_epoch()).count());
+			traceLeave(stageName(stage_), startNs, ns, bytes_, depth_);
+		}
+	}
+
+	StageTimer(const StageTimer&) = delete;
+	StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+	Stage stage_;
+	size_t bytes_;
+	bool stats_;
+	bool trace_;
+	uint32_t depth_ = 0;
+	std::chrono::steady_clock::time_point start_;
+};
+}  // namespace code_educator
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "ResultCache.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+namespace code_educator {
+struct AnalysisReport;
+
+struct DiskCacheOptions {
+	size_t maxBytes = 256 * 1024 * 1024;  // log size that triggers a compaction
+	bool sync = false;                     // fdatasync every append (survives power loss, not only crashes)
+};
+
+struct DiskCacheStats {
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t insertions = 0;
+	uint64_t compactions = 0;
+	uint64_t errors = 0;      // failed reads and writes, treated as misses
+	size_t entries = 0;
+	size_t logBytes = 0;
+	size_t capacityBytes = 0;
+	uint32_t generation = 0;  // bumped by every compaction
+};
+
+// Analysis reports persisted in a directory, shared by every process that
+// opens it and kept across restarts.
+//
+// The directory holds an append-only log of records (a checksummed header
+// with the cache key, then the report as a result snapshot) and an index:
+// an open-addressing hash table from cache key to log offset, memory-mapped
+// shared by all processes. Opening maps the index and nothing else.
+//
+// Lookups take no lock: a slot is published only after its record is
+// written, and every record is checked against the key and checksum before
+// use, so a torn or stale slot is just a miss. Writers take an exclusive
+// file lock. When the log grows past maxBytes, the most recently used
+// records are copied to a new log generation under a fresh index that is
+// renamed into place; readers holding the old index see it marked stale and
+// reopen.
+class DiskCache {
+public:
+	// throws std::runtime_error if the directory cannot be created or opened
+	explicit DiskCache(const std::string& directory, const DiskCacheOptions& options = DiskCacheOptions());
+	~DiskCache();
+
+	DiskCache(const DiskCache&) = delete;
+	DiskCache& operator=(const DiskCache&) = delete;
+
+	// nullptr on a miss
+	std::shared_ptr<AnalysisReport> find(const CacheKey& key);
+	// store a report (no-op if the key is present); false if it was not written
+	bool insert(const CacheKey& key, const AnalysisReport& report);
+
+	// rewrite the log keeping only the most recently used records that fit
+	// in half of maxBytes
+	void compact();
+	// drop every record (counters are kept)
+	void clear();
+
+	DiskCacheStats stats() const;
+	const std::string& directory() const { return directory_; }
+	size_t capacity() const { return options_.maxBytes; }
+
+private:
+	struct Mapping;
+
+	// reopen the index and log if another process replaced them
+	std::shared_ptr<Mapping> current();
+	std::shared_ptr<Mapping> openMapping() const;
+	void reopen();
+
+	// with the writer lock held
+	bool append(Mapping& mapping, const CacheKey& key, const std::string& payload);
+	void rebuild(Mapping& mapping, size_t slotCount, size_t keepBytes);
+
+	std::string directory_;
+	DiskCacheOptions options_;
+	int lockFd_ = -1;
+
+	mutable std::shared_mutex mappingMutex_;
+	std::shared_ptr<Mapping> mapping_;
+	std::mutex writerMutex_;  // the file lock does not exclude threads of one process
+
+	std::atomic<uint64_t> hits_{0};
+	std::atomic<uint64_t> misses_{0};
+	std::atomic<uint64_t> insertions_{0};
+	std::atomic<uint64_t> compactions_{0};
+	std::atomic<uint64_t> errors_{0};
+};
+}  // namespace code_educator
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Lexer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace code_educator {
+struct LanguageGuess {
+	Language language = Language::Unknown;
+	double confidence = 0.0;  // 0 to 1: share and amount of evidence for the winner
+	size_t bytesScanned = 0;  // prefix read before the guess was settled
+};
+
+// Scores language features (keywords, operators, line endings) in one pass
+// over a bounded prefix of the input, so detection costs the same for any
+// input size. Scanning stops early once one language clearly dominates. A
+// known file extension counts as evidence too, and content can overrule it.
+//
+// The detector keeps no per-call state: one instance can be shared by any
+// number of threads.
+class LanguageDetector {
+public:
+	static constexpr size_t DEFAULT_PREFIX_BYTES = 16 * 1024;
+
+	explicit LanguageDetector(size_t prefixBytes = DEFAULT_PREFIX_BYTES);
+
+	// fileName: path or name whose extension hints the language (may be empty)
+	LanguageGuess detect(std::string_view code, std::string_view fileName = std::string_view()) const;
+
+	// language a file extension stands for (".h" counts as C and C++, so Unknown)
+	static Language extensionHint(std::string_view fileName);
+	// which extension prior detect() applies for fileName (0: none), for cache keys
+	static uint32_t extensionId(std::string_view fileName);
+
+	size_t prefixBytes() const { return prefixBytes_; }
+
+private:
+	size_t prefixBytes_;
+};
+}  // namespace code_educator
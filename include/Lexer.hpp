@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace code_educator {
+// languages understood by the lexer
+enum class Language : uint8_t {
+	Unknown,
+	Python,
+	C,
+	Cpp,
+	JavaScript
+};
+
+Language languageFromName(const std::string& name);
+const char* languageName(Language language);
+
+enum class TokenType : uint8_t {
+	Identifier,   // names and keywords
+	Number,
+	String,       // string, char, template and regex literals
+	Comment,
+	Directive,    // C/C++ preprocessor line
+	Punct         // operators and delimiters
+};
+
+// identifiers the parser and analyzer look for
+enum class Keyword : uint8_t {
+	None,
+	If, Elif, Else, For, While, Do, Switch, Case, Try, Catch, Except, Goto,
+	Return, New, Delete, Throw, Sizeof, And, Or,
+	Def, Class, Struct, Import, From, Require, Function, Const, Let, Var, Async,
+	Noexcept, Override, Final, Global, Using, Namespace,
+	// library names behind issues and suggestions
+	Eval, Std, Malloc, Free, Strcpy
+};
+
+Keyword classifyWord(const char* text, size_t length);
+
+// A token is a view into the source buffer. Tokens never span lines: strings
+// and comments that cross a newline are emitted as one piece per line.
+struct Token {
+	size_t offset;
+	uint32_t length;
+	uint32_t line;       // 0-based line number
+	TokenType type;
+	Keyword keyword;     // Keyword::None unless a recognized identifier
+};
+
+enum LineFlags : uint8_t {
+	LINE_NONBLANK = 1,    // has a non-whitespace byte
+	LINE_HAS_CODE = 2,    // has a code token (not only comments)
+	LINE_HAS_COMMENT = 4, // has a comment (or Python docstring) token
+	LINE_CONTINUED = 8    // starts inside a multi-line string/comment/directive
+};
+
+struct LineInfo {
+	size_t offset;        // offset of the first byte of the line
+	uint32_t indent;      // leading whitespace width (tab = 4)
+	uint32_t leading;     // leading whitespace bytes
+	uint8_t flags;
+};
+
+enum class LexMode : uint8_t {
+	Code,
+	LineComment,
+	BlockComment,
+	String,
+	TripleString,
+	Template,
+	Regex,
+	Directive
+};
+
+// Everything the lexer needs to resume scanning. Scanning can stop and resume
+// at any line start, and anywhere right after a whitespace byte.
+struct LexState {
+	LexMode mode = LexMode::Code;
+	char quote = 0;              // closing quote for string modes
+	bool docstring = false;      // triple-quoted string that opened its line
+	bool expectOperand = true;   // JavaScript: a '/' here starts a regex
+	bool regexClass = false;     // inside [...] of a regex literal
+	bool escapedNewline = false; // backslash right before the newline
+	bool atLineStart = true;
+	uint8_t lineFlags = 0;
+	uint32_t indent = 0;
+	uint32_t leading = 0;
+	uint32_t line = 0;
+	size_t lineOffset = 0;
+
+	// true if a scan resumed from either state yields the same tokens
+	bool sameCarry(const LexState& other) const {
+		return mode == other.mode && quote == other.quote &&
+			docstring == other.docstring && expectOperand == other.expectOperand;
+	}
+};
+
+struct TokenStream {
+	Language language = Language::Unknown;
+	std::vector<Token> tokens;
+	std::vector<LineInfo> lines;
+};
+
+class Lexer {
+public:
+	explicit Lexer(Language language);
+
+	// tokenize the whole buffer in a single pass
+	TokenStream tokenize(std::string_view code) const;
+	// tokenize() into out, reusing the capacity it already has
+	void tokenize(std::string_view code, TokenStream& out) const;
+
+	// Scan `size` bytes starting at absolute offset `base`, appending to `out`.
+	// The buffer must end at a line end, right after a whitespace byte, or at
+	// the end of input.
+	void scan(const char* data, size_t size, size_t base, LexState& state, TokenStream& out) const;
+
+	// flush the last (unterminated) line
+	void finish(LexState& state, TokenStream& out) const;
+
+	Language language() const { return language_; }
+
+private:
+	Language language_;
+	bool hashComments_;    // Python '#'
+	bool slashComments_;   // C family and JavaScript '//' and '/* */'
+	bool tripleQuotes_;    // Python
+	bool templates_;       // JavaScript '`'
+	bool regexLiterals_;   // JavaScript
+	bool directives_;      // C and C++ '#'
+};
+
+// helpers for reading tokens back out of the source buffer
+inline std::string tokenText(const char* base, const Token& token) {
+	return std::string(base + token.offset, token.length);
+}
+
+inline bool tokenIs(const char* base, const Token& token, const char* word) {
+	size_t i = 0;
+	for (; i < token.length; ++i) {
+		if (word[i] == '\0' || word[i] != base[token.offset + i]) {
+			return false;
+		}
+	}
+	return word[i] == '\0';
+}
+}  // namespace code_educator
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace code_educator {
+// Read-only memory mapping of a whole file. The contents are paged in on
+// demand and never copied; an empty file maps to an empty view.
+class MappedFile {
+public:
+	// throws std::runtime_error if the file cannot be opened or mapped
+	explicit MappedFile(const std::string& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	std::string_view view() const { return std::string_view(static_cast<const char*>(data_), size_); }
+	size_t size() const { return size_; }
+
+	// files at least this large are read ahead sequentially
+	static constexpr size_t SEQUENTIAL_THRESHOLD = 256 * 1024;
+
+private:
+	void release();
+
+	void* data_ = nullptr;
+	size_t size_ = 0;
+};
+}  // namespace code_educator
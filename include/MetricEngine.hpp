@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Lexer.hpp"
+#include "TokenCounter.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace code_educator {
+// language facts found while counting, used for issues and suggestions
+enum CodeFact : uint32_t {
+	FACT_EVAL_CALL = 1 << 0,            // eval(
+	FACT_EXCEPT = 1 << 1,               // except
+	FACT_BARE_EXCEPT = 1 << 2,          // except:
+	FACT_GLOBAL = 1 << 3,               // global x
+	FACT_USING_NAMESPACE_STD = 1 << 4,  // using namespace std;
+	FACT_NEW = 1 << 5,
+	FACT_DELETE = 1 << 6,
+	FACT_VAR = 1 << 7,                  // JavaScript var
+	FACT_LOOSE_EQUALITY = 1 << 8,       // == or !=
+	FACT_MALLOC = 1 << 9,
+	FACT_FREE = 1 << 10,
+	FACT_STRCPY = 1 << 11
+};
+
+struct MetricCounters {
+	int lineCount = 0;
+	int commentCount = 0;
+	int nestingLength = 0;
+	int cyclomaticComplexity = 1;  // start with 1 for the function itself
+	TokenCounter tokenFrequency;
+	uint32_t facts = 0;
+};
+
+// Engine state carried from one line to the next. Two engines with equal
+// carries produce the same counters for the same following lines.
+struct MetricCarry {
+	int depth = 0;                  // brace depth (C family and JavaScript)
+	int parenDepth = 0;             // bracket depth (Python line joining)
+	std::vector<uint32_t> indents;  // Python indentation stack
+	bool lineContinues = false;     // Python backslash continuation
+	bool lastWasBackslash = false;
+	Keyword prev = Keyword::None;   // last two significant tokens
+	Keyword prev2 = Keyword::None;
+
+	bool operator==(const MetricCarry& other) const {
+		return depth == other.depth && parenDepth == other.parenDepth &&
+			lineContinues == other.lineContinues && lastWasBackslash == other.lastWasBackslash &&
+			prev == other.prev && prev2 == other.prev2 && indents == other.indents;
+	}
+	bool operator!=(const MetricCarry& other) const {
+		return !(*this == other);
+	}
+};
+
+// Computes every line and token metric in one forward pass over a token
+// stream. consume() may be called repeatedly with consecutive pieces of the
+// same stream.
+class MetricEngine {
+public:
+	explicit MetricEngine(Language language);
+
+	void consume(const char* base, const TokenStream& stream);
+
+	// consume one complete line and its tokens
+	void consumeLine(const char* base, const LineInfo& line, const Token* tokens, size_t count);
+
+	const MetricCounters& counters() const { return counters_; }
+	MetricCounters& counters() { return counters_; }
+	void resetCounters();
+
+	// save and restore the state between lines (for incremental analysis)
+	const MetricCarry& carry() const { return carry_; }
+	void restore(const MetricCarry& carry) { carry_ = carry; }
+
+	// token frequency is the only per-identifier work; callers that keep
+	// their own counts can turn it off
+	void setTokenFrequency(bool enabled) { countTokens_ = enabled; }
+
+private:
+	void consumeToken(const char* base, const Token& token);
+	void endLine(const LineInfo& line, int parenAtStart);
+
+	Language language_;
+	MetricCounters counters_;
+	MetricCarry carry_;
+	bool countTokens_ = true;
+
+	uint32_t lineNo_ = 0;            // next line to consume
+	bool lineStarted_ = false;       // tokens of line lineNo_ already consumed
+	int lineStartParen_ = 0;
+};
+}  // namespace code_educator
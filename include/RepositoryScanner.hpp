@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Analyzer.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace code_educator {
+struct ScanOptions {
+	// file extensions to analyze, with the dot (empty: every known source type)
+	std::vector<std::string> extensions;
+	// glob patterns (fnmatch) matched against each entry name and its path
+	// relative to the root; matching directories are not descended into
+	std::vector<std::string> ignore = {".git", ".hg", ".svn", "node_modules", "__pycache__", "venv", ".venv"};
+	size_t worstCount = 10;                 // files kept in the worst-N list
+	size_t threads = 0;                     // 0: every worker of the shared pool
+	size_t maxFileBytes = 4 * 1024 * 1024;  // larger files are skipped
+	bool followSymlinks = false;
+	// identifiers tracked per language in an approximate token sketch
+	// (0: no sketch); memory stays fixed however many files are scanned
+	size_t tokenSketchCapacity = 0;
+};
+
+struct LanguageTotals {
+	size_t files = 0;
+	uint64_t bytes = 0;
+	uint64_t lines = 0;
+	uint64_t comments = 0;
+	uint64_t issues = 0;
+	double averageQuality = 0.0;
+};
+
+struct FileSummary {
+	std::string path;       // relative to the scanned root
+	std::string language;
+	int qualityScore = 0;
+	int lineCount = 0;
+	int cyclomaticComplexity = 0;
+	size_t issueCount = 0;
+};
+
+struct RepositoryReport {
+	std::string root;
+	size_t filesScanned = 0;
+	size_t filesSkipped = 0;  // too large
+	size_t filesFailed = 0;   // could not be read
+	uint64_t bytes = 0;
+	uint64_t totalLines = 0;
+	uint64_t totalIssues = 0;
+	double averageQuality = 0.0;
+	std::map<std::string, LanguageTotals> languages;
+	std::array<size_t, 10> qualityHistogram{};  // buckets of 10 points, 100 counts in the last
+	std::vector<FileSummary> worstFiles;        // lowest quality first
+	std::vector<std::string> errors;            // "path: reason", first few only
+	std::map<std::string, TokenSketch> tokenSketches;  // per language, with ScanOptions::tokenSketchCapacity
+	double seconds = 0.0;
+};
+
+// Walks a directory tree on the shared thread pool, analyzes every matching
+// file in place and reduces the per-file results into one report.
+class RepositoryScanner {
+public:
+	explicit RepositoryScanner(const Analyzer& analyzer, ScanOptions options = ScanOptions());
+
+	// throws std::runtime_error if root is not a readable directory
+	RepositoryReport scan(const std::string& root) const;
+
+	const ScanOptions& options() const { return options_; }
+
+private:
+	bool ignored(const std::string& name, const std::string& relative) const;
+	bool wanted(const std::string& name) const;
+
+	const Analyzer& analyzer_;
+	ScanOptions options_;
+};
+}  // namespace code_educator
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "ContentHash.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace code_educator {
+struct AnalysisReport;
+
+// cached results are looked up by input hash and analyzer version, so a new
+// analyzer never serves results computed by an older one
+struct CacheKey {
+	Hash128 hash;
+	uint32_t version = 0;
+
+	bool operator==(const CacheKey& other) const {
+		return hash == other.hash && version == other.version;
+	}
+};
+
+struct CacheKeyHasher {
+	size_t operator()(const CacheKey& key) const {
+		return Hash128Hasher()(key.hash) ^ key.version;
+	}
+};
+
+struct CacheStats {
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t insertions = 0;
+	uint64_t evictions = 0;
+	size_t entries = 0;
+	size_t bytes = 0;          // approximate memory held by cached reports
+	size_t capacityBytes = 0;
+};
+
+// Thread-safe LRU cache of analysis reports, bounded by approximate memory.
+// Keys are spread over independently locked shards; each shard evicts its
+// least recently used entries once it goes over its share of the budget.
+class ResultCache {
+public:
+	explicit ResultCache(size_t maxBytes = 64 * 1024 * 1024, size_t shards = 16);
+
+	ResultCache(const ResultCache&) = delete;
+	ResultCache& operator=(const ResultCache&) = delete;
+
+	// nullptr on a miss; a hit becomes the most recently used entry
+	std::shared_ptr<const AnalysisReport> find(const CacheKey& key);
+	void insert(const CacheKey& key, std::shared_ptr<const AnalysisReport> report);
+
+	void clear();
+	CacheStats stats() const;
+	size_t capacity() const { return maxBytes_; }
+
+private:
+	struct Entry {
+		CacheKey key;
+		std::shared_ptr<const AnalysisReport> report;
+		size_t bytes;
+	};
+
+	struct Shard {
+		std::mutex mutex;
+		std::list<Entry> order;  // front = most recently used
+		std::unordered_map<CacheKey, std::list<Entry>::iterator, CacheKeyHasher> index;
+		size_t bytes = 0;
+	};
+
+	Shard& shardFor(const CacheKey& key);
+
+	size_t maxBytes_;
+	size_t shardBytes_;
+	std::vector<std::unique_ptr<Shard>> shards_;
+	std::atomic<uint64_t> hits_{0};
+	std::atomic<uint64_t> misses_{0};
+	std::atomic<uint64_t> insertions_{0};
+	std::atomic<uint64_t> evictions_{0};
+};
+
+// rough heap footprint of a report, used to charge cache entries
+size_t approximateSize(const AnalysisReport& report);
+}  // namespace code_educator
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Analyzer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace code_educator {
+// Minimal streaming JSON writer appending UTF-8 to a caller-owned buffer.
+// Commas are placed automatically; keys and values must alternate inside
+// objects. Strings are escaped as JSON requires and invalid UTF-8 is
+// replaced with U+FFFD, so any source text makes a valid document.
+class JsonWriter {
+public:
+	explicit JsonWriter(std::string& out) : out_(out) {}
+
+	void beginObject();
+	void endObject();
+	void beginArray();
+	void endArray();
+	void key(std::string_view name);
+
+	void value(std::string_view text);
+	void value(const char* text) { value(std::string_view(text)); }
+	void value(int64_t number);
+	void value(int number) { value(static_cast<int64_t>(number)); }
+	void value(size_t number);
+	void value(double number);
+	void value(bool flag);
+	void null();
+
+private:
+	void separate();
+	void open(char bracket);
+	void close(char bracket);
+	void string(std::string_view text);
+
+	std::string& out_;
+	uint64_t nonEmpty_ = 0;  // bit per nesting level: something was written there
+	uint32_t depth_ = 0;
+	bool afterKey_ = false;
+};
+
+// What writeReportJson() includes besides the fields of every response.
+struct ReportJsonOptions {
+	bool tokenFrequency = false;  // "token_frequency" (the counts the report kept)
+	bool cached = false;          // "cached"
+};
+
+// Append a report as the JSON object the /analyze endpoint returns: the
+// structure, metrics, issues, suggestions, quality score, metadata and the
+// truncation flags, with the same keys as the Python service.
+void writeReportJson(const AnalysisReport& report, std::string& out,
+	const ReportJsonOptions& options = ReportJsonOptions());
+}  // namespace code_educator
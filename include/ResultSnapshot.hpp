@@ -0,0 +1,127 @@
+#pragma once
+
+#include "Analyzer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace code_educator {
+// Compact binary form of analysis results, for caching, IPC and storage.
+//
+// Layout (little-endian): a fixed header with the scalar fields and the
+// offset of every section, the string table (u32 offsets, then the bytes,
+// every distinct string stored once, string 0 is empty), then the sections:
+// lists as a varint count followed by varint string indices, maps as a
+// varint count followed by index pairs, token counts as index and zigzag
+// varint count. A snapshot holds a structure, a result, or both (a report).
+//
+// SnapshotView reads a snapshot in place, e.g. over a mapped file: it checks
+// the whole buffer once on construction, then every accessor reads straight
+// from it without copying or allocating.
+constexpr uint32_t SNAPSHOT_FORMAT = 1;
+
+std::string writeSnapshot(const AnalysisReport& report);
+std::string writeSnapshot(const CodeStructure& structure);
+std::string writeSnapshot(const AnalysisResult& result);
+
+class SnapshotView {
+public:
+	// strings of one list section, decoded while iterating
+	class Strings {
+	public:
+		class iterator {
+		public:
+			std::string_view operator*() const;
+			iterator& operator++();
+			bool operator!=(const iterator& other) const { return left_ != other.left_; }
+
+		private:
+			friend class Strings;
+			iterator(const SnapshotView* view, size_t at, size_t left) : view_(view), at_(at), left_(left) {}
+			const SnapshotView* view_;
+			size_t at_;
+			size_t left_;
+		};
+
+		size_t size() const { return count_; }
+		bool empty() const { return count_ == 0; }
+		iterator begin() const { return iterator(view_, first_, count_); }
+		iterator end() const { return iterator(view_, 0, 0); }
+		std::vector<std::string> toVector() const;
+
+	private:
+		friend class SnapshotView;
+		Strings(const SnapshotView* view, size_t first, size_t count) : view_(view), first_(first), count_(count) {}
+		const SnapshotView* view_;
+		size_t first_;
+		size_t count_;
+	};
+
+	// throws std::runtime_error if data is not a valid snapshot; data must
+	// outlive the view
+	explicit SnapshotView(std::string_view data);
+
+	bool hasStructure() const;
+	bool hasResult() const;
+	uint32_t analyzerVersion() const;
+
+	// structure
+	std::string_view language() const;
+	int complexity() const;
+	Strings imports() const;
+	Strings functions() const;
+	Strings classes() const;
+	// key, value, key, value, ...
+	Strings structureMetadata() const;
+
+	// result
+	int lineCount() const;
+	int commentCount() const;
+	double commentRatio() const;
+	int nestingLength() const;
+	int cyclomaticComplexity() const;
+	Strings potentialIssues() const;
+	Strings suggestions() const;
+	Strings metadata() const;
+	bool truncated() const;
+	std::string_view truncatedBy() const;
+	uint64_t bytesAnalyzed() const;
+	int qualityScore() const;
+
+	// identifier counts, in key order; fn(std::string_view key, int count)
+	template <typename Fn>
+	void forEachToken(Fn fn) const {
+		size_t at = sectionStart(TOKEN_SECTION);
+		size_t count = varint(at);
+		for (size_t i = 0; i < count; ++i) {
+			std::string_view key = string(static_cast<uint32_t>(varint(at)));
+			uint64_t raw = varint(at);
+			fn(key, static_cast<int>(static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1)));
+		}
+	}
+	size_t tokenCount() const;
+
+	// copies back into the live structs
+	CodeStructure structure() const;
+	AnalysisResult result() const;
+	AnalysisReport report() const;
+
+	std::string_view data() const { return data_; }
+
+private:
+	static constexpr size_t TOKEN_SECTION = 7;
+
+	uint32_t u32(size_t at) const;
+	size_t sectionStart(size_t section) const;
+	Strings list(size_t section, size_t perItem = 1) const;
+	std::string_view string(uint32_t index) const;
+	// decode the varint at `at` and move past it (checked on construction)
+	uint64_t varint(size_t& at) const;
+	void validate() const;
+
+	std::string_view data_;
+	uint32_t stringCount_ = 0;
+};
+}  // namespace code_educator
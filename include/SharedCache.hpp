@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ResultCache.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace code_educator {
+struct AnalysisReport;
+
+struct SharedCacheStats {
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t insertions = 0;
+	uint64_t contended = 0;     // inserts dropped because other writers held every candidate slot
+	uint64_t publishedTotal = 0; // inserts by every attached process
+	size_t slots = 0;
+	size_t arenaBytes = 0;
+	size_t arenaWritten = 0;    // bytes ever written to the arena (it wraps around)
+};
+
+// Analysis reports shared by every process attached to one POSIX shared
+// memory segment, e.g. the workers of one server.
+//
+// The segment holds a table of fixed-size slots and an arena the reports
+// are written to (as result snapshots) in a ring: space is reserved with a
+// compare-and-swap on the shared write position, so writers never wait for
+// each other, and old reports are overwritten as it wraps. Each slot points
+// into the arena and is guarded by a seqlock: a writer takes it by making
+// its sequence odd, readers retry or skip while it is odd or changed. A
+// reader checks after copying that the ring has not lapped the report and
+// that its checksum matches, so an overwritten report is just a miss.
+//
+// The first process to attach creates and sizes the segment; later ones
+// use its geometry. It lives until remove() even when no process has it
+// attached.
+class SharedCache {
+public:
+	// throws std::runtime_error if the segment cannot be created or attached;
+	// slots = 0 picks one slot per 2 KiB of arena
+	explicit SharedCache(const std::string& name, size_t arenaBytes = 64 * 1024 * 1024, size_t slots = 0);
+	~SharedCache();
+
+	SharedCache(const SharedCache&) = delete;
+	SharedCache& operator=(const SharedCache&) = delete;
+
+	// nullptr on a miss
+	std::shared_ptr<AnalysisReport> find(const CacheKey& key);
+	// publish a report to every attached process; false if it was dropped
+	// (too large, or every candidate slot was being written)
+	bool insert(const CacheKey& key, const AnalysisReport& report);
+
+	SharedCacheStats stats() const;
+	const std::string& name() const { return name_; }
+	size_t capacity() const { return arenaBytes_; }
+
+	// unlink a segment; attached processes keep theirs until they detach
+	static bool remove(const std::string& name);
+
+private:
+	// first of the slots a key may live in
+	size_t bucket(const CacheKey& key) const;
+
+	std::string name_;
+	void* data_ = nullptr;
+	size_t bytes_ = 0;
+	size_t slotCount_ = 0;
+	size_t arenaBytes_ = 0;
+
+	std::atomic<uint64_t> hits_{0};
+	std::atomic<uint64_t> misses_{0};
+	std::atomic<uint64_t> insertions_{0};
+	std::atomic<uint64_t> contended_{0};
+};
+}  // namespace code_educator
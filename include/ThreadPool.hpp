@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace code_educator {
+// Work-stealing thread pool
+// Every worker owns a deque: it pops its own work from the back and steals
+// from the front of the other deques when it runs dry.
+class ThreadPool {
+public:
+	explicit ThreadPool(size_t threads = 0);  // 0 = one per hardware thread
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void submit(std::function<void()> task);
+
+	// Run fn(i) for every i in [0, count) and wait for all of them. The caller
+	// takes part in the work; at most maxWorkers threads run at once (0 = all).
+	// The first exception thrown by fn is rethrown here.
+	void parallelFor(size_t count, const std::function<void(size_t)>& fn, size_t maxWorkers = 0);
+
+	size_t size() const { return workers_.size(); }
+
+	// process-wide pool shared by the analyzer and the bindings
+	static ThreadPool& shared();
+
+private:
+	struct Queue {
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	void workerLoop(size_t index);
+	bool popTask(size_t index, std::function<void()>& task);
+
+	std::vector<std::unique_ptr<Queue>> queues_;
+	std::vector<std::thread> workers_;
+	std::mutex sleepMutex_;
+	std::condition_variable wake_;
+	std::atomic<size_t> pending_{0};
+	std::atomic<size_t> nextQueue_{0};
+	std::atomic<bool> stopping_{false};
+};
+}  // namespace code_educator
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace code_educator {
+// Append-only storage for interned strings. Strings are packed into large
+// blocks, so storing one costs no allocation of its own; views returned by
+// store() stay valid until clear() or destruction.
+class StringArena {
+public:
+	explicit StringArena(size_t blockBytes = 16 * 1024);
+
+	StringArena(const StringArena&) = delete;
+	StringArena& operator=(const StringArena&) = delete;
+	StringArena(StringArena&& other) noexcept;
+	StringArena& operator=(StringArena&& other) noexcept;
+
+	std::string_view store(std::string_view text);
+	void clear();
+	// forget the stored strings but keep the first block for reuse
+	void reset();
+
+	// bytes held by the blocks
+	size_t capacity() const { return capacity_; }
+
+private:
+	std::vector<std::unique_ptr<char[]>> blocks_;
+	size_t blockBytes_;
+	char* cursor_ = nullptr;
+	size_t left_ = 0;
+	size_t capacity_ = 0;
+	size_t firstBytes_ = 0;  // size of blocks_[0]
+};
+
+// Identifier counts in an open-addressing hash table (linear probing) whose
+// keys are interned in a StringArena. Counting a known identifier costs one
+// hash and one compare and never allocates.
+class TokenCounter {
+public:
+	struct Entry {
+		std::string_view key;
+		int count;
+	};
+
+	TokenCounter() = default;
+	TokenCounter(const TokenCounter& other);
+	TokenCounter& operator=(const TokenCounter& other);
+	TokenCounter(TokenCounter&& other) noexcept;
+	TokenCounter& operator=(TokenCounter&& other) noexcept;
+
+	// add delta to the count of key (counts may drop back to zero)
+	void add(std::string_view key, int delta = 1);
+	int count(std::string_view key) const;
+
+	// keys with a non-zero count
+	size_t size() const { return live_; }
+	bool empty() const { return live_ == 0; }
+	void clear();
+	// clear() but keep the table and the first arena block, for a counter
+	// reused across analyses
+	void reset();
+
+	// every key with a non-zero count, in table order
+	std::vector<Entry> entries() const;
+
+	// the k most frequent keys, highest count first, ties by key (k = 0: all)
+	std::vector<Entry> top(size_t k) const;
+
+	// copy the counts (or only the k most frequent) into out
+	void exportTo(std::map<std::string, int>& out, size_t k = 0) const;
+
+	// approximate bytes held, for cache accounting
+	size_t memoryUsage() const;
+
+private:
+	struct Slot {
+		const char* data = nullptr;  // nullptr: empty slot
+		uint32_t length = 0;
+		uint32_t hash = 0;
+		int count = 0;
+	};
+
+	Slot& findSlot(std::string_view key, uint32_t hash);
+	void grow();
+
+	std::vector<Slot> slots_;  // power-of-two size
+	size_t used_ = 0;          // occupied slots (zero counts included)
+	size_t live_ = 0;          // slots with a non-zero count
+	StringArena arena_;
+};
+}  // namespace code_educator
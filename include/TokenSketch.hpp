@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace code_educator {
+// Count-min sketch: approximate counts of an unbounded key stream in a fixed
+// grid of depth rows by width counters. An estimate never undercounts; it
+// overcounts by more than e/width of the total with probability e^-depth.
+// Sketches of the same shape merge by adding their counters.
+class CountMinSketch {
+public:
+	// width is rounded up to a power of two
+	explicit CountMinSketch(size_t width = 2048, size_t depth = 4);
+
+	// hash: 64-bit hash of the key (the rows use derived hashes)
+	void add(uint64_t hash, uint64_t delta = 1);
+	uint64_t estimate(uint64_t hash) const;
+
+	// throws std::invalid_argument if the shapes differ
+	void merge(const CountMinSketch& other);
+	void clear();
+
+	size_t width() const { return width_; }
+	size_t depth() const { return depth_; }
+	uint64_t total() const { return total_; }
+
+	// row-major counters, for serialization
+	const std::vector<uint64_t>& cells() const { return cells_; }
+	std::vector<uint64_t>& cells() { return cells_; }
+	void setTotal(uint64_t total) { total_ = total; }
+
+private:
+	size_t cell(uint64_t hash, size_t row) const;
+
+	size_t width_;
+	size_t depth_;
+	uint64_t total_ = 0;
+	std::vector<uint64_t> cells_;
+};
+
+// Space-saving summary: the heavy hitters of a key stream in at most
+// capacity monitored counters. A key not monitored takes over the counter
+// with the smallest count, so a count overstates its key by at most error;
+// every key more frequent than total/capacity is monitored.
+class SpaceSaving {
+public:
+	struct Entry {
+		std::string key;
+		uint64_t count = 0;  // upper bound of the key's count
+		uint64_t error = 0;  // count - error is a lower bound
+	};
+
+	explicit SpaceSaving(size_t capacity = 256);
+	SpaceSaving(const SpaceSaving& other);
+	SpaceSaving& operator=(const SpaceSaving& other);
+	SpaceSaving(SpaceSaving&&) = default;
+	SpaceSaving& operator=(SpaceSaving&&) = default;
+
+	void add(std::string_view key, uint64_t delta = 1);
+
+	// add with a known upper bound of the key's count (delta included), e.g.
+	// from a count-min sketch: a newcomer whose bound does not exceed the
+	// smallest counter cannot be a heavy hitter and leaves the summary alone
+	void add(std::string_view key, uint64_t delta, uint64_t bound);
+
+	// monitored entry of key, or nullptr
+	const Entry* find(std::string_view key) const;
+
+	// merge of two summaries (Agarwal et al., "Mergeable Summaries")
+	void merge(const SpaceSaving& other);
+	void clear();
+
+	// the k largest counts, largest first, ties by key (k = 0: all)
+	std::vector<Entry> top(size_t k = 0) const;
+
+	size_t capacity() const { return capacity_; }
+	size_t size() const { return entries_.size(); }
+	const std::vector<Entry>& entries() const { return entries_; }
+
+	// rebuild from entries (deserialization); extra entries are dropped
+	void assign(std::vector<Entry> entries);
+
+private:
+	bool full() const { return entries_.size() >= capacity_; }
+	uint64_t minCount() const;
+	void siftUp(size_t position);
+	void siftDown(size_t position);
+	void swapHeap(size_t a, size_t b);
+	void rebuild();
+
+	size_t capacity_;
+	std::vector<Entry> entries_;
+	std::vector<uint32_t> heap_;      // entry indices, min-heap by count
+	std::vector<uint32_t> position_;  // heap position of each entry
+	std::unordered_map<std::string_view, uint32_t> index_;  // views into entries_
+};
+
+// Fixed-memory identifier statistics for corpus-scale scans: a count-min
+// sketch estimates the count of any token and a space-saving summary keeps
+// the most frequent ones. Sketches of the same shape merge with the error
+// bounds of one sketch fed both inputs, so they can be built per thread or
+// per run and combined, and they serialize to a compact binary form.
+class TokenSketch {
+public:
+	struct Entry {
+		std::string key;
+		uint64_t count = 0;       // upper bound (the tighter of both structures)
+		uint64_t lowerBound = 0;  // guaranteed occurrences
+	};
+
+	explicit TokenSketch(size_t topCapacity = 256, size_t width = 2048, size_t depth = 4);
+
+	void add(std::string_view token, uint64_t delta = 1);
+
+	// upper bound of the count of token
+	uint64_t estimate(std::string_view token) const;
+
+	// the k most frequent tokens (k = 0: every monitored token)
+	std::vector<Entry> top(size_t k = 0) const;
+
+	// throws std::invalid_argument if the shapes differ
+	void merge(const TokenSketch& other);
+	void clear();
+
+	uint64_t total() const { return counts_.total(); }
+	size_t topCapacity() const { return heavy_.capacity(); }
+	size_t width() const { return counts_.width(); }
+	size_t depth() const { return counts_.depth(); }
+	size_t memoryUsage() const;
+
+	// little-endian binary form; deserialize throws std::runtime_error on
+	// malformed input
+	std::string serialize() const;
+	static TokenSketch deserialize(std::string_view data);
+
+	// throw std::runtime_error on I/O errors
+	void save(const std::string& path) const;
+	static TokenSketch load(const std::string& path);
+
+private:
+	CountMinSketch counts_;
+	SpaceSaving heavy_;
+};
+}  // namespace code_educator
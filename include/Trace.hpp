@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace code_educator {
+// one finished stage of one call
+struct TraceSpan {
+	const char* name = "";
+	uint64_t startNs = 0;     // steady clock
+	uint64_t durationNs = 0;
+	uint64_t bytes = 0;
+	uint32_t threadId = 0;    // small per-process thread number
+	uint32_t depth = 0;       // 0 for an outermost span
+};
+
+// spans kept per thread; older ones are overwritten
+constexpr size_t TRACE_RING_SPANS = 8192;
+
+// Tracing is opt-in: on for every thread with setTracingEnabled(), or for one
+// thread while a TraceCapture is alive. Spans go to a per-thread ring buffer
+// written without locks; readers copy it and drop what was overwritten while
+// they read.
+void setTracingEnabled(bool enabled);
+bool tracingEnabled();
+// this thread records spans now
+bool tracingActive();
+
+uint64_t traceClockNs();
+uint32_t traceThreadId();
+
+// spans started at or after sinceNs, of one thread (0: every thread), by start
+std::vector<TraceSpan> traceSpans(uint64_t sinceNs = 0, uint32_t threadId = 0);
+// hide every span recorded so far
+void clearTrace();
+
+// Chrome / Perfetto trace event JSON ("X" complete events)
+std::string traceToChromeJson(const std::vector<TraceSpan>& spans);
+
+// span bookkeeping for StageTimer: enter returns the depth to pass to leave
+uint32_t traceEnter();
+void traceLeave(const char* name, uint64_t startNs, uint64_t durationNs, uint64_t bytes, uint32_t depth);
+
+// Traces the current thread from construction until stop() (or destruction)
+// and hands back only the spans recorded meanwhile, so concurrent requests
+// on other threads stay out of it.
+class TraceCapture {
+public:
+	TraceCapture();
+	~TraceCapture();
+
+	TraceCapture(const TraceCapture&) = delete;
+	TraceCapture& operator=(const TraceCapture&) = delete;
+
+	void stop();
+	std::vector<TraceSpan> spans() const;
+	std::string chromeJson() const { return traceToChromeJson(spans()); }
+
+private:
+	uint64_t startNs_;
+	uint64_t endNs_ = 0;
+	uint32_t threadId_;
+	bool stopped_ = false;
+};
+}  // namespace code_educator
@@ -0,0 +1,184 @@
+# test/test_core.py
+"""
+C++ 코어 모듈 회귀 테스트 (스냅샷 직렬화, 디스크 캐시 손상 처리, JSON 응답 일치)
+
+빌드 디렉터리를 PYTHONPATH 에 두고 실행 (ctest 가 설정):
+    PYTHONPATH=build python3 test/test_core.py
+"""
+import json
+import os
+import sys
+import tempfile
+import unittest
+
+import code_educator_core as ce
+
+TEST_DIR = os.path.dirname(os.path.abspath(__file__))
+ROOT_DIR = os.path.dirname(TEST_DIR)
+SAMPLES = ("test.py", "test.c", "test.cpp", "test.js")
+
+# 스냅샷 헤더의 필드 위치 (ResultSnapshot.cpp 와 일치)
+AT_FORMAT = 4
+AT_STRING_COUNT = 64
+AT_STRING_TABLE = 68
+AT_SECTIONS = 72
+AT_TOTAL = 116
+
+try:
+    import requests  # noqa: F401 (서비스 모듈이 AI 클라이언트용으로 가져옴)
+    HAS_REQUESTS = True
+except ImportError:
+    HAS_REQUESTS = False
+
+
+def read_sample(name):
+    with open(os.path.join(TEST_DIR, name), encoding="utf-8") as f:
+        return f.read()
+
+
+def report_fields(report):
+    """AnalysisReport 를 비교 가능한 딕셔너리로 변환"""
+    structure = report.structure
+    result = report.result
+    return {
+        "language": structure.language,
+        "complexity": structure.complexity,
+        "imports": list(structure.imports),
+        "functions": list(structure.functions),
+        "classes": list(structure.classes),
+        "structure_metadata": dict(structure.metadata),
+        "line_count": result.line_count,
+        "comment_count": result.comment_count,
+        "comment_ratio": result.comment_ratio,
+        "nesting_depth": result.nesting_depth,
+        "cyclomatic_complexity": result.cyclomatic_complexity,
+        "potential_issues": list(result.potential_issues),
+        "suggestions": list(result.suggestions),
+        "metadata": dict(result.metadata),
+        "token_frequency": dict(result.token_frequency),
+        "truncated": result.truncated,
+        "truncated_by": result.truncated_by,
+        "bytes_analyzed": result.bytes_analyzed,
+        "quality_score": report.quality_score,
+    }
+
+
+def patch_u32(data, at, value):
+    out = bytearray(data)
+    out[at:at + 4] = value.to_bytes(4, "little")
+    return bytes(out)
+
+
+class SnapshotTest(unittest.TestCase):
+    def setUp(self):
+        self.analyzer = ce.Analyzer()
+        self.reports = {name: self.analyzer.report(read_sample(name)) for name in SAMPLES}
+
+    def test_round_trip(self):
+        for name, report in self.reports.items():
+            with self.subTest(sample=name):
+                data = ce.write_snapshot(report)
+                restored = ce.Snapshot(data).report()
+                self.assertEqual(report_fields(restored), report_fields(report))
+                # 다시 직렬화해도 같은 바이트
+                self.assertEqual(ce.write_snapshot(restored), data)
+
+    def test_round_trip_from_file(self):
+        report = self.reports["test.cpp"]
+        data = ce.write_snapshot(report)
+        with tempfile.TemporaryDirectory() as directory:
+            path = os.path.join(directory, "report.snap")
+            with open(path, "wb") as f:
+                f.write(data)
+            snapshot = ce.Snapshot.load(path)
+            self.assertEqual(len(snapshot), len(data))
+            self.assertEqual(report_fields(snapshot.report()), report_fields(report))
+
+    def test_truncated_snapshot_is_rejected(self):
+        data = ce.write_snapshot(self.reports["test.py"])
+        for length in range(len(data)):
+            with self.assertRaises(RuntimeError, msg=f"length {length}"):
+                ce.Snapshot(data[:length])
+
+    def test_corrupted_header_is_rejected(self):
+        data = ce.write_snapshot(self.reports["test.js"])
+        corrupted = {
+            "magic": b"XXXX" + data[4:],
+            "format": patch_u32(data, AT_FORMAT, 99),
+            "total": patch_u32(data, AT_TOTAL, len(data) + 1),
+            "string count": patch_u32(data, AT_STRING_COUNT, 0),
+            "string table": patch_u32(data, AT_STRING_TABLE, len(data)),
+            "section": patch_u32(data, AT_SECTIONS, len(data)),
+        }
+        for field, bad in corrupted.items():
+            with self.subTest(field=field):
+                with self.assertRaises(RuntimeError):
+                    ce.Snapshot(bad)
+
+    def test_flipped_bytes_never_read_out_of_bounds(self):
+        # 문자열 바이트는 체크섬이 없으므로 바뀐 값 자체는 허용, 대신 모든 오프셋/인덱스 검사를 통과한 경우에만 읽힘
+        data = ce.write_snapshot(self.reports["test.c"])
+        for at in range(len(data)):
+            bad = bytearray(data)
+            bad[at] ^= 0xFF
+            try:
+                snapshot = ce.Snapshot(bytes(bad))
+            except RuntimeError:
+                continue
+            try:
+                report_fields(snapshot.report())
+            except UnicodeDecodeError:
+                pass  # 문자열 바이트가 UTF-8 이 아니게 된 경우
+
+
+class DiskCacheTest(unittest.TestCase):
+    def test_corrupted_entry_is_a_miss(self):
+        code = read_sample("test.py")
+        with tempfile.TemporaryDirectory() as directory:
+            writer = ce.Analyzer()
+            writer.set_disk_cache(ce.DiskCache(directory))
+            expected = report_fields(writer.report(code))
+            self.assertEqual(writer.disk_cache.stats()["insertions"], 1)
+
+            # 다른 프로세스처럼 새로 연 캐시에서 조회
+            reader = ce.Analyzer()
+            reader.set_disk_cache(ce.DiskCache(directory))
+            self.assertEqual(report_fields(reader.report(code)), expected)
+            self.assertEqual(reader.disk_cache.stats()["hits"], 1)
+
+            # 로그의 마지막 레코드 (스냅샷 본문) 를 손상
+            logs = [name for name in os.listdir(directory) if name.startswith("log.")]
+            self.assertEqual(len(logs), 1)
+            with open(os.path.join(directory, logs[0]), "r+b") as f:
+                f.seek(-8, os.SEEK_END)
+                tail = f.read(8)
+                f.seek(-8, os.SEEK_END)
+                f.write(bytes(b ^ 0xFF for b in tail))
+
+            damaged = ce.Analyzer()
+            damaged.set_disk_cache(ce.DiskCache(directory))
+            self.assertEqual(report_fields(damaged.report(code)), expected)
+            stats = damaged.disk_cache.stats()
+            self.assertEqual(stats["hits"], 0)
+            self.assertEqual(stats["misses"], 1)
+
+
+@unittest.skipUnless(HAS_REQUESTS, "requests 가 없어 서비스 모듈을 가져올 수 없음")
+class AnalyzeJsonTest(unittest.TestCase):
+    def setUp(self):
+        sys.path.insert(0, ROOT_DIR)
+        from backend.srcs.python.services.code_service import CodeAnalysisService
+        self.service = CodeAnalysisService()
+
+    def test_matches_analyze_code(self):
+        for name in SAMPLES:
+            code = read_sample(name)
+            for top_tokens in (None, 0, 5):
+                with self.subTest(sample=name, top_tokens=top_tokens):
+                    data = self.service.analyze_code_json(code, top_tokens)
+                    expected = self.service.analyze_code(code, top_tokens=top_tokens)
+                    self.assertEqual(data, json.dumps(expected, separators=(",", ":"), ensure_ascii=False).encode())
+
+
+if __name__ == "__main__":
+    unittest.main()